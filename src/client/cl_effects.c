@@ -41,8 +41,6 @@ static vec3_t avelocities[NUMVERTEXNORMALS];
 extern struct model_s *cl_mod_smoke;
 extern struct model_s *cl_mod_flash;
 
-extern cparticle_t *active_particles, *free_particles;
-
 void CL_AddMuzzleFlash(void)
 {
   vec3_t fv, rv;
@@ -341,15 +339,11 @@ void CL_TeleporterParticles(entity_state_t *ent)
   time = (float) cl.time;
 
   for (i = 0; i < 8; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = time;
     p->color = 0xdb;
 
@@ -378,15 +372,11 @@ void CL_LogoutEffect(vec3_t org, int type)
   time = (float) cl.time;
 
   for (i = 0; i < 500; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = time;
 
     if (type == MZ_LOGIN) {
@@ -422,15 +412,11 @@ void CL_ItemRespawnParticles(vec3_t org)
   time = (float) cl.time;
 
   for (i = 0; i < 64; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = time;
     p->color = 0xd4 + (randk() & 3);
     p->org[0] = org[0] + crandk() * 8;
@@ -458,15 +444,11 @@ void CL_ExplosionParticles(vec3_t org)
   time = (float) cl.time;
 
   for (i = 0; i < 256; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = time;
     p->color = 0xe0 + (randk() & 7);
 
@@ -494,15 +476,11 @@ void CL_BigTeleportParticles(vec3_t org)
   static int colortable[4] = {2 * 8, 13 * 8, 21 * 8, 18 * 8};
 
   for (i = 0; i < 4096; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = time;
     p->color = colortable[randk() & 3];
 
@@ -541,15 +519,11 @@ void CL_BlasterParticles(vec3_t org, vec3_t dir)
   count = 40;
 
   for (i = 0; i < count; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = time;
     p->color = 0xe0 + (randk() & 7);
     d = randk() & 15;
@@ -589,14 +563,10 @@ void CL_BlasterTrail(vec3_t start, vec3_t end)
   while (len > 0) {
     len -= dec;
 
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
-
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
     VectorClear(p->accel);
 
     p->time = time;
@@ -637,14 +607,10 @@ void CL_FlagTrail(vec3_t start, vec3_t end, int color)
   while (len > 0) {
     len -= dec;
 
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
-
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
     VectorClear(p->accel);
 
     p->time = time;
@@ -698,16 +664,13 @@ void CL_DiminishingTrail(vec3_t start, vec3_t end, centity_t *old, int flags)
   while (len > 0) {
     len -= dec;
 
-    if (!free_particles) {
-      return;
-    }
-
     /* drop less particles as it flies */
     if ((randk() & 1023) < old->trailcount) {
-      p = free_particles;
-      free_particles = p->next;
-      p->next = active_particles;
-      active_particles = p;
+      p = CL_AllocParticle();
+      if (!p) {
+        return;
+      }
+
       VectorClear(p->accel);
 
       p->time = time;
@@ -802,15 +765,11 @@ void CL_RocketTrail(vec3_t start, vec3_t end, centity_t *old)
   while (len > 0) {
     len -= dec;
 
-    if (!free_particles) {
-      return;
-    }
-
     if ((randk() & 7) == 0) {
-      p = free_particles;
-      free_particles = p->next;
-      p->next = active_particles;
-      active_particles = p;
+      p = CL_AllocParticle();
+      if (!p) {
+        return;
+      }
 
       VectorClear(p->accel);
       p->time = time;
@@ -855,15 +814,11 @@ void CL_RailTrail(vec3_t start, vec3_t end)
   MakeNormalVectors(vec, right, up);
 
   for (i = 0; i < len; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = time;
     VectorClear(p->accel);
 
@@ -893,15 +848,11 @@ void CL_RailTrail(vec3_t start, vec3_t end)
   while (len > 0) {
     len -= dec;
 
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = time;
     VectorClear(p->accel);
 
@@ -942,14 +893,10 @@ void CL_IonripperTrail(vec3_t start, vec3_t ent)
   while (len > 0) {
     len -= dec;
 
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
-
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
     VectorClear(p->accel);
 
     p->time = time;
@@ -997,15 +944,11 @@ void CL_BubbleTrail(vec3_t start, vec3_t end)
   VectorScale(vec, dec, vec);
 
   for (i = 0; i < len; i += 32) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     VectorClear(p->accel);
     p->time = time;
 
@@ -1063,15 +1006,11 @@ void CL_FlyParticles(vec3_t origin, int count)
     forward[1] = cp * sy;
     forward[2] = -sp;
 
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = time;
 
     dist = (float) sin(ltime + i) * 64;
@@ -1147,14 +1086,10 @@ void CL_TrapParticles(entity_t *ent)
   while (len > 0) {
     len -= dec;
 
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
-
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
     VectorClear(p->accel);
 
     p->time = time;
@@ -1187,15 +1122,11 @@ void CL_TrapParticles(entity_t *ent)
     for (i = -2; i <= 2; i += 4) {
       for (j = -2; j <= 2; j += 4) {
         for (k = -2; k <= 4; k += 4) {
-          if (!free_particles) {
+          p = CL_AllocParticle();
+          if (!p) {
             return;
           }
 
-          p = free_particles;
-          free_particles = p->next;
-          p->next = active_particles;
-          active_particles = p;
-
           p->time = time;
           p->color = 0xe0 + (randk() & 3);
           p->alpha = 1.0;
@@ -1234,15 +1165,11 @@ void CL_TeleportParticles(vec3_t org)
   for (i = -16; i <= 16; i += 4) {
     for (j = -16; j <= 16; j += 4) {
       for (k = -16; k <= 32; k += 4) {
-        if (!free_particles) {
+        p = CL_AllocParticle();
+        if (!p) {
           return;
         }
 
-        p = free_particles;
-        free_particles = p->next;
-        p->next = active_particles;
-        active_particles = p;
-
         p->time = time;
         p->color = 7 + (randk() & 7);
         p->alpha = 1.0;
@@ -1361,15 +1288,11 @@ void CL_DebugTrail(vec3_t start, vec3_t end)
   while (len > 0) {
     len -= dec;
 
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = (float) cl.time;
     VectorClear(p->accel);
     VectorClear(p->vel);
@@ -1400,14 +1323,10 @@ void CL_SmokeTrail(vec3_t start, vec3_t end, int colorStart, int colorRun, int s
   while (len > 0) {
     len -= spacing;
 
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
-
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
     VectorClear(p->accel);
 
     p->time = time;
@@ -1447,15 +1366,12 @@ void CL_ForceWall(vec3_t start, vec3_t end, int color8)
   while (len > 0) {
     len -= 4;
 
-    if (!free_particles) {
-      return;
-    }
-
     if (frandk() > 0.3) {
-      p = free_particles;
-      free_particles = p->next;
-      p->next = active_particles;
-      active_particles = p;
+      p = CL_AllocParticle();
+      if (!p) {
+        return;
+      }
+
       VectorClear(p->accel);
 
       p->time = time;
@@ -1500,15 +1416,11 @@ void CL_BubbleTrail2(vec3_t start, vec3_t end, int dist)
   VectorScale(vec, dist, vec);
 
   for (i = 0; i < len; i += dist) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     VectorClear(p->accel);
     p->time = time;
 
@@ -1575,15 +1487,11 @@ void CL_Heatbeam(vec3_t start, vec3_t forward)
     }
 
     for (rot = 0; rot < M_PI * 2; rot += rstep) {
-      if (!free_particles) {
+      p = CL_AllocParticle();
+      if (!p) {
         return;
       }
 
-      p = free_particles;
-      free_particles = p->next;
-      p->next = active_particles;
-      active_particles = p;
-
       p->time = time;
       VectorClear(p->accel);
       variance = 0.5;
@@ -1627,15 +1535,11 @@ void CL_ParticleSteamEffect(vec3_t org, vec3_t dir, int color, int count, int ma
   MakeNormalVectors(dir, r, u);
 
   for (i = 0; i < count; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = time;
     p->color = color + (randk() & 7);
 
@@ -1669,15 +1573,11 @@ void CL_ParticleSteamEffect2(cl_sustain_t *self)
   MakeNormalVectors(dir, r, u);
 
   for (i = 0; i < self->count; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = cl.time;
     p->color = self->color + (randk() & 7);
 
@@ -1728,14 +1628,10 @@ void CL_TrackerTrail(vec3_t start, vec3_t end, int particleColor)
   while (len > 0) {
     len -= dec;
 
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
-
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
     VectorClear(p->accel);
 
     p->time = time;
@@ -1767,14 +1663,10 @@ void CL_Tracker_Shell(vec3_t origin)
   time = (float) cl.time;
 
   for (i = 0; i < 300; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
-
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
     VectorClear(p->accel);
 
     p->time = time;
@@ -1801,14 +1693,10 @@ void CL_MonsterPlasma_Shell(vec3_t origin)
   time = (float) cl.time;
 
   for (i = 0; i < 40; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
-
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
     VectorClear(p->accel);
 
     p->time = time;
@@ -1838,14 +1726,10 @@ void CL_Widowbeamout(cl_sustain_t *self)
   time = (float) cl.time;
 
   for (i = 0; i < 300; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
-
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
     VectorClear(p->accel);
 
     p->time = time;
@@ -1875,14 +1759,10 @@ void CL_Nukeblast(cl_sustain_t *self)
   time = (float) cl.time;
 
   for (i = 0; i < 700; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
-
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
     VectorClear(p->accel);
 
     p->time = time;
@@ -1910,15 +1790,11 @@ void CL_WidowSplash(vec3_t org)
   time = (float) cl.time;
 
   for (i = 0; i < 256; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = time;
     p->color = colortable[randk() & 3];
     dir[0] = crandk();
@@ -1945,14 +1821,10 @@ void CL_Tracker_Explode(vec3_t origin)
   time = (float) cl.time;
 
   for (i = 0; i < 300; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
-
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
     VectorClear(p->accel);
 
     p->time = time;
@@ -1993,14 +1865,10 @@ void CL_TagTrail(vec3_t start, vec3_t end, int color)
   while (len >= 0) {
     len -= dec;
 
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
-
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
     VectorClear(p->accel);
 
     p->time = time;
@@ -2029,15 +1897,11 @@ void CL_ColorExplosionParticles(vec3_t org, int color, int run)
   time = (float) cl.time;
 
   for (i = 0; i < 128; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = time;
     p->color = color + (randk() % run);
 
@@ -2070,15 +1934,11 @@ void CL_ParticleSmokeEffect(vec3_t org, vec3_t dir, int color, int count, int ma
   MakeNormalVectors(dir, r, u);
 
   for (i = 0; i < count; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = time;
     p->color = color + (randk() & 7);
 
@@ -2115,15 +1975,11 @@ void CL_BlasterParticles2(vec3_t org, vec3_t dir, unsigned int color)
   count = 40;
 
   for (i = 0; i < count; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = time;
     p->color = color + (randk() & 7);
     d = (float) (randk() & 15);
@@ -2166,14 +2022,10 @@ void CL_BlasterTrail2(vec3_t start, vec3_t end)
   while (len > 0) {
     len -= dec;
 
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
-
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
     VectorClear(p->accel);
 
     p->time = time;
@@ -56,6 +56,7 @@ cvar_t *cl_add_lights;
 cvar_t *cl_add_entities;
 cvar_t *cl_add_blend;
 
+cvar_t *cl_gamestate;
 cvar_t *cl_shownet;
 cvar_t *cl_showmiss;
 cvar_t *cl_showclamp;
@@ -255,6 +256,8 @@ void CL_InitLocal(void)
   cl_add_blend = Cvar_Get("cl_blend", "1", 0);
   cl_add_lights = Cvar_Get("cl_lights", "1", 0);
   cl_add_particles = Cvar_Get("cl_particles", "1", 0);
+  cl_maxparticles = Cvar_Get("cl_maxparticles", "16384", CVAR_ARCHIVE);
+  cl_gamestate = Cvar_Get("cl_gamestate", "1", 0);
   cl_add_entities = Cvar_Get("cl_entities", "1", 0);
   cl_gun = Cvar_Get("cl_gun", "2", CVAR_ARCHIVE);
   cl_footsteps = Cvar_Get("cl_footsteps", "1", 0);
@@ -104,6 +104,7 @@ void CL_SendConnectPacket(void)
 {
   netadr_t adr;
   int port;
+  int netflags;
 
   memset(&adr, 0, sizeof(adr));
 
@@ -119,10 +120,24 @@ void CL_SendConnectPacket(void)
 
   port = Cvar_VariableValue("qport");
 
+  netflags = 0;
+
+  if (cl_gamestate->value) {
+    netflags |= NETF_GAMESTATE;
+  }
+
+  if (Cvar_VariableValue("net_fragment")) {
+    netflags |= NETF_FRAGMENT;
+  }
+
+  if (Cvar_VariableValue("net_compress")) {
+    netflags |= NETF_COMPRESS;
+  }
+
   userinfo_modified = false;
 
-  Netchan_OutOfBandPrint(NS_CLIENT, adr, "connect %i %i %i \"%s\"\n", PROTOCOL_VERSION, port, cls.challenge,
-                         Cvar_Userinfo());
+  Netchan_OutOfBandPrint(NS_CLIENT, adr, "connect %i %i %i \"%s\" %i\n", PROTOCOL_VERSION, port, cls.challenge,
+                         Cvar_Userinfo(), netflags);
 }
 
 /*
@@ -451,6 +466,7 @@ void CL_ConnectionlessPacket(void)
 {
   char *s;
   char *c;
+  int netflags;
 
   MSG_BeginReading(&net_message);
   MSG_ReadLong(&net_message); /* skip the -1 */
@@ -472,6 +488,17 @@ void CL_ConnectionlessPacket(void)
 
     Netchan_Setup(NS_CLIENT, &cls.netchan, net_from, cls.quakePort);
 
+    /* older servers don't confirm anything */
+    netflags = (int) strtol(Cmd_Argv(1), (char **) NULL, 10);
+
+    if (netflags & NETF_FRAGMENT) {
+      Netchan_Fragment(&cls.netchan);
+    }
+
+    if (netflags & NETF_COMPRESS) {
+      Netchan_Compress(&cls.netchan);
+    }
+
     MSG_WriteChar(&cls.netchan.message, clc_stringcmd);
     MSG_WriteString(&cls.netchan.message, "new");
     cls.state = ca_connected;
@@ -35,7 +35,7 @@ char *svc_strings[256] = {
 
     "svc_nop",         "svc_disconnect",     "svc_reconnect",           "svc_sound",         "svc_print",
     "svc_stufftext",   "svc_serverdata",     "svc_configstring",        "svc_spawnbaseline", "svc_centerprint",
-    "svc_playerinfo",  "svc_packetentities", "svc_deltapacketentities", "svc_frame"};
+    "svc_playerinfo",  "svc_packetentities", "svc_deltapacketentities", "svc_frame",         "svc_gamestate"};
 
 void CL_RegisterSounds(void)
 {
@@ -864,6 +864,93 @@ void CL_ParseConfigString(void)
   }
 }
 
+/*
+ * Collects the fragments of a compressed gamestate. Once all of them
+ * are in, the configstrings and baselines inside are parsed as if they
+ * had arrived one by one, and the client moves on to precaching.
+ */
+void CL_ParseGamestate(void)
+{
+  static byte data[MAX_GAMESTATE];
+  static byte raw[MAX_GAMESTATE];
+  sizebuf_t saved;
+  int spawncount, version, length, fragment, offset, size, fragments, cmd;
+
+  spawncount = MSG_ReadLong(&net_message);
+  version = MSG_ReadShort(&net_message);
+  length = MSG_ReadLong(&net_message);
+  fragment = MSG_ReadShort(&net_message);
+
+  offset = fragment * GAMESTATE_FRAGMENT;
+  size = length - offset;
+
+  if (size > GAMESTATE_FRAGMENT) {
+    size = GAMESTATE_FRAGMENT;
+  }
+
+  if ((length <= 0) || (length > MAX_GAMESTATE) || (fragment < 0) || (size <= 0) ||
+      (net_message.readcount + size > net_message.cursize)) {
+    Com_Error(ERR_DROP, "CL_ParseGamestate: bad fragment");
+  }
+
+  net_message.readcount += size;
+
+  if ((spawncount != cl.servercount) || cl.gamestatedone) {
+    return; /* from an earlier level, or going around again */
+  }
+
+  /* a configstring changed and the server built a new one */
+  if ((version != cl.gamestateversion) || (length != cl.gamestatelen)) {
+    cl.gamestateversion = version;
+    cl.gamestatelen = length;
+    cl.gamestatecount = 0;
+    memset(cl.gamestatefragments, 0, sizeof(cl.gamestatefragments));
+  }
+
+  if (cl.gamestatefragments[fragment]) {
+    return;
+  }
+
+  memcpy(data + offset, net_message.data + net_message.readcount - size, size);
+  cl.gamestatefragments[fragment] = 1;
+  cl.gamestatecount++;
+
+  fragments = (length + GAMESTATE_FRAGMENT - 1) / GAMESTATE_FRAGMENT;
+
+  if (cl.gamestatecount < fragments) {
+    return;
+  }
+
+  cl.gamestatedone = true;
+  size = LZSS_Decompress(data, length, raw, sizeof(raw));
+
+  if (size < 0) {
+    Com_Error(ERR_DROP, "CL_ParseGamestate: corrupt gamestate");
+  }
+
+  /* the parsers read from net_message */
+  saved = net_message;
+  SZ_Init(&net_message, raw, sizeof(raw));
+  net_message.cursize = size;
+
+  while ((cmd = MSG_ReadByte(&net_message)) != -1) {
+    if (cmd == svc_configstring) {
+      CL_ParseConfigString();
+    } else if (cmd == svc_spawnbaseline) {
+      CL_ParseBaseline();
+    } else {
+      net_message = saved;
+      Com_Error(ERR_DROP, "CL_ParseGamestate: illegible gamestate");
+    }
+  }
+
+  net_message = saved;
+
+  MSG_WriteByte(&cls.netchan.message, clc_stringcmd);
+  MSG_WriteString(&cls.netchan.message, va("gamestate %i\n", cl.servercount));
+  Cbuf_AddText(va("precache %i\n", cl.servercount));
+}
+
 void CL_ParseStartSoundPacket(void)
 {
   vec3_t pos_v;
@@ -1029,6 +1116,10 @@ void CL_ParseServerMessage(void)
       CL_ParseBaseline();
       break;
 
+    case svc_gamestate:
+      CL_ParseGamestate();
+      break;
+
     case svc_temp_entity:
       CL_ParseTEnt();
       break;
@@ -26,22 +26,201 @@
 
 #include "header/client.h"
 
-cparticle_t *active_particles, *free_particles;
-cparticle_t particles[MAX_PARTICLES];
-int cl_numparticles = MAX_PARTICLES;
+#if defined(__SSE2__) && !defined(NO_SIMD)
+#include <emmintrin.h>
+#define CL_SSE2
+#endif
+
+/*
+ * Live particles are kept packed at the front of a structure of arrays so
+ * CL_AddParticles can integrate four of them at a time and drop the dead
+ * ones by sliding the survivors down. Effects fill in a cparticle_t from
+ * CL_AllocParticle, which is appended to the arrays on the next frame.
+ */
+typedef struct
+{
+  int num; /* live particles */
+  int max;
+  float *time;
+  float *org[3];
+  float *vel[3];
+  float *accel[3];
+  float *color;
+  float *alpha;
+  float *alphavel;
+} particlepool_t;
+
+static particlepool_t pool;
+static float *pool_base;
+
+static cparticle_t *newparticles; /* spawned since the last CL_AddParticles */
+static int numnewparticles;
+
+cvar_t *cl_maxparticles;
+
+static void CL_AllocParticlePool(int max)
+{
+  int i, stride;
+  float *base;
+
+  /* every array is padded to whole SIMD groups and stays 16 byte aligned */
+  stride = (max + 3) & ~3;
+
+  free(pool_base);
+  free(newparticles);
+
+  pool_base = calloc(stride * 13, sizeof(float));
+  newparticles = malloc(max * sizeof(cparticle_t));
+
+  if (!pool_base || !newparticles) {
+    Com_Error(ERR_FATAL, "CL_AllocParticlePool: couldn't allocate %i particles", max);
+  }
+
+  base = pool_base;
+  pool.time = base;
+  base += stride;
+
+  for (i = 0; i < 3; i++) {
+    pool.org[i] = base;
+    pool.vel[i] = base + stride;
+    pool.accel[i] = base + stride * 2;
+    base += stride * 3;
+  }
+
+  pool.color = base;
+  pool.alpha = base + stride;
+  pool.alphavel = base + stride * 2;
+  pool.max = max;
+}
 
 void CL_ClearParticles(void)
 {
-  int i;
+  int max;
+
+  max = cl_maxparticles ? (int) cl_maxparticles->value : MAX_PARTICLES;
+
+  if (max < 1024) {
+    max = 1024;
+  } else if (max > MAX_PARTICLES) {
+    max = MAX_PARTICLES;
+  }
+
+  if (max != pool.max || !pool_base) {
+    CL_AllocParticlePool(max);
+  }
+
+  pool.num = 0;
+  numnewparticles = 0;
+}
+
+/*
+ * Returns a particle for an effect to fill in, or NULL once the cap is
+ * reached
+ */
+cparticle_t *CL_AllocParticle(void)
+{
+  cparticle_t *p;
+
+  if (!pool_base) {
+    CL_ClearParticles();
+  }
+
+  if (pool.num + numnewparticles >= pool.max) {
+    return NULL;
+  }
+
+  p = &newparticles[numnewparticles++];
+  memset(p, 0, sizeof(*p));
+
+  return p;
+}
+
+static void CL_FlushNewParticles(void)
+{
+  cparticle_t *p;
+  int i, j, n;
+
+  for (i = 0, p = newparticles; i < numnewparticles; i++, p++) {
+    n = pool.num++;
+
+    pool.time[n] = p->time;
+
+    for (j = 0; j < 3; j++) {
+      pool.org[j][n] = p->org[j];
+      pool.vel[j][n] = p->vel[j];
+      pool.accel[j][n] = p->accel[j];
+    }
+
+    pool.color[n] = p->color;
+    pool.alpha[n] = p->alpha;
+    pool.alphavel[n] = p->alphavel;
+  }
+
+  numnewparticles = 0;
+}
+
+static void CL_MoveParticle(int from, int to)
+{
+  int j;
+
+  pool.time[to] = pool.time[from];
+
+  for (j = 0; j < 3; j++) {
+    pool.org[j][to] = pool.org[j][from];
+    pool.vel[j][to] = pool.vel[j][from];
+    pool.accel[j][to] = pool.accel[j][from];
+  }
+
+  pool.color[to] = pool.color[from];
+  pool.alpha[to] = pool.alpha[from];
+  pool.alphavel[to] = pool.alphavel[from];
+}
+
+/*
+ * Positions and alphas of the four particles starting at first
+ */
+static void CL_IntegrateParticles(int first, float now, float org[3][4], float alpha[4])
+{
+#ifdef CL_SSE2
+  __m128 time, time2, instant;
+  int j;
+
+  time = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(now), _mm_load_ps(pool.time + first)), _mm_set1_ps(0.001f));
+  instant = _mm_cmpeq_ps(_mm_load_ps(pool.alphavel + first), _mm_set1_ps(INSTANT_PARTICLE));
+  time = _mm_andnot_ps(instant, time);
+  time2 = _mm_mul_ps(time, time);
 
-  free_particles = &particles[0];
-  active_particles = NULL;
+  _mm_storeu_ps(alpha, _mm_add_ps(_mm_load_ps(pool.alpha + first),
+                                  _mm_mul_ps(time, _mm_andnot_ps(instant, _mm_load_ps(pool.alphavel + first)))));
 
-  for (i = 0; i < cl_numparticles; i++) {
-    particles[i].next = &particles[i + 1];
+  for (j = 0; j < 3; j++) {
+    __m128 o;
+
+    o = _mm_add_ps(_mm_load_ps(pool.org[j] + first), _mm_mul_ps(_mm_load_ps(pool.vel[j] + first), time));
+    o = _mm_add_ps(o, _mm_mul_ps(_mm_load_ps(pool.accel[j] + first), time2));
+    _mm_storeu_ps(org[j], o);
   }
+#else
+  int i, j;
+
+  for (i = 0; i < 4; i++) {
+    float time, time2;
+
+    if (pool.alphavel[first + i] != INSTANT_PARTICLE) {
+      time = (now - pool.time[first + i]) * 0.001f;
+      alpha[i] = pool.alpha[first + i] + time * pool.alphavel[first + i];
+    } else {
+      time = 0.0f;
+      alpha[i] = pool.alpha[first + i];
+    }
+
+    time2 = time * time;
 
-  particles[cl_numparticles - 1].next = NULL;
+    for (j = 0; j < 3; j++) {
+      org[j][i] = pool.org[j][first + i] + pool.vel[j][first + i] * time + pool.accel[j][first + i] * time2;
+    }
+  }
+#endif
 }
 
 void CL_ParticleEffect(vec3_t org, vec3_t dir, int color, int count)
@@ -51,15 +230,11 @@ void CL_ParticleEffect(vec3_t org, vec3_t dir, int color, int count)
   float d;
 
   for (i = 0; i < count; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = cl.time;
     p->color = color + (randk() & 7);
     d = randk() & 31;
@@ -87,15 +262,11 @@ void CL_ParticleEffect2(vec3_t org, vec3_t dir, int color, int count)
   time = (float) cl.time;
 
   for (i = 0; i < count; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = time;
     p->color = color + (randk() & 7);
 
@@ -124,15 +295,11 @@ void CL_ParticleEffect3(vec3_t org, vec3_t dir, int color, int count)
   time = (float) cl.time;
 
   for (i = 0; i < count; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = time;
     p->color = color;
 
@@ -153,63 +320,54 @@ void CL_ParticleEffect3(vec3_t org, vec3_t dir, int color, int count)
 
 void CL_AddParticles(void)
 {
-  cparticle_t *p, *next;
-  float alpha;
-  float time, time2;
-  vec3_t org;
-  int color;
-  cparticle_t *active, *tail;
+  particle_t *out;
+  float org[3][4], alpha[4];
+  float now;
+  int i, k, live, room;
+
+  if (cl_maxparticles->modified) {
+    cl_maxparticles->modified = false;
+    CL_ClearParticles();
+  }
 
-  active = NULL;
-  tail = NULL;
+  CL_FlushNewParticles();
 
-  for (p = active_particles; p; p = next) {
-    next = p->next;
+  out = V_ReserveParticles(&room);
+  now = (float) cl.time;
+  live = 0;
 
-    if (p->alphavel != INSTANT_PARTICLE) {
-      time = (cl.time - p->time) * 0.001;
-      alpha = p->alpha + time * p->alphavel;
+  for (i = 0; i < pool.num; i += 4) {
+    CL_IntegrateParticles(i, now, org, alpha);
 
-      if (alpha <= 0) {
+    for (k = 0; k < 4 && i + k < pool.num; k++) {
+      if ((alpha[k] <= 0) && (pool.alphavel[i + k] != INSTANT_PARTICLE)) {
         /* faded out */
-        p->next = free_particles;
-        free_particles = p;
         continue;
       }
-    } else {
-      time = 0.0f;
-      alpha = p->alpha;
-    }
 
-    p->next = NULL;
-
-    if (!tail) {
-      active = tail = p;
-    } else {
-      tail->next = p;
-      tail = p;
-    }
-
-    if (alpha > 1.0f) {
-      alpha = 1;
-    }
-
-    color = p->color;
-    time2 = time * time;
+      if (live != i + k) {
+        CL_MoveParticle(i + k, live);
+      }
 
-    org[0] = p->org[0] + p->vel[0] * time + p->accel[0] * time2;
-    org[1] = p->org[1] + p->vel[1] * time + p->accel[1] * time2;
-    org[2] = p->org[2] + p->vel[2] * time + p->accel[2] * time2;
+      if (live < room) {
+        out[live].origin[0] = org[0][k];
+        out[live].origin[1] = org[1][k];
+        out[live].origin[2] = org[2][k];
+        out[live].color = (int) pool.color[live];
+        out[live].alpha = alpha[k] > 1.0f ? 1.0f : alpha[k];
+      }
 
-    V_AddParticle(org, color, alpha);
+      if (pool.alphavel[live] == INSTANT_PARTICLE) {
+        pool.alphavel[live] = 0.0;
+        pool.alpha[live] = 0.0;
+      }
 
-    if (p->alphavel == INSTANT_PARTICLE) {
-      p->alphavel = 0.0;
-      p->alpha = 0.0;
+      live++;
     }
   }
 
-  active_particles = active;
+  V_CommitParticles(live < room ? live : room);
+  pool.num = live;
 }
 
 void CL_GenericParticleEffect(vec3_t org, vec3_t dir, int color, int count, int numcolors, int dirspread,
@@ -223,15 +381,11 @@ void CL_GenericParticleEffect(vec3_t org, vec3_t dir, int color, int count, int
   time = (float) cl.time;
 
   for (i = 0; i < count; i++) {
-    if (!free_particles) {
+    p = CL_AllocParticle();
+    if (!p) {
       return;
     }
 
-    p = free_particles;
-    free_particles = p->next;
-    p->next = active_particles;
-    active_particles = p;
-
     p->time = time;
 
     if (numcolors > 1) {
@@ -94,6 +94,21 @@ void V_AddParticle(vec3_t org, unsigned int color, float alpha)
   p->alpha = alpha;
 }
 
+/*
+ * Hands out the unused tail of the particle list so a whole
+ * system can be written in place, followed by V_CommitParticles
+ */
+particle_t *V_ReserveParticles(int *room)
+{
+  *room = MAX_PARTICLES - r_numparticles;
+  return &r_particles[r_numparticles];
+}
+
+void V_CommitParticles(int count)
+{
+  r_numparticles += count;
+}
+
 void V_AddLight(vec3_t org, float intensity, float r, float g, float b)
 {
   dlight_t *dl;
@@ -135,7 +150,7 @@ void V_TestParticles(void)
   int i, j;
   float d, r, u;
 
-  r_numparticles = MAX_PARTICLES;
+  r_numparticles = 4096;
 
   for (i = 0; i < r_numparticles; i++) {
     d = i * 0.25f;
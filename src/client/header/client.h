@@ -154,6 +154,13 @@ typedef struct
 
   char configstrings[MAX_CONFIGSTRINGS][MAX_QPATH];
 
+  /* svc_gamestate reassembly */
+  int gamestateversion;
+  int gamestatelen;
+  int gamestatecount; /* fragments received */
+  qboolean gamestatedone;
+  byte gamestatefragments[MAX_GAMESTATE / GAMESTATE_FRAGMENT + 1];
+
   /* locally derived information from server state */
 
   struct model_s *model_draw[MAX_MODELS];
@@ -228,6 +235,8 @@ extern cvar_t *cl_gun;
 extern cvar_t *cl_add_blend;
 extern cvar_t *cl_add_lights;
 extern cvar_t *cl_add_particles;
+extern cvar_t *cl_maxparticles;
+extern cvar_t *cl_gamestate;
 extern cvar_t *cl_add_entities;
 extern cvar_t *cl_predict;
 extern cvar_t *cl_footsteps;
@@ -306,9 +315,6 @@ void CL_ParticleEffect3(vec3_t org, vec3_t dir, int color, int count);
 
 typedef struct particle_s
 {
-
-  struct particle_s *next;
-
   float time;
 
   vec3_t org;
@@ -479,6 +485,10 @@ void V_AddEntity(entity_t *ent);
 
 void V_AddParticle(vec3_t org, unsigned int color, float alpha);
 
+particle_t *V_ReserveParticles(int *room);
+
+void V_CommitParticles(int count);
+
 void V_AddLight(vec3_t org, float intensity, float r, float g, float b);
 
 void V_AddLightStyle(int style, float r, float g, float b);
@@ -503,6 +513,8 @@ void CL_FlyEffect(centity_t *ent, vec3_t origin);
 
 void CL_AddParticles(void);
 
+cparticle_t *CL_AllocParticle(void);
+
 void CL_EntityEvent(entity_state_t *ent);
 
 void CL_TrapParticles(entity_t *ent);
@@ -32,7 +32,7 @@
 
 #define MAX_DLIGHTS 32
 #define MAX_ENTITIES 128
-#define MAX_PARTICLES 4096
+#define MAX_PARTICLES 65536
 #define MAX_LIGHTSTYLES 256
 
 #define EFFECT_SCALE 4.0F
@@ -31,6 +31,14 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <string.h>
 #include <stdarg.h>
 
+// SSE2 is part of the x86_64 baseline, so the inner loops that have a vector
+// version use it whenever the compiler targets it. Define NO_SIMD to build
+// only the portable C loops.
+#if defined(__SSE2__) && !defined(NO_SIMD)
+#include <emmintrin.h>
+#define SW_SSE2
+#endif
+
 // up / down
 #define PITCH 0
 
@@ -362,7 +370,7 @@ extern vec3_t r_pright, r_pup, r_ppn;
 
 void D_DrawSurfaces(void);
 
-void R_DrawParticle(void);
+void R_FreeParticles(void);
 
 void D_ViewChanged(void);
 
@@ -395,7 +403,7 @@ extern float d_sdivzorigin, d_tdivzorigin, d_ziorigin;
 extern int sadjust, tadjust;
 extern int bbextents, bbextentt;
 
-void D_DrawSpans16(espan_t *pspans);
+void D_DrawSpans16(espan_t *pspans, qboolean drawz);
 
 void D_DrawZSpans(espan_t *pspans);
 
@@ -482,10 +490,17 @@ extern cvar_t *r_lerpmodels;
 extern cvar_t *r_speeds;
 extern cvar_t *r_lightlevel;
 extern cvar_t *r_modulate;
+extern cvar_t *r_lightgrid;
+extern cvar_t *r_occlusion;
+extern cvar_t *r_bspcache;
 extern cvar_t *r_vsync;
+extern cvar_t *r_present_queue;
 extern cvar_t *r_scale;
 extern cvar_t *r_scale_width;
 extern cvar_t *r_scale_height;
+extern cvar_t *r_scale_auto;
+extern cvar_t *r_scale_target;
+extern cvar_t *r_scale_min;
 extern cvar_t *r_udither;
 
 extern const int r_ditherkernel[2][2][2];
@@ -566,8 +581,28 @@ surf_t *R_GetSurf(void);
 
 void R_AliasDrawModel(void);
 
+void R_AllocEdgeArenas(void);
+
+void R_FreeEdgeArenas(void);
+
+qboolean R_GrowEdges(int needed);
+
+qboolean R_GrowSurfaces(void);
+
 void R_BeginEdgeFrame(void);
 
+void R_ClearOcclusion(void);
+
+void R_FreeOcclusion(void);
+
+void R_OcclusionNewMap(void);
+
+void R_OccludeFace(msurface_t *fa);
+
+qboolean R_OccludedBBox(float *minmaxs);
+
+qboolean R_OccludedNode(mnode_t *node);
+
 void R_ScanEdges(void);
 
 void D_DrawSurfaces(void);
@@ -614,8 +649,15 @@ void R_InitTurb(void);
 void R_DrawParticles(void);
 
 extern int r_amodels_drawn;
-extern edge_t *auxedges;
+extern int r_aliasverts;
+extern float r_aliastime;
 extern int r_numallocatededges;
+extern int r_numallocatedspans;
+extern int r_maxspansseen;
+extern int r_spanflushes;
+extern int r_occludednodes;
+extern int r_occludedfaces;
+extern int r_occludedbmodels;
 extern edge_t *r_edges, *edge_p, *edge_max;
 
 extern edge_t **newedges;
@@ -662,10 +704,10 @@ void R_AliasClipTriangle(finalvert_t *index0, finalvert_t *index1, finalvert_t *
 extern float r_time1;
 extern float da_time1, da_time2;
 extern float dp_time1, dp_time2, db_time1, db_time2, rw_time1, rw_time2;
+extern float pr_time1, pr_time2;
 extern float se_time1, se_time2, de_time1, de_time2, dv_time1, dv_time2;
 extern int r_frustum_indexes[4 * 6];
 extern int r_maxsurfsseen, r_maxedgesseen, r_cnumsurfs;
-extern qboolean r_surfsonstack;
 
 extern mleaf_t *r_viewleaf;
 extern int r_viewcluster, r_oldviewcluster;
@@ -687,6 +729,8 @@ void R_AnimateLight(void);
 
 void R_LightPoint(vec3_t p, vec3_t color);
 
+void R_ClearLightGrid(void);
+
 void R_SetupFrame(void);
 
 void R_cshift_f(void);
@@ -786,6 +830,7 @@ typedef struct swstate_s
 
   unsigned char gammatable[256];
   unsigned char currentpalette[1024];
+  int palettegeneration; // bumped whenever currentpalette changes
 
 } swstate_t;
 
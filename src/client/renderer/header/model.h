@@ -146,7 +146,8 @@ typedef struct mleaf_s
 
   msurface_t **firstmarksurface;
   int nummarksurfaces;
-  int key; // BSP sequence number for leaf's contents
+  int key;      // BSP sequence number for leaf's contents
+  int keyframe; // r_framecount when key was set
 } mleaf_t;
 
 //===================================================================
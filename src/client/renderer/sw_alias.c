@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 ** use a real variable to control lerping
 */
 #include "header/local.h"
+#include "../../platform/graphics.h"
 
 #define LIGHT_MIN 5 // lowest light value we'll allow, to avoid the
 //  need for inner-loop light clamping
@@ -32,6 +33,8 @@ extern byte iractive;
 // PGM
 
 int r_amodels_drawn;
+int r_aliasverts;
+float r_aliastime;
 
 affinetridesc_t r_affinetridesc;
 
@@ -232,6 +235,7 @@ void R_AliasPreparePoints(void)
   dtriangle_t *ptri;
   finalvert_t *pfv[3];
   finalvert_t *pfinalverts;
+  float time1 = 0;
 
   // PGM
   iractive = (r_newrefdef.rdflags & RDF_IRGOGGLES && currententity->flags & RF_IR_VISIBLE);
@@ -247,9 +251,15 @@ void R_AliasPreparePoints(void)
   aliasbatchedtransformdata.this_verts = r_thisframe->verts;
   aliasbatchedtransformdata.dest_verts = pfinalverts;
 
+  if (sw_aliasstats->value)
+    time1 = gfx_get_ticks();
+
   R_AliasTransformFinalVerts(aliasbatchedtransformdata.num_points, aliasbatchedtransformdata.dest_verts,
                              aliasbatchedtransformdata.last_verts, aliasbatchedtransformdata.this_verts);
 
+  if (sw_aliasstats->value)
+    r_aliastime += gfx_get_ticks() - time1;
+
   // clip and draw all triangles
   //
   pstverts = (dstvert_t *) ((byte *) s_pmdl + s_pmdl->ofs_st);
@@ -385,59 +395,212 @@ void R_AliasSetUpTransform(void)
 
 /*
 ================
-R_AliasTransformFinalVerts
+R_AliasTransformFinalVert
 ================
 */
-void R_AliasTransformFinalVerts(int numpoints, finalvert_t *fv, dtrivertx_t *oldv, dtrivertx_t *newv)
+static void R_AliasTransformFinalVert(finalvert_t *fv, dtrivertx_t *oldv, dtrivertx_t *newv, qboolean shell)
 {
-  int i;
+  int temp;
+  float lightcos, *plightnormal;
+  vec3_t lerped_vert;
 
-  for (i = 0; i < numpoints; i++, fv++, oldv++, newv++) {
-    int temp;
-    float lightcos, *plightnormal;
-    vec3_t lerped_vert;
+  lerped_vert[0] = r_lerp_move[0] + oldv->v[0] * r_lerp_backv[0] + newv->v[0] * r_lerp_frontv[0];
+  lerped_vert[1] = r_lerp_move[1] + oldv->v[1] * r_lerp_backv[1] + newv->v[1] * r_lerp_frontv[1];
+  lerped_vert[2] = r_lerp_move[2] + oldv->v[2] * r_lerp_backv[2] + newv->v[2] * r_lerp_frontv[2];
 
-    lerped_vert[0] = r_lerp_move[0] + oldv->v[0] * r_lerp_backv[0] + newv->v[0] * r_lerp_frontv[0];
-    lerped_vert[1] = r_lerp_move[1] + oldv->v[1] * r_lerp_backv[1] + newv->v[1] * r_lerp_frontv[1];
-    lerped_vert[2] = r_lerp_move[2] + oldv->v[2] * r_lerp_backv[2] + newv->v[2] * r_lerp_frontv[2];
+  plightnormal = r_avertexnormals[newv->lightnormalindex];
 
-    plightnormal = r_avertexnormals[newv->lightnormalindex];
+  // PMM - added double damage shell
+  if (shell) {
+    lerped_vert[0] += plightnormal[0] * EFFECT_SCALE;
+    lerped_vert[1] += plightnormal[1] * EFFECT_SCALE;
+    lerped_vert[2] += plightnormal[2] * EFFECT_SCALE;
+  }
 
-    // PMM - added double damage shell
-    if (currententity->flags & (RF_SHELL_RED | RF_SHELL_GREEN | RF_SHELL_BLUE | RF_SHELL_DOUBLE | RF_SHELL_HALF_DAM)) {
-      lerped_vert[0] += plightnormal[0] * EFFECT_SCALE;
-      lerped_vert[1] += plightnormal[1] * EFFECT_SCALE;
-      lerped_vert[2] += plightnormal[2] * EFFECT_SCALE;
-    }
+  fv->xyz[0] = DotProduct(lerped_vert, aliastransform[0]) + aliastransform[0][3];
+  fv->xyz[1] = DotProduct(lerped_vert, aliastransform[1]) + aliastransform[1][3];
+  fv->xyz[2] = DotProduct(lerped_vert, aliastransform[2]) + aliastransform[2][3];
+
+  fv->flags = 0;
 
-    fv->xyz[0] = DotProduct(lerped_vert, aliastransform[0]) + aliastransform[0][3];
-    fv->xyz[1] = DotProduct(lerped_vert, aliastransform[1]) + aliastransform[1][3];
-    fv->xyz[2] = DotProduct(lerped_vert, aliastransform[2]) + aliastransform[2][3];
+  // lighting
+  lightcos = DotProduct(plightnormal, r_plightvec);
+  temp = r_ambientlight;
 
-    fv->flags = 0;
+  if (lightcos < 0) {
+    temp += (int) (r_shadelight * lightcos);
 
-    // lighting
-    lightcos = DotProduct(plightnormal, r_plightvec);
-    temp = r_ambientlight;
+    // clamp; because we limited the minimum ambient and shading light, we
+    // don't have to clamp low light, just bright
+    if (temp < 0)
+      temp = 0;
+  }
 
-    if (lightcos < 0) {
-      temp += (int) (r_shadelight * lightcos);
+  fv->l = temp;
 
-      // clamp; because we limited the minimum ambient and shading light, we
-      // don't have to clamp low light, just bright
-      if (temp < 0)
-        temp = 0;
+  if (fv->xyz[2] < ALIAS_Z_CLIP_PLANE) {
+    fv->flags |= ALIAS_Z_CLIP;
+  } else {
+    R_AliasProjectAndClipTestFinalVert(fv);
+  }
+}
+
+#ifdef SW_SSE2
+/*
+================
+R_AliasTransformFinalVerts4
+
+Same as R_AliasTransformFinalVert, four vertexes at a time. Each 32 bit lane
+holds one dtrivertx_t, so the frames are decoded straight into structure of
+arrays form and only the normal lookup and the final stores are per vertex.
+numpoints must be a multiple of 4.
+================
+*/
+static void R_AliasTransformFinalVerts4(int numpoints, finalvert_t *fv, dtrivertx_t *oldv, dtrivertx_t *newv,
+                                        qboolean shell)
+{
+  int i, j;
+  __m128 move[3], back[3], front[3], xf[3][4], plightvec[3];
+  __m128 shadelight, zclip, ziscale, xscale, yscale, xcenter, ycenter;
+  __m128i ambientlight, bytemask, vrectx, vrecty, vrectright, vrectbottom;
+  __m128i leftclip, topclip, rightclip, bottomclip, zclipflag;
+
+  for (i = 0; i < 3; i++) {
+    move[i] = _mm_set1_ps(r_lerp_move[i]);
+    back[i] = _mm_set1_ps(r_lerp_backv[i]);
+    front[i] = _mm_set1_ps(r_lerp_frontv[i]);
+    plightvec[i] = _mm_set1_ps(r_plightvec[i]);
+    for (j = 0; j < 4; j++)
+      xf[i][j] = _mm_set1_ps(aliastransform[i][j]);
+  }
+
+  shadelight = _mm_set1_ps(r_shadelight);
+  zclip = _mm_set1_ps(ALIAS_Z_CLIP_PLANE);
+  ziscale = _mm_set1_ps(s_ziscale);
+  xscale = _mm_set1_ps(aliasxscale);
+  yscale = _mm_set1_ps(aliasyscale);
+  xcenter = _mm_set1_ps(aliasxcenter);
+  ycenter = _mm_set1_ps(aliasycenter);
+  ambientlight = _mm_set1_epi32(r_ambientlight);
+  bytemask = _mm_set1_epi32(0xff);
+  vrectx = _mm_set1_epi32(r_refdef.aliasvrect.x);
+  vrecty = _mm_set1_epi32(r_refdef.aliasvrect.y);
+  vrectright = _mm_set1_epi32(r_refdef.aliasvrectright);
+  vrectbottom = _mm_set1_epi32(r_refdef.aliasvrectbottom);
+  leftclip = _mm_set1_epi32(ALIAS_LEFT_CLIP);
+  topclip = _mm_set1_epi32(ALIAS_TOP_CLIP);
+  rightclip = _mm_set1_epi32(ALIAS_RIGHT_CLIP);
+  bottomclip = _mm_set1_epi32(ALIAS_BOTTOM_CLIP);
+  zclipflag = _mm_set1_epi32(ALIAS_Z_CLIP);
+
+  for (i = 0; i < numpoints; i += 4, fv += 4, oldv += 4, newv += 4) {
+    __m128i oldb, newb, l, u, v, zi, flags, zmask, xyflags;
+    __m128 vert[3], normal[3], xyz[3], lightcos, invz;
+    float *n[4];
+    float out[3][4];
+    int outl[4], outu[4], outv[4], outzi[4], outflags[4];
+
+    oldb = _mm_loadu_si128((const __m128i *) oldv);
+    newb = _mm_loadu_si128((const __m128i *) newv);
+
+    for (j = 0; j < 3; j++) {
+      __m128 o = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(oldb, j * 8), bytemask));
+      __m128 f = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(newb, j * 8), bytemask));
+
+      vert[j] = _mm_add_ps(_mm_add_ps(move[j], _mm_mul_ps(o, back[j])), _mm_mul_ps(f, front[j]));
+    }
+
+    for (j = 0; j < 4; j++)
+      n[j] = r_avertexnormals[newv[j].lightnormalindex];
+
+    for (j = 0; j < 3; j++)
+      normal[j] = _mm_set_ps(n[3][j], n[2][j], n[1][j], n[0][j]);
+
+    // PMM - added double damage shell
+    if (shell) {
+      for (j = 0; j < 3; j++)
+        vert[j] = _mm_add_ps(vert[j], _mm_mul_ps(normal[j], _mm_set1_ps(EFFECT_SCALE)));
     }
 
-    fv->l = temp;
+    for (j = 0; j < 3; j++) {
+      xyz[j] = _mm_add_ps(_mm_mul_ps(vert[0], xf[j][0]), _mm_mul_ps(vert[1], xf[j][1]));
+      xyz[j] = _mm_add_ps(_mm_add_ps(xyz[j], _mm_mul_ps(vert[2], xf[j][2])), xf[j][3]);
+    }
+
+    // lighting, only the vertexes facing away from the light get shaded and
+    // need the clamp
+    lightcos = _mm_add_ps(_mm_mul_ps(normal[0], plightvec[0]), _mm_mul_ps(normal[1], plightvec[1]));
+    lightcos = _mm_add_ps(lightcos, _mm_mul_ps(normal[2], plightvec[2]));
+    l = _mm_cvttps_epi32(_mm_mul_ps(shadelight, lightcos));
+    l = _mm_and_si128(l, _mm_castps_si128(_mm_cmplt_ps(lightcos, _mm_setzero_ps())));
+    l = _mm_add_epi32(ambientlight, l);
+    l = _mm_andnot_si128(_mm_srai_epi32(l, 31), l);
+
+    // project and clip test; the results are only kept for the vertexes in
+    // front of the near plane
+    invz = _mm_div_ps(_mm_set1_ps(1.0f), xyz[2]);
+    zi = _mm_cvttps_epi32(_mm_mul_ps(invz, ziscale));
+    u = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(xyz[0], xscale), invz), xcenter));
+    v = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(xyz[1], yscale), invz), ycenter));
+
+    xyflags = _mm_and_si128(_mm_cmplt_epi32(u, vrectx), leftclip);
+    xyflags = _mm_or_si128(xyflags, _mm_and_si128(_mm_cmplt_epi32(v, vrecty), topclip));
+    xyflags = _mm_or_si128(xyflags, _mm_and_si128(_mm_cmpgt_epi32(u, vrectright), rightclip));
+    xyflags = _mm_or_si128(xyflags, _mm_and_si128(_mm_cmpgt_epi32(v, vrectbottom), bottomclip));
+
+    zmask = _mm_castps_si128(_mm_cmplt_ps(xyz[2], zclip));
+    flags = _mm_or_si128(_mm_and_si128(zmask, zclipflag), _mm_andnot_si128(zmask, xyflags));
+
+    for (j = 0; j < 3; j++)
+      _mm_storeu_ps(out[j], xyz[j]);
+    _mm_storeu_si128((__m128i *) outl, l);
+    _mm_storeu_si128((__m128i *) outu, u);
+    _mm_storeu_si128((__m128i *) outv, v);
+    _mm_storeu_si128((__m128i *) outzi, zi);
+    _mm_storeu_si128((__m128i *) outflags, flags);
 
-    if (fv->xyz[2] < ALIAS_Z_CLIP_PLANE) {
-      fv->flags |= ALIAS_Z_CLIP;
-    } else {
-      R_AliasProjectAndClipTestFinalVert(fv);
+    for (j = 0; j < 4; j++) {
+      fv[j].xyz[0] = out[0][j];
+      fv[j].xyz[1] = out[1][j];
+      fv[j].xyz[2] = out[2][j];
+      fv[j].l = outl[j];
+      fv[j].flags = outflags[j];
+
+      if (!(outflags[j] & ALIAS_Z_CLIP)) {
+        fv[j].u = outu[j];
+        fv[j].v = outv[j];
+        fv[j].zi = outzi[j];
+      }
     }
   }
 }
+#endif
+
+/*
+================
+R_AliasTransformFinalVerts
+================
+*/
+void R_AliasTransformFinalVerts(int numpoints, finalvert_t *fv, dtrivertx_t *oldv, dtrivertx_t *newv)
+{
+  int i = 0;
+  qboolean shell;
+
+  // PMM - added double damage shell
+  shell = false;
+  if (currententity->flags & (RF_SHELL_RED | RF_SHELL_GREEN | RF_SHELL_BLUE | RF_SHELL_DOUBLE | RF_SHELL_HALF_DAM))
+    shell = true;
+
+#ifdef SW_SSE2
+  i = numpoints & ~3;
+  R_AliasTransformFinalVerts4(i, fv, oldv, newv, shell);
+#endif
+
+  for (; i < numpoints; i++)
+    R_AliasTransformFinalVert(&fv[i], &oldv[i], &newv[i], shell);
+
+  r_aliasverts += numpoints;
+}
 
 /*
 ================
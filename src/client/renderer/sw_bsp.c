@@ -293,6 +293,11 @@ void R_RecursiveClipBPoly(bedge_t *pedges, mnode_t *pnode, msurface_t *psurf)
                 continue; // not visible
             }
 
+            // leaves the world walk didn't reach, occluded ones included,
+            // have no key this frame and nothing in them can be seen
+            if (((mleaf_t *) pn)->keyframe != r_framecount)
+              continue;
+
             r_currentbkey = ((mleaf_t *) pn)->key;
             R_RenderBmodelFace(psideedges[i], psurf);
           }
@@ -391,6 +396,10 @@ void R_DrawSubmodelPolygons(model_t *pmodel, int clipflags, mnode_t *topnode)
   int numsurfaces;
 
   // FIXME: use bounding-box-based frustum clipping info?
+  // the leaf was culled or occluded by the world walk
+  if (((mleaf_t *) topnode)->keyframe != r_framecount)
+    return;
+
   psurf = &pmodel->surfaces[pmodel->firstmodelsurface];
   numsurfaces = pmodel->nummodelsurfaces;
 
@@ -414,6 +423,23 @@ void R_DrawSubmodelPolygons(model_t *pmodel, int clipflags, mnode_t *topnode)
 
 int c_drawnode;
 
+/*
+================
+R_RenderWorldFace
+================
+*/
+static void R_RenderWorldFace(msurface_t *fa, int clipflags)
+{
+  int numsurfs;
+
+  numsurfs = surface_p - surfaces;
+  R_RenderFace(fa, clipflags);
+
+  // anything behind a face that reached the edge list is hidden by it
+  if (surface_p - surfaces != numsurfs)
+    R_OccludeFace(fa);
+}
+
 /*
 ================
 R_RecursiveWorldNode
@@ -468,6 +494,10 @@ void R_RecursiveWorldNode(mnode_t *node, int clipflags)
     }
   }
 
+  // skip whatever is already hidden behind nearer faces
+  if (r_occlusion->value && R_OccludedNode(node))
+    return;
+
   c_drawnode++;
 
   // if a leaf node, draw stuff
@@ -492,6 +522,7 @@ void R_RecursiveWorldNode(mnode_t *node, int clipflags)
     }
 
     pleaf->key = r_currentkey;
+    pleaf->keyframe = r_framecount;
     r_currentkey++; // all bmodels in a leaf share the same key
   } else {
     float dot;
@@ -536,7 +567,7 @@ void R_RecursiveWorldNode(mnode_t *node, int clipflags)
       if (dot < -BACKFACE_EPSILON) {
         do {
           if ((surf->flags & SURF_PLANEBACK) && (surf->visframe == r_framecount)) {
-            R_RenderFace(surf, clipflags);
+            R_RenderWorldFace(surf, clipflags);
           }
 
           surf++;
@@ -544,7 +575,7 @@ void R_RecursiveWorldNode(mnode_t *node, int clipflags)
       } else if (dot > BACKFACE_EPSILON) {
         do {
           if (!(surf->flags & SURF_PLANEBACK) && (surf->visframe == r_framecount)) {
-            R_RenderFace(surf, clipflags);
+            R_RenderWorldFace(surf, clipflags);
           }
 
           surf++;
@@ -574,6 +605,9 @@ void R_RenderWorld(void)
     return;
 
   c_drawnode = 0;
+  r_occludednodes = 0;
+  r_occludedfaces = 0;
+  r_occludedbmodels = 0;
 
   // auto cycle the world frame for texture animation
   r_worldentity.frame = (int) (r_newrefdef.time * 2);
@@ -583,5 +617,8 @@ void R_RenderWorld(void)
   currentmodel = r_worldmodel;
   r_pcurrentvertbase = currentmodel->vertexes;
 
+  if (r_occlusion->value)
+    R_ClearOcclusion();
+
   R_RecursiveWorldNode(currentmodel->nodes, 15);
 }
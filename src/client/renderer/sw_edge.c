@@ -29,7 +29,6 @@ complexity -- 1 to 3 or so
 have a sentinal at both ends?
 */
 
-edge_t *auxedges;
 edge_t *r_edges, *edge_p, *edge_max;
 
 surf_t *surfaces, *surface_p, *surf_max;
@@ -42,6 +41,9 @@ edge_t **newedges;
 edge_t **removeedges;
 
 espan_t *span_p, *max_span_p;
+int r_numallocatedspans;
+int r_maxspansseen;
+int r_spanflushes;
 
 int r_currentkey;
 
@@ -80,6 +82,200 @@ void R_TrailingEdge(surf_t *surf, edge_t *edge);
 /*
 ===============================================================================
 
+EDGE AND SURFACE ARENAS
+
+The edges and surfaces emitted in a frame live in arenas that start at
+sw_maxedges and sw_maxsurfs and grow whenever a face doesn't fit, so dense
+views don't drop geometry. Growth carries over to the following frames,
+which makes the arenas settle at the peak the map needs.
+
+===============================================================================
+*/
+
+#define MAXGROWNEDGES 0x100000 // keeps cachededgeoffset clear of FULLY_CLIPPED_CACHED
+#define MAXGROWNSURFACES 0xffff // edge_t.surfs holds surface indexes in shorts
+
+static surf_t *surfacearena; // surfaces + 1
+
+/*
+==============
+R_FreeEdgeArenas
+==============
+*/
+void R_FreeEdgeArenas(void)
+{
+  if (r_edges) {
+    free(r_edges);
+    r_edges = NULL;
+  }
+
+  if (surfacearena) {
+    free(surfacearena);
+    surfacearena = NULL;
+  }
+
+  surfaces = NULL;
+
+  edge_p = edge_max = NULL;
+  surface_p = surf_max = NULL;
+}
+
+/*
+==============
+R_AllocEdgeArenas
+==============
+*/
+void R_AllocEdgeArenas(void)
+{
+  R_FreeEdgeArenas();
+
+  r_numallocatededges = sw_maxedges->value;
+  if (r_numallocatededges < MINEDGES)
+    r_numallocatededges = MINEDGES;
+  if (r_numallocatededges > MAXGROWNEDGES)
+    r_numallocatededges = MAXGROWNEDGES;
+
+  r_cnumsurfs = sw_maxsurfs->value;
+  if (r_cnumsurfs < MINSURFACES)
+    r_cnumsurfs = MINSURFACES;
+  if (r_cnumsurfs > MAXGROWNSURFACES)
+    r_cnumsurfs = MAXGROWNSURFACES;
+
+  r_edges = malloc(r_numallocatededges * sizeof(edge_t));
+  surfacearena = malloc(r_cnumsurfs * sizeof(surf_t));
+
+  if (!r_edges || !surfacearena) {
+    R_FreeEdgeArenas();
+    Com_Error(ERR_FATAL, "R_AllocEdgeArenas: couldn't allocate %d edges and %d surfaces", r_numallocatededges,
+              r_cnumsurfs);
+  }
+
+  // surface 0 doesn't really exist; it's just a dummy because index 0
+  // is used to indicate no edge attached to surface
+  surfaces = surfacearena - 1;
+
+  r_maxedgesseen = 0;
+  r_maxsurfsseen = 0;
+  r_maxspansseen = 0;
+}
+
+/*
+==============
+R_GrowEdges
+
+Makes room for at least needed more edges in the middle of a frame. The
+edges emitted so far are linked to each other and from newedges and
+removeedges by pointer, so those links are moved over to the new arena.
+cachededgeoffset is relative to r_edges and stays valid.
+==============
+*/
+qboolean R_GrowEdges(int needed)
+{
+  edge_t *edges, *edge;
+  int used, count, v;
+
+  used = edge_p - r_edges;
+  count = r_numallocatededges * 2;
+  if (count < used + needed + 1)
+    count = used + needed + 1;
+  if (count > MAXGROWNEDGES)
+    count = MAXGROWNEDGES;
+  if (count < used + needed + 1)
+    return false;
+
+  edges = malloc(count * sizeof(edge_t));
+  if (!edges)
+    return false;
+
+  memcpy(edges, r_edges, used * sizeof(edge_t));
+
+  for (edge = edges; edge < edges + used; edge++) {
+    if (edge->next)
+      edge->next = edges + (edge->next - r_edges);
+    if (edge->nextremove)
+      edge->nextremove = edges + (edge->nextremove - r_edges);
+  }
+
+  for (v = r_refdef.vrect.y; v < r_refdef.vrectbottom; v++) {
+    if (newedges[v])
+      newedges[v] = edges + (newedges[v] - r_edges);
+    if (removeedges[v])
+      removeedges[v] = edges + (removeedges[v] - r_edges);
+  }
+
+  free(r_edges);
+
+  r_edges = edges;
+  edge_p = edges + used;
+  edge_max = edges + count;
+  r_numallocatededges = count;
+
+  return true;
+}
+
+/*
+==============
+R_GrowSurfaces
+
+Surfaces are only referenced by index until the edges are scanned, so they
+can simply be moved.
+==============
+*/
+qboolean R_GrowSurfaces(void)
+{
+  surf_t *newsurfaces;
+  int used, count;
+
+  if (r_cnumsurfs >= MAXGROWNSURFACES)
+    return false;
+
+  used = surface_p - surfaces;
+  count = r_cnumsurfs * 2;
+  if (count > MAXGROWNSURFACES)
+    count = MAXGROWNSURFACES;
+
+  newsurfaces = realloc(surfacearena, count * sizeof(surf_t));
+  if (!newsurfaces)
+    return false;
+
+  surfacearena = newsurfaces;
+  surfaces = surfacearena - 1;
+  surface_p = surfaces + used;
+  surf_max = surfacearena + count;
+  r_cnumsurfs = count;
+
+  return true;
+}
+
+/*
+==============
+R_SizeSpans
+
+Span storage is flushed to the screen whenever it runs low in the middle of
+a scan, which repeats the surface setup for every surface drawn again. Make
+it as big as the busiest frame so far so that stays the exception.
+==============
+*/
+static void R_SizeSpans(void)
+{
+  espan_t *spans;
+  int count;
+
+  count = r_maxspansseen + r_maxspansseen / 4 + r_refdef.vrect.width;
+  if (count <= r_numallocatedspans)
+    return;
+
+  spans = realloc(edge_basespans, count * sizeof(espan_t));
+  if (!spans)
+    return;
+
+  edge_basespans = spans;
+  r_numallocatedspans = count;
+}
+
+/*
+===============================================================================
+
 EDGE SCANNING
 
 ===============================================================================
@@ -95,6 +291,8 @@ void R_BeginEdgeFrame(void)
   edge_p = r_edges;
   edge_max = &r_edges[r_numallocatededges];
 
+  surf_max = &surfaces[r_cnumsurfs + 1];
+
   surface_p = &surfaces[2]; // background is surface 1,
   //  surface 0 is a dummy
   surfaces[1].spans = NULL; // no background spans yet
@@ -543,14 +741,19 @@ void R_ScanEdges(void)
   shift20_t iv, bottom;
   espan_t *basespan_p;
   surf_t *s;
+  int spans;
+
+  R_SizeSpans();
 
   basespan_p = edge_basespans;
-  max_span_p = edge_basespans + vid.width * 2 - r_refdef.vrect.width;
-  if ((vid.width * 2 - r_refdef.vrect.width) < 0) {
+  max_span_p = edge_basespans + r_numallocatedspans - r_refdef.vrect.width;
+  if ((r_numallocatedspans - r_refdef.vrect.width) < 0) {
     R_Printf(PRINT_ALL, "No space in edge_basespans\n");
     return;
   }
 
+  spans = 0;
+
   span_p = basespan_p;
 
   // clear active edges to just the background edges around the whole screen
@@ -601,6 +804,9 @@ void R_ScanEdges(void)
     // flush the span list if we can't be sure we have enough spans left for
     // the next scan
     if (span_p > max_span_p) {
+      spans += span_p - basespan_p;
+      r_spanflushes++;
+
       D_DrawSurfaces();
 
       // clear the surface span pointers
@@ -629,6 +835,15 @@ void R_ScanEdges(void)
 
   (*pdrawfunc)();
 
+  spans += span_p - basespan_p;
+  if (spans > r_maxspansseen)
+    r_maxspansseen = spans;
+
+  if (edge_p - r_edges > r_maxedgesseen)
+    r_maxedgesseen = edge_p - r_edges;
+  if (surface_p - surfaces > r_maxsurfsseen)
+    r_maxsurfsseen = surface_p - surfaces;
+
   // draw whatever's left in the span list
   D_DrawSurfaces();
 }
@@ -842,7 +1057,7 @@ void D_SkySurf(surf_t *s)
 
   D_CalcGradients(pface);
 
-  D_DrawSpans16(s->spans);
+  D_DrawSpans16(s->spans, false);
 
   // set up a gradient for the background surface that places it
   // effectively at infinity distance from the viewpoint
@@ -890,9 +1105,7 @@ void D_SolidSurf(surf_t *s)
 
   D_CalcGradients(pface);
 
-  D_DrawSpans16(s->spans);
-
-  D_DrawZSpans(s->spans);
+  D_DrawSpans16(s->spans, true);
 
   if (s->insubmodel) {
     //
@@ -109,6 +109,8 @@ LIGHT SAMPLING
 vec3_t pointcolor;
 mplane_t *lightplane; // used as shadow plane
 vec3_t lightspot;
+static msurface_t *lightsurf; // surface hit by the last RecursiveLightPoint
+static byte *lightsamples;    // its first lightmap sample at lightspot
 
 int RecursiveLightPoint(mnode_t *node, vec3_t start, vec3_t end)
 {
@@ -177,6 +179,9 @@ int RecursiveLightPoint(mnode_t *node, vec3_t start, vec3_t end)
     if (ds > surf->extents[0] || dt > surf->extents[1])
       continue;
 
+    lightsurf = surf;
+    lightsamples = NULL;
+
     if (!surf->samples)
       return 0;
 
@@ -187,6 +192,7 @@ int RecursiveLightPoint(mnode_t *node, vec3_t start, vec3_t end)
     VectorCopy(vec3_origin, pointcolor);
     if (lightmap) {
       lightmap += dt * ((surf->extents[0] >> 4) + 1) + ds;
+      lightsamples = lightmap;
 
       for (maps = 0; maps < MAXLIGHTMAPS && surf->styles[maps] != 255; maps++) {
         samp = *lightmap * r_modulate->value * (1.0 / 255); // adjust for gl scale
@@ -203,6 +209,358 @@ int RecursiveLightPoint(mnode_t *node, vec3_t start, vec3_t end)
   return RecursiveLightPoint(node->children[!side], mid, end);
 }
 
+/*
+=============================================================================
+
+LIGHT GRID
+
+Entities are lit from a grid of light samples instead of tracing the world
+for each of them every frame. A grid point keeps the lightmap styles and
+values found straight below it rather than a color, so lightstyle animation
+and r_modulate still apply at lookup time. Points are traced lazily, a brick
+at a time, the first time something is lit near them. A point only lights
+what it can see, so light doesn't leak through walls and floors thinner than
+the grid spacing. The checks make a lookup cost about as much as an exact
+trace, so the grid is off unless r_lightgrid is set.
+
+=============================================================================
+*/
+
+#define LIGHTGRID_STEP_XY 32
+#define LIGHTGRID_STEP_Z 64
+#define LIGHTGRID_BRICK 8 // grid points per brick side
+
+#define LIGHTSAMPLE_SOLID 1     // inside a wall, ignored by the lookup
+#define LIGHTSAMPLE_CHECKED 2   // the cell this point is the low corner of was checked
+#define LIGHTSAMPLE_CELLCLEAR 4 // and no wall crosses it, so all its open corners are seen
+
+typedef struct
+{
+  int leaf; // in r_worldmodel->leafs
+  byte flags;
+  byte styles[MAXLIGHTMAPS]; // 255 terminated
+  byte values[MAXLIGHTMAPS];
+} lightsample_t;
+
+static const int lightgrid_step[3] = {LIGHTGRID_STEP_XY, LIGHTGRID_STEP_XY, LIGHTGRID_STEP_Z};
+static vec3_t lightgrid_origin;
+static int lightgrid_size[3];   // grid points on each axis
+static int lightgrid_bricks[3]; // bricks on each axis
+static lightsample_t **lightgrid;
+static int lightgrid_numbricks;
+
+/*
+===============
+R_ClearLightGrid
+
+Called for every new map, the grid is rebuilt on demand
+===============
+*/
+void R_ClearLightGrid(void)
+{
+  int i;
+
+  if (lightgrid) {
+    for (i = 0; i < lightgrid_numbricks; i++)
+      free(lightgrid[i]);
+
+    free(lightgrid);
+    lightgrid = NULL;
+  }
+
+  lightgrid_numbricks = 0;
+}
+
+/*
+===============
+R_InitLightGrid
+===============
+*/
+static qboolean R_InitLightGrid(void)
+{
+  mnode_t *headnode = r_worldmodel->nodes;
+  int i;
+
+  for (i = 0; i < 3; i++) {
+    lightgrid_origin[i] = lightgrid_step[i] * floor(headnode->minmaxs[i] / (float) lightgrid_step[i]);
+    lightgrid_size[i] = (int) ((headnode->minmaxs[i + 3] - lightgrid_origin[i]) / lightgrid_step[i]) + 2;
+    lightgrid_bricks[i] = (lightgrid_size[i] + LIGHTGRID_BRICK - 1) / LIGHTGRID_BRICK;
+  }
+
+  lightgrid_numbricks = lightgrid_bricks[0] * lightgrid_bricks[1] * lightgrid_bricks[2];
+  lightgrid = calloc(lightgrid_numbricks, sizeof(*lightgrid));
+
+  if (!lightgrid) {
+    lightgrid_numbricks = 0;
+    return false;
+  }
+
+  return true;
+}
+
+/*
+===============
+R_LightGridTrace
+
+Finds the lightmap sample below a grid point, like R_LightPoint does
+===============
+*/
+static void R_LightGridTrace(vec3_t p, lightsample_t *ls)
+{
+  mleaf_t *leaf;
+  vec3_t end;
+  int maps, size;
+
+  memset(ls->styles, 255, sizeof(ls->styles));
+
+  leaf = Mod_PointInLeaf(p, r_worldmodel);
+  ls->leaf = leaf - r_worldmodel->leafs;
+
+  if (leaf->contents & CONTENTS_SOLID) {
+    ls->flags = LIGHTSAMPLE_SOLID;
+    return;
+  }
+
+  ls->flags = 0;
+
+  end[0] = p[0];
+  end[1] = p[1];
+  end[2] = p[2] - 2048;
+
+  if (RecursiveLightPoint(r_worldmodel->nodes, p, end) != 1 || !lightsamples)
+    return; // nothing lit below
+
+  size = ((lightsurf->extents[0] >> 4) + 1) * ((lightsurf->extents[1] >> 4) + 1);
+
+  for (maps = 0; maps < MAXLIGHTMAPS && lightsurf->styles[maps] != 255; maps++) {
+    ls->styles[maps] = lightsurf->styles[maps];
+    ls->values[maps] = lightsamples[maps * size];
+  }
+}
+
+/*
+===============
+R_LightGridVisible
+
+Returns false if the line from start to end passes through solid
+===============
+*/
+static qboolean R_LightGridVisible(mnode_t *node, vec3_t start, vec3_t end)
+{
+  float front, back, frac;
+  int side;
+  vec3_t mid;
+
+  if (node->contents != -1)
+    return !(node->contents & CONTENTS_SOLID);
+
+  front = DotProduct(start, node->plane->normal) - node->plane->dist;
+  back = DotProduct(end, node->plane->normal) - node->plane->dist;
+
+  if (front >= 0 && back >= 0)
+    return R_LightGridVisible(node->children[0], start, end);
+  if (front < 0 && back < 0)
+    return R_LightGridVisible(node->children[1], start, end);
+
+  side = front < 0;
+  frac = front / (front - back);
+  mid[0] = start[0] + (end[0] - start[0]) * frac;
+  mid[1] = start[1] + (end[1] - start[1]) * frac;
+  mid[2] = start[2] + (end[2] - start[2]) * frac;
+
+  return R_LightGridVisible(node->children[side], start, mid) && R_LightGridVisible(node->children[!side], mid, end);
+}
+
+/*
+===============
+R_LightGridSample
+
+Returns the grid point, tracing the brick that holds it if needed
+===============
+*/
+static lightsample_t *R_LightGridSample(int x, int y, int z)
+{
+  lightsample_t **brick, *ls;
+  int bx, by, bz, i, j, k;
+  vec3_t p;
+
+  bx = x / LIGHTGRID_BRICK;
+  by = y / LIGHTGRID_BRICK;
+  bz = z / LIGHTGRID_BRICK;
+  brick = &lightgrid[(bz * lightgrid_bricks[1] + by) * lightgrid_bricks[0] + bx];
+
+  if (!*brick) {
+    *brick = malloc(LIGHTGRID_BRICK * LIGHTGRID_BRICK * LIGHTGRID_BRICK * sizeof(lightsample_t));
+    if (!*brick)
+      return NULL;
+
+    ls = *brick;
+    for (k = 0; k < LIGHTGRID_BRICK; k++) {
+      for (j = 0; j < LIGHTGRID_BRICK; j++) {
+        for (i = 0; i < LIGHTGRID_BRICK; i++, ls++) {
+          p[0] = lightgrid_origin[0] + (bx * LIGHTGRID_BRICK + i) * lightgrid_step[0];
+          p[1] = lightgrid_origin[1] + (by * LIGHTGRID_BRICK + j) * lightgrid_step[1];
+          p[2] = lightgrid_origin[2] + (bz * LIGHTGRID_BRICK + k) * lightgrid_step[2];
+          R_LightGridTrace(p, ls);
+        }
+      }
+    }
+  }
+
+  x -= bx * LIGHTGRID_BRICK;
+  y -= by * LIGHTGRID_BRICK;
+  z -= bz * LIGHTGRID_BRICK;
+
+  return &(*brick)[(z * LIGHTGRID_BRICK + y) * LIGHTGRID_BRICK + x];
+}
+
+/*
+===============
+R_LightGridCellClear
+
+A wall that hides one open corner of a cell from a point inside it has to
+cross an edge between open corners, unless it ends inside the cell. Solid
+corners don't take part in the lookup, so the cell is clear when all edges
+between open corners are and those corners are joined up by them.
+===============
+*/
+static qboolean R_LightGridCellClear(lightsample_t **corners, vec3_t *cornerp)
+{
+  int open, joined, corner, axis, other;
+
+  open = 0;
+  for (corner = 0; corner < 8; corner++) {
+    if (!(corners[corner]->flags & LIGHTSAMPLE_SOLID))
+      open |= 1 << corner;
+  }
+
+  for (corner = 0; corner < 8; corner++) {
+    for (axis = 0; axis < 3; axis++) {
+      other = corner | (1 << axis);
+
+      if (other == corner || !(open & (1 << corner)) || !(open & (1 << other)))
+        continue;
+
+      if (!R_LightGridVisible(r_worldmodel->nodes, cornerp[corner], cornerp[other]))
+        return false;
+    }
+  }
+
+  // spread from the lowest open corner along the edges
+  joined = open & -open;
+  for (corner = 0; corner < 3; corner++) {
+    for (other = 0; other < 8; other++) {
+      if (joined & (1 << other)) {
+        for (axis = 0; axis < 3; axis++)
+          joined |= (1 << (other ^ (1 << axis))) & open;
+      }
+    }
+  }
+
+  return joined == open;
+}
+
+/*
+===============
+R_LightGridPoint
+
+Trilinear lookup of the static light at p. Grid points inside walls or out
+of sight of p don't take part, and the weights of the others are scaled back
+up to one. Returns false when there is nothing usable around p.
+===============
+*/
+static qboolean R_LightGridPoint(vec3_t p, vec3_t color)
+{
+  lightsample_t *corners[8];
+  int base[3], i, j, corner, leaf;
+  float frac[3], weight, totalweight, modulate;
+  qboolean onebrick;
+  vec3_t cornerp[8];
+
+  if (!lightgrid && !R_InitLightGrid())
+    return false;
+
+  onebrick = true;
+
+  for (i = 0; i < 3; i++) {
+    float v = (p[i] - lightgrid_origin[i]) / lightgrid_step[i];
+
+    if (v < 0)
+      return false;
+
+    base[i] = (int) v;
+    if (base[i] + 1 >= lightgrid_size[i])
+      return false;
+
+    frac[i] = v - base[i];
+
+    if (base[i] % LIGHTGRID_BRICK == LIGHTGRID_BRICK - 1)
+      onebrick = false;
+  }
+
+  corners[0] = R_LightGridSample(base[0], base[1], base[2]);
+  if (!corners[0])
+    return false;
+
+  for (corner = 1; corner < 8; corner++) {
+    int dx = corner & 1, dy = (corner >> 1) & 1, dz = (corner >> 2) & 1;
+
+    // usually all eight are in the same brick
+    if (onebrick)
+      corners[corner] = corners[0] + (dz * LIGHTGRID_BRICK + dy) * LIGHTGRID_BRICK + dx;
+    else if (!(corners[corner] = R_LightGridSample(base[0] + dx, base[1] + dy, base[2] + dz)))
+      return false;
+  }
+
+  for (corner = 0; corner < 8; corner++) {
+    for (i = 0; i < 3; i++)
+      cornerp[corner][i] = lightgrid_origin[i] + (base[i] + ((corner >> i) & 1)) * lightgrid_step[i];
+  }
+
+  if (!(corners[0]->flags & LIGHTSAMPLE_CHECKED)) {
+    corners[0]->flags |= LIGHTSAMPLE_CHECKED;
+    if (R_LightGridCellClear(corners, cornerp))
+      corners[0]->flags |= LIGHTSAMPLE_CELLCLEAR;
+  }
+
+  VectorClear(color);
+  totalweight = 0;
+  modulate = r_modulate->value * (1.0 / 255);
+  leaf = -1;
+
+  for (corner = 0; corner < 8; corner++) {
+    lightsample_t *ls = corners[corner];
+
+    if (ls->flags & LIGHTSAMPLE_SOLID)
+      continue;
+
+    // in a cell a wall crosses, only corners p can see take part,
+    // and leaves are convex, so those in the leaf of p are seen
+    if (!(corners[0]->flags & LIGHTSAMPLE_CELLCLEAR)) {
+      if (leaf < 0)
+        leaf = Mod_PointInLeaf(p, r_worldmodel) - r_worldmodel->leafs;
+
+      if (ls->leaf != leaf && !R_LightGridVisible(r_worldmodel->nodes, p, cornerp[corner]))
+        continue;
+    }
+
+    weight = ((corner & 1) ? frac[0] : 1 - frac[0]) * ((corner & 2) ? frac[1] : 1 - frac[1]) *
+             ((corner & 4) ? frac[2] : 1 - frac[2]);
+
+    for (j = 0; j < MAXLIGHTMAPS && ls->styles[j] != 255; j++)
+      VectorMA(color, ls->values[j] * modulate * weight, r_newrefdef.lightstyles[ls->styles[j]].rgb, color);
+
+    totalweight += weight;
+  }
+
+  if (totalweight <= 0)
+    return false;
+
+  VectorScale(color, 1.0f / totalweight, color);
+
+  return true;
+}
+
 /*
 ===============
 R_LightPoint
@@ -221,16 +579,19 @@ void R_LightPoint(vec3_t p, vec3_t color)
     return;
   }
 
-  end[0] = p[0];
-  end[1] = p[1];
-  end[2] = p[2] - 2048;
+  // with r_lightgrid 0 every point is traced exactly
+  if (!r_lightgrid->value || !R_LightGridPoint(p, color)) {
+    end[0] = p[0];
+    end[1] = p[1];
+    end[2] = p[2] - 2048;
 
-  r = RecursiveLightPoint(r_worldmodel->nodes, p, end);
+    r = RecursiveLightPoint(r_worldmodel->nodes, p, end);
 
-  if (r == -1) {
-    VectorCopy(vec3_origin, color);
-  } else {
-    VectorCopy(pointcolor, color);
+    if (r == -1) {
+      VectorCopy(vec3_origin, color);
+    } else {
+      VectorCopy(pointcolor, color);
+    }
   }
 
   //
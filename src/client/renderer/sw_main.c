@@ -62,7 +62,6 @@ mvertex_t *r_pcurrentvertbase;
 
 int c_surf;
 int r_maxsurfsseen, r_maxedgesseen, r_cnumsurfs;
-qboolean r_surfsonstack;
 int r_clipflags;
 
 //
@@ -109,6 +108,7 @@ int r_viewcluster, r_oldviewcluster;
 image_t *r_notexture_mip;
 
 float da_time1, da_time2, dp_time1, dp_time2, db_time1, db_time2, rw_time1, rw_time2;
+float pr_time1, pr_time2;
 float se_time1, se_time2, de_time1, de_time2;
 
 void R_MarkLeaves(void);
@@ -136,13 +136,26 @@ cvar_t *r_fullbright;
 cvar_t *r_lerpmodels;
 cvar_t *r_novis;
 cvar_t *r_modulate;
+cvar_t *r_lightgrid;
+cvar_t *r_occlusion;
+cvar_t *r_bspcache;
 cvar_t *r_vsync;
+cvar_t *r_present_queue;
 cvar_t *r_customwidth;
 cvar_t *r_customheight;
 
 cvar_t *r_scale;
 cvar_t *r_scale_width;
 cvar_t *r_scale_height;
+cvar_t *r_scale_auto;
+cvar_t *r_scale_target;
+cvar_t *r_scale_min;
+
+// Dynamic resolution state
+static float r_rendertime = -1; // milliseconds spent in the last RE_RenderFrame
+static float r_dynscale = 1.0;
+static float r_dynscale_time;
+static int r_dynscale_wait;
 
 cvar_t *r_udither;
 
@@ -297,13 +310,22 @@ void R_Register(void)
   r_lerpmodels = Cvar_Get("r_lerpmodels", "1", 0);
   r_novis = Cvar_Get("r_novis", "0", 0);
   r_modulate = Cvar_Get("r_modulate", "1", CVAR_ARCHIVE);
+  r_lightgrid = Cvar_Get("r_lightgrid", "0", 0);
+  r_occlusion = Cvar_Get("r_occlusion", "1", 0);
+  r_bspcache = Cvar_Get("r_bspcache", "0", CVAR_ARCHIVE);
   r_vsync = Cvar_Get("r_vsync", "1", CVAR_ARCHIVE);
+  // 1 expands the palette on a worker thread and shows each frame one update
+  // later; the upload, present and vsync wait stay on the main thread
+  r_present_queue = Cvar_Get("r_present_queue", "0", CVAR_ARCHIVE);
   r_customwidth = Cvar_Get("r_customwidth", "1024", CVAR_ARCHIVE);
   r_customheight = Cvar_Get("r_customheight", "768", CVAR_ARCHIVE);
 
   r_scale = Cvar_Get("r_scale", "0", CVAR_ARCHIVE);
   r_scale_width = Cvar_Get("r_scale_width", "320", CVAR_ARCHIVE);
   r_scale_height = Cvar_Get("r_scale_height", "240", CVAR_ARCHIVE);
+  r_scale_auto = Cvar_Get("r_scale_auto", "0", CVAR_ARCHIVE);
+  r_scale_target = Cvar_Get("r_scale_target", "16", CVAR_ARCHIVE);
+  r_scale_min = Cvar_Get("r_scale_min", "0.5", CVAR_ARCHIVE);
 
   r_udither = Cvar_Get("r_udither", "0", CVAR_ARCHIVE);
 
@@ -387,6 +409,10 @@ void RE_Shutdown(void)
     vid_colormap = NULL;
   }
   R_UnRegister();
+  R_ClearLightGrid();
+  R_FreeEdgeArenas();
+  R_FreeOcclusion();
+  R_FreeParticles();
   Mod_FreeAll();
   R_ShutdownImages();
 
@@ -402,41 +428,11 @@ void R_NewMap(void)
 {
   r_viewcluster = -1;
 
-  r_cnumsurfs = sw_maxsurfs->value;
-
-  if (r_cnumsurfs <= MINSURFACES)
-    r_cnumsurfs = MINSURFACES;
-
-  if (r_cnumsurfs > NUMSTACKSURFACES) {
-    surfaces = malloc(r_cnumsurfs * sizeof(surf_t));
-    if (!surfaces) {
-      R_Printf(PRINT_ALL, "R_NewMap: Couldn't malloc %ld bytes\n", r_cnumsurfs * sizeof(surf_t));
-      return;
-    }
-
-    surface_p = surfaces;
-    surf_max = &surfaces[r_cnumsurfs];
-    r_surfsonstack = false;
-    // surface 0 doesn't really exist; it's just a dummy because index 0
-    // is used to indicate no edge attached to surface
-    surfaces--;
-  } else {
-    r_surfsonstack = true;
-  }
-
-  r_maxedgesseen = 0;
-  r_maxsurfsseen = 0;
+  R_ClearLightGrid();
 
-  r_numallocatededges = sw_maxedges->value;
+  R_AllocEdgeArenas();
 
-  if (r_numallocatededges < MINEDGES)
-    r_numallocatededges = MINEDGES;
-
-  if (r_numallocatededges <= NUMSTACKEDGES) {
-    auxedges = NULL;
-  } else {
-    auxedges = malloc(r_numallocatededges * sizeof(edge_t));
-  }
+  R_OcclusionNewMap();
 }
 
 /*
@@ -777,6 +773,11 @@ void R_DrawBEntitiesOnList(void)
     if (clipflags == BMODEL_FULLY_CLIPPED)
       continue; // off the edge of the screen
 
+    if (r_occlusion->value && R_OccludedBBox(minmaxs)) {
+      r_occludedbmodels++;
+      continue; // behind the world
+    }
+
     topnode = R_FindTopnode(minmaxs, minmaxs + 3);
     if (!topnode)
       continue; // no part in a visible leaf
@@ -815,8 +816,6 @@ void R_DrawBEntitiesOnList(void)
   insubmodel = false;
 }
 
-edge_t *ledges;
-surf_t *lsurfs;
 
 /*
 ================
@@ -828,19 +827,8 @@ void R_EdgeDrawing(void)
   if (r_newrefdef.rdflags & RDF_NOWORLDMODEL)
     return;
 
-  if (auxedges) {
-    r_edges = auxedges;
-  } else {
-    r_edges = ledges;
-  }
-
-  if (r_surfsonstack) {
-    surfaces = lsurfs;
-    surf_max = &surfaces[r_cnumsurfs];
-    // surface 0 doesn't really exist; it's just a dummy because index 0
-    // is used to indicate no edge attached to surface
-    surfaces--;
-  }
+  if (!r_edges)
+    R_AllocEdgeArenas();
 
   R_BeginEdgeFrame();
 
@@ -943,13 +931,20 @@ void RE_RenderFrame(refdef_t *fd)
 {
   r_newrefdef = *fd;
 
+  // the buffers may have been resized by dynamic resolution since the caller
+  // laid out its view, so never let it reach past them
+  if (r_newrefdef.x + r_newrefdef.width > vid.width)
+    r_newrefdef.width = vid.width - r_newrefdef.x;
+  if (r_newrefdef.y + r_newrefdef.height > vid.height)
+    r_newrefdef.height = vid.height - r_newrefdef.y;
+
   if (!r_worldmodel && !(r_newrefdef.rdflags & RDF_NOWORLDMODEL))
     Com_Error(ERR_FATAL, "R_RenderView: NULL worldmodel");
 
   VectorCopy(fd->vieworg, r_refdef.vieworg);
   VectorCopy(fd->viewangles, r_refdef.viewangles);
 
-  if (r_speeds->value || r_dspeeds->value) {
+  if (r_speeds->value || r_dspeeds->value || r_scale_auto->value) {
     r_time1 = gfx_get_ticks();
   }
 
@@ -997,6 +992,9 @@ void RE_RenderFrame(refdef_t *fd)
 
   R_CalcPalette();
 
+  if (r_scale_auto->value)
+    r_rendertime = gfx_get_ticks() - r_time1;
+
   if (sw_aliasstats->value)
     R_PrintAliasStats();
 
@@ -1060,7 +1058,7 @@ void RE_BeginFrame(float camera_separation)
   }
 
   while (r_mode->modified || vid_fullscreen->modified || r_vsync->modified || r_scale->modified ||
-         r_scale_width->modified || r_scale_height->modified) {
+         r_scale_width->modified || r_scale_height->modified || r_present_queue->modified) {
     rserr_t err;
     int win_width, win_height;
 
@@ -1084,6 +1082,7 @@ void RE_BeginFrame(float camera_separation)
       vid_fullscreen->modified = false;
       r_mode->modified = false;
       r_vsync->modified = false;
+      r_present_queue->modified = false;
       r_scale->modified = false;
       r_scale_width->modified = false;
       r_scale_height->modified = false;
@@ -1111,11 +1110,23 @@ void RE_BeginFrame(float camera_separation)
 void R_GammaCorrectAndSetPalette(const unsigned char *palette)
 {
   int i;
+  byte corrected[3];
+  qboolean changed = false;
 
   for (i = 0; i < 256; i++) {
-    sw_state.currentpalette[i * 4 + 0] = sw_state.gammatable[palette[i * 4 + 0]];
-    sw_state.currentpalette[i * 4 + 1] = sw_state.gammatable[palette[i * 4 + 1]];
-    sw_state.currentpalette[i * 4 + 2] = sw_state.gammatable[palette[i * 4 + 2]];
+    corrected[0] = sw_state.gammatable[palette[i * 4 + 0]];
+    corrected[1] = sw_state.gammatable[palette[i * 4 + 1]];
+    corrected[2] = sw_state.gammatable[palette[i * 4 + 2]];
+
+    if (memcmp(&sw_state.currentpalette[i * 4], corrected, 3)) {
+      memcpy(&sw_state.currentpalette[i * 4], corrected, 3);
+      changed = true;
+    }
+  }
+
+  // lets the video backend skip rebuilding its lookup table
+  if (changed) {
+    sw_state.palettegeneration++;
   }
 }
 
@@ -1316,7 +1327,7 @@ qboolean RE_IsVsyncActive(void)
   }
 }
 
-static void SWimp_DestroyRender(void)
+static void SWimp_FreeBuffers(void)
 {
   if (vid_buffer) {
     free(vid_buffer);
@@ -1378,21 +1389,16 @@ static void SWimp_DestroyRender(void)
   }
   finalverts = NULL;
 
-  if (ledges) {
-    free(ledges);
-  }
-  ledges = NULL;
-
-  if (lsurfs) {
-    free(lsurfs);
-  }
-  lsurfs = NULL;
 
   if (r_warpbuffer) {
     free(r_warpbuffer);
   }
   r_warpbuffer = NULL;
+}
 
+static void SWimp_DestroyRender(void)
+{
+  SWimp_FreeBuffers();
   gfx_free();
 }
 
@@ -1402,6 +1408,12 @@ point math used in R_ScanEdges() overflows at width 2048 !!
 */
 char shift_size;
 
+static void SWimp_AllocBuffers(void);
+
+// Resolution picked by the mode and r_scale settings, which dynamic
+// scaling shrinks from
+static int r_basewidth, r_baseheight;
+
 /*
 ** SWimp_InitGraphics
 **
@@ -1456,7 +1468,8 @@ static qboolean SWimp_InitGraphics(qboolean fullscreen, int *pwidth, int *pheigh
   VID_NewWindow(vid.width, vid.height);
 
   while (1) {
-    if (!gfx_create_window(fullscreen, r_vsync->value, win_width, win_height, render_width, render_height)) {
+    if (!gfx_create_window(fullscreen, r_vsync->value, win_width, win_height, render_width, render_height,
+                           r_present_queue->value)) {
       Sys_Error("Failed to create window: %s\n", gfx_get_error());
       return false;
     } else {
@@ -1464,6 +1477,26 @@ static qboolean SWimp_InitGraphics(qboolean fullscreen, int *pwidth, int *pheigh
     }
   }
 
+  SWimp_AllocBuffers();
+
+  r_basewidth = render_width;
+  r_baseheight = render_height;
+  r_dynscale = 1.0;
+  r_dynscale_time = 0;
+
+  memset(sw_state.currentpalette, 0, sizeof(sw_state.currentpalette));
+  sw_state.palettegeneration++;
+
+  return true;
+}
+
+/*
+** SWimp_AllocBuffers
+**
+** Allocates everything sized by vid.width and vid.height
+*/
+static void SWimp_AllocBuffers(void)
+{
   vid_buffer = malloc(vid.height * vid.width * sizeof(pixel_t));
 
   sintable = malloc((vid.width + CYCLE) * sizeof(int));
@@ -1479,10 +1512,9 @@ static qboolean SWimp_InitGraphics(qboolean fullscreen, int *pwidth, int *pheigh
   warp_rowptr = malloc((vid.width + AMP2 * 2) * sizeof(byte *));
   warp_column = malloc((vid.width + AMP2 * 2) * sizeof(int));
 
-  edge_basespans = malloc((vid.width * 2) * sizeof(espan_t));
+  r_numallocatedspans = vid.width * 2;
+  edge_basespans = malloc(r_numallocatedspans * sizeof(espan_t));
   finalverts = malloc((MAXALIASVERTS + 3) * sizeof(finalvert_t));
-  ledges = malloc((NUMSTACKEDGES + 1) * sizeof(edge_t));
-  lsurfs = malloc((NUMSTACKSURFACES + 1) * sizeof(surf_t));
   r_warpbuffer = malloc(WARP_WIDTH * WARP_HEIGHT * sizeof(pixel_t));
 
   if ((vid.width >= 2048) && (sizeof(shift20_t) == 4)) {
@@ -1494,10 +1526,129 @@ static qboolean SWimp_InitGraphics(qboolean fullscreen, int *pwidth, int *pheigh
   R_InitTurb();
 
   vid_polygon_spans = malloc(sizeof(espan_t) * (vid.height + 1));
+}
 
-  memset(sw_state.currentpalette, 0, sizeof(sw_state.currentpalette));
+/*
+** R_ResizeRender
+**
+** Changes the internal render resolution between frames. Only the
+** buffers that depend on it are reallocated, the window and renderer
+** are kept.
+*/
+static void R_ResizeRender(int width, int height)
+{
+  SWimp_FreeBuffers();
 
-  return true;
+  vid.width = width;
+  vid.height = height;
+
+  gfx_resize_render(width, height);
+  SWimp_AllocBuffers();
+  memset(vid_buffer, 0, vid.width * vid.height * sizeof(pixel_t));
+
+  R_InitGraphics(width, height);
+  VID_NewWindow(width, height);
+}
+
+/*
+** R_UpdateDynamicScale
+**
+** With r_scale_auto, smooths the time spent in RE_RenderFrame and
+** steps the internal resolution toward r_scale_target milliseconds,
+** between r_scale_min and the base resolution. Rasterization time is
+** roughly proportional to the pixel count, so the scale moves by the
+** square root of the time ratio.
+*/
+static void R_UpdateDynamicScale(void)
+{
+  float scale, target, minscale;
+  int width, height;
+
+  if (!r_basewidth) {
+    return;
+  }
+
+  if (!r_scale_auto->value) {
+    if (vid.width != r_basewidth || vid.height != r_baseheight) {
+      r_dynscale = 1.0;
+      R_ResizeRender(r_basewidth, r_baseheight);
+    }
+
+    return;
+  }
+
+  if (r_rendertime < 0) {
+    return; // no 3D view this frame
+  }
+
+  if (r_dynscale_time <= 0) {
+    r_dynscale_time = r_rendertime;
+  } else {
+    r_dynscale_time += (r_rendertime - r_dynscale_time) * 0.1;
+  }
+
+  r_rendertime = -1;
+
+  if (r_dynscale_wait > 0) {
+    r_dynscale_wait--;
+    return;
+  }
+
+  target = r_scale_target->value;
+  if (target <= 0 || (r_dynscale_time < target * 1.05 && r_dynscale_time > target * 0.75)) {
+    return;
+  }
+
+  // aim inside the dead band so the next measurement doesn't bounce back
+  scale = r_dynscale * sqrt(target * 0.9 / (r_dynscale_time > 0.1 ? r_dynscale_time : 0.1));
+
+  // at most a quarter either way per step
+  if (scale < r_dynscale * 0.75) {
+    scale = r_dynscale * 0.75;
+  } else if (scale > r_dynscale * 1.25) {
+    scale = r_dynscale * 1.25;
+  }
+
+  minscale = r_scale_min->value;
+  if (minscale < 0.1) {
+    minscale = 0.1;
+  } else if (minscale > 1.0) {
+    minscale = 1.0;
+  }
+
+  if (scale < minscale) {
+    scale = minscale;
+  } else if (scale > 1.0) {
+    scale = 1.0;
+  }
+
+  width = (int) (r_basewidth * scale) & ~7;
+  height = (int) (r_baseheight * scale);
+
+  // same minimum as r_scale
+  if (width < 320) {
+    width = r_basewidth < 320 ? r_basewidth : 320;
+  }
+
+  if (height < 200) {
+    height = r_baseheight < 200 ? r_baseheight : 200;
+  }
+
+  if (abs(width - vid.width) < 16 && scale != 1.0) {
+    return;
+  }
+
+  if (width == vid.width && height == vid.height) {
+    return;
+  }
+
+  // predict the time at the new size until it has been measured
+  r_dynscale_time *= (float) (width * height) / (vid.width * vid.height);
+  r_dynscale = scale;
+  r_dynscale_wait = 30;
+
+  R_Printf(PRINT_DEVELOPER, "Dynamic resolution: %dx%d (%.1f ms)\n", width, height, r_dynscale_time);
+  R_ResizeRender(width, height);
 }
 
 /*
@@ -1510,7 +1661,17 @@ static qboolean SWimp_InitGraphics(qboolean fullscreen, int *pwidth, int *pheigh
 
 void RE_EndFrame(void)
 {
-  gfx_update(sw_state, vid);
+  if (r_dspeeds->value) {
+    pr_time1 = gfx_get_ticks();
+  }
+
+  gfx_update(&sw_state, vid);
+
+  if (r_dspeeds->value) {
+    pr_time2 = gfx_get_ticks();
+  }
+
+  R_UpdateDynamicScale();
 }
 
 /*
@@ -106,6 +106,9 @@ void R_PrintTimes(void)
   ms = r_time2 - r_time1;
 
   R_Printf(PRINT_ALL, "%5i ms %3i/%3i/%3i poly %3i surf\n", ms, c_faceclip, r_polycount, r_drawnpolycount, c_surf);
+  R_Printf(PRINT_ALL, "peak %i/%i edges %i/%i surfs %i/%i spans, %i span flushes\n", r_maxedgesseen,
+           r_numallocatededges, r_maxsurfsseen, r_cnumsurfs, r_maxspansseen, r_numallocatedspans, r_spanflushes);
+  R_Printf(PRINT_ALL, "occluded %i nodes %i faces %i bmodels\n", r_occludednodes, r_occludedfaces, r_occludedbmodels);
   c_surf = 0;
 }
 
@@ -116,7 +119,7 @@ R_PrintDSpeeds
 */
 void R_PrintDSpeeds(void)
 {
-  int ms, dp_time, r_time2, rw_time, db_time, se_time, de_time, da_time;
+  int ms, dp_time, r_time2, rw_time, db_time, se_time, de_time, da_time, pr_time;
 
   r_time2 = gfx_get_ticks();
 
@@ -126,9 +129,11 @@ void R_PrintDSpeeds(void)
   db_time = (db_time2 - db_time1);
   se_time = (se_time2 - se_time1);
   de_time = (de_time2 - de_time1);
+  pr_time = (pr_time2 - pr_time1); // previous frame, the present comes after this
   ms = (r_time2 - r_time1);
 
-  R_Printf(PRINT_ALL, "%3i %2ip %2iw %2ib %2is %2ie %2ia\n", ms, dp_time, rw_time, db_time, se_time, de_time, da_time);
+  R_Printf(PRINT_ALL, "%3i %2ip %2iw %2ib %2is %2ie %2ia %2iv\n", ms, dp_time, rw_time, db_time, se_time, de_time,
+           da_time, pr_time);
 }
 
 /*
@@ -138,7 +143,12 @@ R_PrintAliasStats
 */
 void R_PrintAliasStats(void)
 {
-  R_Printf(PRINT_ALL, "%3i polygon model drawn\n", r_amodels_drawn);
+  R_Printf(PRINT_ALL, "%3i polygon model drawn, %5i verts in %.3f ms", r_amodels_drawn, r_aliasverts, r_aliastime);
+
+  if (r_aliastime > 0)
+    R_Printf(PRINT_ALL, " (%.1f Mverts/s)", r_aliasverts / (r_aliastime * 1000.0f));
+
+  R_Printf(PRINT_ALL, "\n");
 }
 
 /*
@@ -385,8 +395,11 @@ void R_SetupFrame(void)
   r_drawnpolycount = 0;
   r_wholepolycount = 0;
   r_amodels_drawn = 0;
+  r_aliasverts = 0;
+  r_aliastime = 0;
   r_outofsurfaces = 0;
   r_outofedges = 0;
+  r_spanflushes = 0;
 
   // d_setup
   d_roverwrapped = false;
@@ -46,6 +46,8 @@ model_t mod_inline[MAX_MOD_KNOWN];
 
 int registration_sequence;
 int modfilelen;
+static unsigned mod_checksum;   // valid when mod_sharedfile is set
+static qboolean mod_sharedfile; // buffer belongs to the collision model
 
 //===============================================================================
 
@@ -129,9 +131,13 @@ model_t *Mod_ForName(char *name, qboolean crash)
   strcpy(mod->name, name);
 
   //
-  // load the file
+  // load the file, unless it is the map the collision model
+  // has just read
   //
-  modfilelen = FS_LoadFile(mod->name, (void **) &buf);
+  buf = (unsigned *) CM_MapFile(mod->name, &modfilelen, &mod_checksum);
+  mod_sharedfile = buf != NULL;
+  if (!mod_sharedfile)
+    modfilelen = FS_LoadFile(mod->name, (void **) &buf);
   if (!buf) {
     if (crash)
       Com_Error(ERR_DROP, "Mod_NumForName: %s not found", mod->name);
@@ -170,7 +176,8 @@ model_t *Mod_ForName(char *name, qboolean crash)
 
   loadmodel->extradatasize = Hunk_End();
 
-  FS_FreeFile(buf);
+  if (!mod_sharedfile)
+    FS_FreeFile(buf);
 
   return mod;
 }
@@ -322,6 +329,214 @@ void R_NumberLeafs(mnode_t *node)
   R_NumberLeafs(node->children[1]);
 }
 
+/*
+===============================================================================
+
+                                        DERIVED DATA CACHE
+
+Surface extents, node parents and leaf numbering depend on nothing but
+the .bsp, so with r_bspcache set they are saved under the game directory
+keyed by the map checksum and read back on the next load of that map.
+
+===============================================================================
+*/
+
+#define BSPCACHE_IDENT (('C' << 24) + ('P' << 16) + ('S' << 8) + 'B') // little-endian "BSPC"
+#define BSPCACHE_VERSION 1
+
+typedef struct
+{
+  int ident;
+  int version;
+  unsigned checksum;
+  int numsurfaces;
+  int numnodes;
+  int numleafs;
+  int numvisleafs;
+} bspcacheheader_t;
+
+typedef struct
+{
+  short texturemins[2];
+  short extents[2];
+} bspcachesurf_t;
+
+// the file is the header, one bspcachesurf_t per face, then the parent
+// of every node, the parent of every leaf and the leaf numbering
+typedef struct
+{
+  byte *data;
+  bspcacheheader_t *header;
+  bspcachesurf_t *surfs;
+  int *nodeparents;
+  int *leafparents;
+  int *leaftovis;
+} bspcache_t;
+
+static bspcache_t mod_bspcache;
+
+static int Mod_BspCacheSize(int numsurfaces, int numnodes, int numleafs)
+{
+  return sizeof(bspcacheheader_t) + numsurfaces * sizeof(bspcachesurf_t) + (numnodes + numleafs * 2) * sizeof(int);
+}
+
+static void Mod_BspCachePath(unsigned checksum, char *path, int size)
+{
+  Com_sprintf(path, size, "%s/bspcache/%08x.bin", FS_Gamedir(), checksum);
+}
+
+static void Mod_SetBspCachePointers(int numsurfaces, int numnodes, int numleafs)
+{
+  byte *p;
+
+  p = mod_bspcache.data;
+  mod_bspcache.header = (bspcacheheader_t *) p;
+  p += sizeof(bspcacheheader_t);
+  mod_bspcache.surfs = (bspcachesurf_t *) p;
+  p += numsurfaces * sizeof(bspcachesurf_t);
+  mod_bspcache.nodeparents = (int *) p;
+  p += numnodes * sizeof(int);
+  mod_bspcache.leafparents = (int *) p;
+  p += numleafs * sizeof(int);
+  mod_bspcache.leaftovis = (int *) p;
+}
+
+/*
+=================
+Mod_FreeBspCache
+=================
+*/
+static void Mod_FreeBspCache(void)
+{
+  free(mod_bspcache.data);
+  memset(&mod_bspcache, 0, sizeof(mod_bspcache));
+}
+
+/*
+=================
+Mod_LoadBspCache
+
+Leaves mod_bspcache empty unless a cache matching the map is found
+=================
+*/
+static void Mod_LoadBspCache(dheader_t *header, unsigned checksum)
+{
+  char path[MAX_OSPATH];
+  bspcacheheader_t *h;
+  int numsurfaces, numnodes, numleafs, size;
+  FILE *f;
+
+  Mod_FreeBspCache();
+
+  numsurfaces = header->lumps[LUMP_FACES].filelen / sizeof(dface_t);
+  numnodes = header->lumps[LUMP_NODES].filelen / sizeof(dnode_t);
+  numleafs = header->lumps[LUMP_LEAFS].filelen / sizeof(dleaf_t);
+  size = Mod_BspCacheSize(numsurfaces, numnodes, numleafs);
+
+  Mod_BspCachePath(checksum, path, sizeof(path));
+  f = fopen(path, "rb");
+  if (!f)
+    return;
+
+  mod_bspcache.data = malloc(size);
+  if (!mod_bspcache.data || fread(mod_bspcache.data, 1, size, f) != (size_t) size || fgetc(f) != EOF) {
+    fclose(f);
+    Mod_FreeBspCache();
+    return;
+  }
+  fclose(f);
+
+  h = (bspcacheheader_t *) mod_bspcache.data;
+  if (h->ident != BSPCACHE_IDENT || h->version != BSPCACHE_VERSION || h->checksum != checksum ||
+      h->numsurfaces != numsurfaces || h->numnodes != numnodes || h->numleafs != numleafs ||
+      h->numvisleafs < 0 || h->numvisleafs > numleafs) {
+    Mod_FreeBspCache();
+    return;
+  }
+
+  Mod_SetBspCachePointers(numsurfaces, numnodes, numleafs);
+}
+
+/*
+=================
+Mod_WriteBspCache
+=================
+*/
+static void Mod_WriteBspCache(unsigned checksum)
+{
+  char path[MAX_OSPATH];
+  int i, size;
+  FILE *f;
+
+  size = Mod_BspCacheSize(loadmodel->numsurfaces, loadmodel->numnodes, loadmodel->numleafs);
+  mod_bspcache.data = malloc(size);
+  if (!mod_bspcache.data)
+    return;
+
+  Mod_SetBspCachePointers(loadmodel->numsurfaces, loadmodel->numnodes, loadmodel->numleafs);
+  mod_bspcache.header->ident = BSPCACHE_IDENT;
+  mod_bspcache.header->version = BSPCACHE_VERSION;
+  mod_bspcache.header->checksum = checksum;
+  mod_bspcache.header->numsurfaces = loadmodel->numsurfaces;
+  mod_bspcache.header->numnodes = loadmodel->numnodes;
+  mod_bspcache.header->numleafs = loadmodel->numleafs;
+  mod_bspcache.header->numvisleafs = r_numvisleafs;
+
+  for (i = 0; i < loadmodel->numsurfaces; i++) {
+    mod_bspcache.surfs[i].texturemins[0] = loadmodel->surfaces[i].texturemins[0];
+    mod_bspcache.surfs[i].texturemins[1] = loadmodel->surfaces[i].texturemins[1];
+    mod_bspcache.surfs[i].extents[0] = loadmodel->surfaces[i].extents[0];
+    mod_bspcache.surfs[i].extents[1] = loadmodel->surfaces[i].extents[1];
+  }
+
+  for (i = 0; i < loadmodel->numnodes; i++) {
+    mnode_t *parent = loadmodel->nodes[i].parent;
+    mod_bspcache.nodeparents[i] = parent ? parent - loadmodel->nodes : -1;
+  }
+
+  for (i = 0; i < loadmodel->numleafs; i++) {
+    mnode_t *parent = loadmodel->leafs[i].parent;
+    mod_bspcache.leafparents[i] = parent ? parent - loadmodel->nodes : -1;
+    mod_bspcache.leaftovis[i] = -1; // solid leafs are never numbered
+  }
+
+  for (i = 0; i < r_numvisleafs; i++)
+    mod_bspcache.leaftovis[r_vistoleaf[i]] = i;
+
+  Mod_BspCachePath(checksum, path, sizeof(path));
+  FS_CreatePath(path);
+  f = fopen(path, "wb");
+  if (!f)
+    return;
+
+  if (fwrite(mod_bspcache.data, 1, size, f) != (size_t) size) {
+    fclose(f);
+    remove(path);
+    return;
+  }
+  fclose(f);
+}
+
+/*
+=================
+Mod_SetCachedParents
+=================
+*/
+static void Mod_SetCachedParents(void)
+{
+  int i, p;
+
+  for (i = 0; i < loadmodel->numnodes; i++) {
+    p = mod_bspcache.nodeparents[i];
+    loadmodel->nodes[i].parent = (p >= 0 && p < loadmodel->numnodes) ? loadmodel->nodes + p : NULL;
+  }
+
+  for (i = 0; i < loadmodel->numleafs; i++) {
+    p = mod_bspcache.leafparents[i];
+    loadmodel->leafs[i].parent = (p >= 0 && p < loadmodel->numnodes) ? loadmodel->nodes + p : NULL;
+  }
+}
+
 /*
 =================
 Mod_LoadVisibility
@@ -598,7 +813,14 @@ void Mod_LoadFaces(lump_t *l)
 
     out->texinfo = loadmodel->texinfo + LittleShort(in->texinfo);
 
-    CalcSurfaceExtents(out);
+    if (mod_bspcache.surfs) {
+      for (i = 0; i < 2; i++) {
+        out->texturemins[i] = mod_bspcache.surfs[surfnum].texturemins[i];
+        out->extents[i] = mod_bspcache.surfs[surfnum].extents[i];
+      }
+    } else {
+      CalcSurfaceExtents(out);
+    }
 
     // lighting info is converted from 24 bit on disk to 8 bit
     for (i = 0; i < MAXLIGHTMAPS; i++)
@@ -702,7 +924,10 @@ void Mod_LoadNodes(lump_t *l)
     }
   }
 
-  Mod_SetParent(loadmodel->nodes, NULL); // sets nodes and leafs
+  if (mod_bspcache.nodeparents)
+    Mod_SetCachedParents();
+  else
+    Mod_SetParent(loadmodel->nodes, NULL); // sets nodes and leafs
 }
 
 /*
@@ -838,26 +1063,35 @@ void Mod_LoadBrushModel(model_t *mod, void *buffer)
 {
   int i;
   int lump_size;
-  dheader_t *header;
+  dheader_t *header, swapped;
   dmodel_t *bm;
 
   loadmodel->type = mod_brush;
   if (loadmodel != mod_known)
     Com_Error(ERR_DROP, "Loaded a brush model after the world");
 
-  header = (dheader_t *) buffer;
+  // the buffer may belong to the collision model, so swap a
+  // copy of the header rather than the file itself
+  swapped = *(dheader_t *) buffer;
+  header = &swapped;
 
   i = LittleLong(header->version);
   if (i != BSPVERSION)
     Com_Error(ERR_DROP, "Mod_LoadBrushModel: %s has wrong version number (%i should be %i)", mod->name, i, BSPVERSION);
 
   // swap all the lumps
-  mod_base = (byte *) header;
+  mod_base = (byte *) buffer;
   lump_size = sizeof(dheader_t) / 4;
 
   for (i = 0; i < lump_size; i++)
     ((int *) header)[i] = LittleLong(((int *) header)[i]);
 
+  if (r_bspcache->value) {
+    if (!mod_sharedfile)
+      mod_checksum = LittleLong(Com_BlockChecksum(buffer, modfilelen));
+    Mod_LoadBspCache(header, mod_checksum);
+  }
+
   // load into heap
   Mod_LoadVertexes(&header->lumps[LUMP_VERTEXES]);
   Mod_LoadEdges(&header->lumps[LUMP_EDGES]);
@@ -871,8 +1105,21 @@ void Mod_LoadBrushModel(model_t *mod, void *buffer)
   Mod_LoadLeafs(&header->lumps[LUMP_LEAFS]);
   Mod_LoadNodes(&header->lumps[LUMP_NODES]);
   Mod_LoadSubmodels(&header->lumps[LUMP_MODELS]);
-  r_numvisleafs = 0;
-  R_NumberLeafs(loadmodel->nodes);
+  if (mod_bspcache.leaftovis) {
+    r_numvisleafs = mod_bspcache.header->numvisleafs;
+    for (i = 0; i < loadmodel->numleafs; i++) {
+      r_leaftovis[i] = mod_bspcache.leaftovis[i];
+      if (r_leaftovis[i] >= 0 && r_leaftovis[i] < r_numvisleafs)
+        r_vistoleaf[r_leaftovis[i]] = i;
+    }
+  } else {
+    r_numvisleafs = 0;
+    R_NumberLeafs(loadmodel->nodes);
+  }
+
+  if (r_bspcache->value && !mod_bspcache.data)
+    Mod_WriteBspCache(mod_checksum);
+  Mod_FreeBspCache();
 
   //
   // set up the submodels
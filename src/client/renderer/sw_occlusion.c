@@ -0,0 +1,457 @@
+/*
+Copyright (C) 1997-2001 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// sw_occlusion.c: coarse front-to-back occlusion culling
+//
+// The world is emitted front to back, so every opaque face that made it into
+// the edge list hides whatever lies behind it. Each face marks the screen tiles
+// it covers completely with its farthest 1/z; a node or bmodel whose bounding
+// box projects onto tiles that are all covered by something nearer than the box
+// can never put a pixel on screen and is dropped before it emits any edges.
+//
+// The buffer is two levels deep: OCC_TILE pixel tiles, and blocks of
+// OCC_BLOCK x OCC_BLOCK tiles holding the minimum of their tiles so that big
+// boxes behind big walls are rejected without touching every tile.
+
+#include "header/local.h"
+
+#define OCC_TILESHIFT 4
+#define OCC_TILE (1 << OCC_TILESHIFT)
+#define OCC_BLOCKSHIFT 2
+#define OCC_BLOCK (1 << OCC_BLOCKSHIFT)
+#define OCC_MAXVERTS 64
+#define OCC_NEAR 1.0f // occluders and boxes closer than this are left alone
+
+int r_occludednodes;
+int r_occludedfaces;
+int r_occludedbmodels;
+
+static float *occ_tiles;  // farthest 1/z fully covering each tile, 0 if open
+static float *occ_blocks; // minimum of the tiles in each block
+static int occ_tilewidth, occ_tileheight;
+static int occ_blockwidth, occ_blockheight;
+static int occ_vidwidth, occ_vidheight;
+static int occ_tx0, occ_ty0, occ_tx1, occ_ty1; // tiles overlapping r_refdef.vrect
+
+static int *occ_nodefaces; // faces in each world node's subtree
+static int occ_numnodes;
+
+/*
+================
+R_OcclusionNewMap
+
+Counts the faces under every node so culled subtrees can be reported
+================
+*/
+static int R_CountNodeFaces(mnode_t *node)
+{
+  int count;
+
+  if (node->contents != CONTENTS_NODE)
+    return 0;
+
+  count = node->numsurfaces + R_CountNodeFaces(node->children[0]) + R_CountNodeFaces(node->children[1]);
+  occ_nodefaces[node - r_worldmodel->nodes] = count;
+
+  return count;
+}
+
+void R_OcclusionNewMap(void)
+{
+  free(occ_nodefaces);
+  occ_nodefaces = NULL;
+  occ_numnodes = 0;
+
+  if (!r_worldmodel || !r_worldmodel->numnodes)
+    return;
+
+  occ_nodefaces = malloc(r_worldmodel->numnodes * sizeof(*occ_nodefaces));
+  if (!occ_nodefaces)
+    return;
+
+  occ_numnodes = r_worldmodel->numnodes;
+  R_CountNodeFaces(r_worldmodel->nodes);
+}
+
+/*
+================
+R_FreeOcclusion
+================
+*/
+void R_FreeOcclusion(void)
+{
+  free(occ_tiles);
+  free(occ_blocks);
+  free(occ_nodefaces);
+  occ_tiles = occ_blocks = NULL;
+  occ_nodefaces = NULL;
+  occ_vidwidth = occ_vidheight = 0;
+  occ_numnodes = 0;
+}
+
+/*
+================
+R_ClearOcclusion
+
+Called before the world is walked; resizes the buffer with the video mode
+================
+*/
+void R_ClearOcclusion(void)
+{
+  if (vid.width != occ_vidwidth || vid.height != occ_vidheight || !occ_tiles) {
+    free(occ_tiles);
+    free(occ_blocks);
+
+    occ_tilewidth = (vid.width + OCC_TILE - 1) >> OCC_TILESHIFT;
+    occ_tileheight = (vid.height + OCC_TILE - 1) >> OCC_TILESHIFT;
+    occ_blockwidth = (occ_tilewidth + OCC_BLOCK - 1) >> OCC_BLOCKSHIFT;
+    occ_blockheight = (occ_tileheight + OCC_BLOCK - 1) >> OCC_BLOCKSHIFT;
+
+    // pad the tile rows out to whole blocks so block scans never leave the array
+    occ_tiles = malloc((occ_blockwidth << OCC_BLOCKSHIFT) * (occ_blockheight << OCC_BLOCKSHIFT) * sizeof(float));
+    occ_blocks = malloc(occ_blockwidth * occ_blockheight * sizeof(float));
+    if (!occ_tiles || !occ_blocks) {
+      free(occ_tiles);
+      free(occ_blocks);
+      occ_tiles = occ_blocks = NULL;
+      occ_vidwidth = occ_vidheight = 0;
+      return;
+    }
+
+    occ_vidwidth = vid.width;
+    occ_vidheight = vid.height;
+  }
+
+  memset(occ_tiles, 0, (occ_blockwidth << OCC_BLOCKSHIFT) * (occ_blockheight << OCC_BLOCKSHIFT) * sizeof(float));
+  memset(occ_blocks, 0, occ_blockwidth * occ_blockheight * sizeof(float));
+
+  occ_tx0 = r_refdef.vrect.x >> OCC_TILESHIFT;
+  occ_ty0 = r_refdef.vrect.y >> OCC_TILESHIFT;
+  occ_tx1 = (r_refdef.vrectright - 1) >> OCC_TILESHIFT;
+  occ_ty1 = (r_refdef.vrectbottom - 1) >> OCC_TILESHIFT;
+}
+
+/*
+================
+R_OcclusionActive
+================
+*/
+static qboolean R_OcclusionActive(void)
+{
+  // drawing back to front would let hidden surfaces show through
+  return r_occlusion->value && !sw_draworder->value && occ_tiles != NULL;
+}
+
+/*
+================
+R_PolygonSpan
+
+Horizontal extent of a convex polygon on scanline y
+================
+*/
+static qboolean R_PolygonSpan(float (*pts)[2], int numpts, float y, float *left, float *right)
+{
+  int i;
+  qboolean hit;
+
+  hit = false;
+  *left = 999999;
+  *right = -999999;
+
+  for (i = 0; i < numpts; i++) {
+    float *a, *b;
+    float x;
+
+    a = pts[i];
+    b = pts[(i + 1) % numpts];
+
+    if ((y < a[1] && y < b[1]) || (y > a[1] && y > b[1]))
+      continue;
+
+    if (a[1] == b[1]) {
+      x = a[0] < b[0] ? a[0] : b[0];
+      if (x < *left)
+        *left = x;
+      x = a[0] > b[0] ? a[0] : b[0];
+      if (x > *right)
+        *right = x;
+    } else {
+      x = a[0] + (y - a[1]) * (b[0] - a[0]) / (b[1] - a[1]);
+      if (x < *left)
+        *left = x;
+      if (x > *right)
+        *right = x;
+    }
+    hit = true;
+  }
+
+  return hit;
+}
+
+/*
+================
+R_OccludeFace
+
+Marks the tiles fully covered by a world face that was just emitted
+================
+*/
+void R_OccludeFace(msurface_t *fa)
+{
+  float pts[OCC_MAXVERTS][2];
+  float zifar, ymin, ymax;
+  int i, tx, ty, bx, by;
+  int rowx0, rowx1, minbx, maxbx, minby, maxby;
+  int *pedges;
+  medge_t *edges;
+
+  if (!R_OcclusionActive())
+    return;
+  if (fa->texinfo->flags & (SURF_SKY | SURF_TRANS33 | SURF_TRANS66 | SURF_NODRAW))
+    return;
+  if (fa->numedges < 3 || fa->numedges > OCC_MAXVERTS)
+    return;
+
+  pedges = r_worldmodel->surfedges + fa->firstedge;
+  edges = r_worldmodel->edges;
+  zifar = 999999;
+  ymin = 999999;
+  ymax = -999999;
+
+  for (i = 0; i < fa->numedges; i++) {
+    vec3_t local, transformed;
+    float *v, zi;
+    int lindex;
+
+    lindex = pedges[i];
+    if (lindex > 0)
+      v = r_pcurrentvertbase[edges[lindex].v[0]].position;
+    else
+      v = r_pcurrentvertbase[edges[-lindex].v[1]].position;
+
+    VectorSubtract(v, r_origin, local);
+    TransformVector(local, transformed);
+
+    if (transformed[2] < OCC_NEAR)
+      return; // crosses the near plane, projection is meaningless
+
+    zi = 1.0f / transformed[2];
+    if (zi < zifar)
+      zifar = zi;
+
+    pts[i][0] = xcenter + xscale * transformed[0] * zi;
+    pts[i][1] = ycenter - yscale * transformed[1] * zi;
+
+    if (pts[i][1] < ymin)
+      ymin = pts[i][1];
+    if (pts[i][1] > ymax)
+      ymax = pts[i][1];
+  }
+
+  // only rows of tiles that lie completely inside the polygon, with a pixel of
+  // slack for the rasterizer's rounding
+  ty = (int) ceil((ymin + 1) / OCC_TILE);
+  if (ty < occ_ty0)
+    ty = occ_ty0;
+
+  minbx = minby = 0x7fffffff;
+  maxbx = maxby = -1;
+
+  for (; ty <= occ_ty1; ty++) {
+    float y0, y1, l0, r0, l1, r1, l, r;
+    float *tile;
+
+    y0 = (ty << OCC_TILESHIFT) - 1;
+    y1 = ((ty + 1) << OCC_TILESHIFT) + 1;
+    if (y1 > ymax)
+      break;
+
+    // the polygon is convex, so the band is covered between the innermost
+    // edges at its top and bottom
+    if (!R_PolygonSpan(pts, fa->numedges, y0, &l0, &r0) || !R_PolygonSpan(pts, fa->numedges, y1, &l1, &r1))
+      continue;
+    l = (l0 > l1 ? l0 : l1) + 1;
+    r = (r0 < r1 ? r0 : r1) - 1;
+    if (r - l < OCC_TILE)
+      continue;
+
+    rowx0 = (int) ceil(l / OCC_TILE);
+    rowx1 = (int) floor(r / OCC_TILE) - 1;
+    if (rowx0 < occ_tx0)
+      rowx0 = occ_tx0;
+    if (rowx1 > occ_tx1)
+      rowx1 = occ_tx1;
+    if (rowx0 > rowx1)
+      continue;
+
+    tile = occ_tiles + ty * (occ_blockwidth << OCC_BLOCKSHIFT);
+    for (tx = rowx0; tx <= rowx1; tx++) {
+      if (tile[tx] < zifar)
+        tile[tx] = zifar;
+    }
+
+    if (rowx0 >> OCC_BLOCKSHIFT < minbx)
+      minbx = rowx0 >> OCC_BLOCKSHIFT;
+    if (rowx1 >> OCC_BLOCKSHIFT > maxbx)
+      maxbx = rowx1 >> OCC_BLOCKSHIFT;
+    if (ty >> OCC_BLOCKSHIFT < minby)
+      minby = ty >> OCC_BLOCKSHIFT;
+    maxby = ty >> OCC_BLOCKSHIFT;
+  }
+
+  // refresh the blocks that were touched
+  for (by = minby; by <= maxby; by++) {
+    for (bx = minbx; bx <= maxbx; bx++) {
+      float *tile, m;
+      int x, y;
+
+      tile = occ_tiles + (by << OCC_BLOCKSHIFT) * (occ_blockwidth << OCC_BLOCKSHIFT) + (bx << OCC_BLOCKSHIFT);
+      m = tile[0];
+      for (y = 0; y < OCC_BLOCK; y++, tile += occ_blockwidth << OCC_BLOCKSHIFT) {
+        for (x = 0; x < OCC_BLOCK; x++) {
+          if (tile[x] < m)
+            m = tile[x];
+        }
+      }
+      occ_blocks[by * occ_blockwidth + bx] = m;
+    }
+  }
+}
+
+/*
+================
+R_OccludedBBox
+
+True if the world space box is hidden behind faces already emitted
+================
+*/
+qboolean R_OccludedBBox(float *minmaxs)
+{
+  float umin, umax, vmin, vmax, zinear;
+  int i, tx0, ty0, tx1, ty1, bx, by;
+
+  if (!R_OcclusionActive())
+    return false;
+
+  umin = vmin = 999999;
+  umax = vmax = -999999;
+  zinear = 0;
+
+  for (i = 0; i < 8; i++) {
+    vec3_t local, transformed;
+    float u, v, zi;
+
+    local[0] = minmaxs[(i & 1) ? 3 : 0] - r_origin[0];
+    local[1] = minmaxs[(i & 2) ? 4 : 1] - r_origin[1];
+    local[2] = minmaxs[(i & 4) ? 5 : 2] - r_origin[2];
+    TransformVector(local, transformed);
+
+    if (transformed[2] < OCC_NEAR)
+      return false;
+
+    zi = 1.0f / transformed[2];
+    if (zi > zinear)
+      zinear = zi;
+
+    u = xcenter + xscale * transformed[0] * zi;
+    v = ycenter - yscale * transformed[1] * zi;
+    if (u < umin)
+      umin = u;
+    if (u > umax)
+      umax = u;
+    if (v < vmin)
+      vmin = v;
+    if (v > vmax)
+      vmax = v;
+  }
+
+  // every tile the box touches must be covered by something nearer
+  tx0 = (int) floor(umin) >> OCC_TILESHIFT;
+  tx1 = (int) floor(umax) >> OCC_TILESHIFT;
+  ty0 = (int) floor(vmin) >> OCC_TILESHIFT;
+  ty1 = (int) floor(vmax) >> OCC_TILESHIFT;
+  if (tx0 < occ_tx0)
+    tx0 = occ_tx0;
+  if (tx1 > occ_tx1)
+    tx1 = occ_tx1;
+  if (ty0 < occ_ty0)
+    ty0 = occ_ty0;
+  if (ty1 > occ_ty1)
+    ty1 = occ_ty1;
+  if (tx0 > tx1 || ty0 > ty1)
+    return false; // off screen; the frustum checks own that case
+
+  for (by = ty0 >> OCC_BLOCKSHIFT; by <= ty1 >> OCC_BLOCKSHIFT; by++) {
+    for (bx = tx0 >> OCC_BLOCKSHIFT; bx <= tx1 >> OCC_BLOCKSHIFT; bx++) {
+      int x, y, x0, x1, y0, y1;
+
+      if (occ_blocks[by * occ_blockwidth + bx] > zinear)
+        continue; // the whole block is hidden
+
+      x0 = bx << OCC_BLOCKSHIFT;
+      x1 = x0 + OCC_BLOCK - 1;
+      y0 = by << OCC_BLOCKSHIFT;
+      y1 = y0 + OCC_BLOCK - 1;
+      if (x0 < tx0)
+        x0 = tx0;
+      if (x1 > tx1)
+        x1 = tx1;
+      if (y0 < ty0)
+        y0 = ty0;
+      if (y1 > ty1)
+        y1 = ty1;
+
+      for (y = y0; y <= y1; y++) {
+        float *tile;
+
+        tile = occ_tiles + y * (occ_blockwidth << OCC_BLOCKSHIFT);
+        for (x = x0; x <= x1; x++) {
+          if (tile[x] <= zinear)
+            return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+/*
+================
+R_OccludedNode
+================
+*/
+qboolean R_OccludedNode(mnode_t *node)
+{
+  float minmaxs[6];
+  int i;
+
+  for (i = 0; i < 6; i++)
+    minmaxs[i] = node->minmaxs[i];
+
+  if (!R_OccludedBBox(minmaxs))
+    return false;
+
+  r_occludednodes++;
+  if (node->contents == CONTENTS_NODE && node - r_worldmodel->nodes < occ_numnodes)
+    r_occludedfaces += occ_nodefaces[node - r_worldmodel->nodes];
+  else if (node->contents != CONTENTS_NODE)
+    r_occludedfaces += ((mleaf_t *) node)->nummarksurfaces;
+
+  return true;
+}
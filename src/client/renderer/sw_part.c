@@ -25,42 +25,38 @@ vec3_t r_pright, r_pup, r_ppn;
 #define PARTICLE_66 1
 #define PARTICLE_OPAQUE 2
 
+#define PARTICLE_BANDSHIFT 5 // particles are binned into 32 scanline bands
+
 typedef struct
 {
-  particle_t *particle;
+  int u, v; // top left pixel
+  int izi;
+  int pix;
   int level;
   int color;
-} partparms_t;
+} projparticle_t;
+
+static projparticle_t *r_projparticles;
+static int r_numallocatedprojparticles;
 
-static partparms_t partparms;
+static int *r_particlebins; // projected particle indexes, sorted by band
+static int r_numallocatedbins;
+
+static int *r_bandstart; // first bin entry of each band
+static int r_numallocatedbands;
 
 /*
-** R_DrawParticle
+** R_ProjectParticle
 **
-** Yes, this is amazingly slow, but it's the C reference
-** implementation and should be both robust and vaguely
-** understandable.  The only time this path should be
-** executed is if we're debugging on x86 or if we're
-** recompiling and deploying on a non-x86 platform.
-**
-** To minimize error and improve readability I went the
-** function pointer route.  This exacts some overhead, but
-** it pays off in clean and easy to understand code.
+** Transforms and clips a particle and works out the square
+** it covers on screen.
 */
-void R_DrawParticle(void)
+static qboolean R_ProjectParticle(particle_t *pparticle, projparticle_t *pp)
 {
-  particle_t *pparticle = partparms.particle;
-  int level = partparms.level;
   vec3_t local, transformed;
   float zi;
-  byte *pdest;
-  zvalue_t *pz;
-  int color = pparticle->color;
-  int i, izi, pix, count, u, v;
+  int pix;
 
-  /*
-  ** transform the particle
-  */
   VectorSubtract(pparticle->origin, r_origin, local);
 
   transformed[0] = DotProduct(local, r_pright);
@@ -68,44 +64,74 @@ void R_DrawParticle(void)
   transformed[2] = DotProduct(local, r_ppn);
 
   if (transformed[2] < PARTICLE_Z_CLIP)
-    return;
+    return false;
 
-  /*
-  ** project the point
-  */
   // FIXME: preadjust xcenter and ycenter
   zi = 1.0 / transformed[2];
-  u = (int) (xcenter + zi * transformed[0] + 0.5);
-  v = (int) (ycenter - zi * transformed[1] + 0.5);
+  pp->u = (int) (xcenter + zi * transformed[0] + 0.5);
+  pp->v = (int) (ycenter - zi * transformed[1] + 0.5);
 
-  if ((v > d_vrectbottom_particle) || (u > d_vrectright_particle) || (v < d_vrecty) || (u < d_vrectx)) {
-    return;
+  if ((pp->v > d_vrectbottom_particle) || (pp->u > d_vrectright_particle) || (pp->v < d_vrecty) ||
+      (pp->u < d_vrectx)) {
+    return false;
   }
 
-  /*
-  ** compute addresses of zbuffer, framebuffer, and
-  ** compute the Z-buffer reference value.
-  */
-  pz = d_pzbuffer + (d_zwidth * v) + u;
-  pdest = d_viewbuffer + r_screenwidth * v + u;
-  izi = (int) (zi * 0x8000);
+  pp->izi = (int) (zi * 0x8000);
 
   /*
   ** determine the screen area covered by the particle,
   ** which also means clamping to a min and max
   */
-  pix = izi >> d_pix_shift;
+  pix = pp->izi >> d_pix_shift;
   if (pix < d_pix_min)
     pix = d_pix_min;
   else if (pix > d_pix_max)
     pix = d_pix_max;
+  pp->pix = pix;
 
-  /*
-  ** render the appropriate pixels
-  */
+  if (pparticle->alpha > 0.66)
+    pp->level = PARTICLE_OPAQUE;
+  else if (pparticle->alpha > 0.33)
+    pp->level = PARTICLE_66;
+  else
+    pp->level = PARTICLE_33;
+
+  pp->color = pparticle->color;
+
+  return true;
+}
+
+/*
+** R_DrawParticle
+**
+** Draws the scanlines of a projected particle that fall
+** between top and bottom, so every band can be filled
+** on its own.
+*/
+static void R_DrawParticle(projparticle_t *pp, int top, int bottom)
+{
+  byte *pdest;
+  zvalue_t *pz;
+  int color = pp->color;
+  int izi = pp->izi;
+  int pix = pp->pix;
+  int i, count, v;
+
+  v = pp->v;
   count = pix;
+  if (v < top) {
+    count -= top - v;
+    v = top;
+  }
+  if (v + count > bottom)
+    count = bottom - v;
+  if (count <= 0)
+    return;
+
+  pz = d_pzbuffer + (d_zwidth * v) + pp->u;
+  pdest = d_viewbuffer + r_screenwidth * v + pp->u;
 
-  switch (level) {
+  switch (pp->level) {
   case PARTICLE_33:
     for (; count; count--, pz += d_zwidth, pdest += r_screenwidth) {
       // FIXME--do it in blocks of 8?
@@ -142,35 +168,101 @@ void R_DrawParticle(void)
   }
 }
 
+/*
+** R_GrowParticleArray
+*/
+static void *R_GrowParticleArray(void *array, int *allocated, int needed, int size)
+{
+  if (needed <= *allocated)
+    return array;
+
+  needed += needed >> 1;
+  array = realloc(array, needed * size);
+  if (!array)
+    Com_Error(ERR_FATAL, "R_DrawParticles: couldn't allocate %i particles", needed);
+  *allocated = needed;
+
+  return array;
+}
+
 /*
 ** R_DrawParticles
 **
 ** Responsible for drawing all of the particles in the particle list
-** throughout the world.  Doesn't care if we're using the C path or
-** if we're using the asm path, it simply assigns a function pointer
-** and goes.
+** throughout the world. Particles are projected first and binned
+** into horizontal bands of the screen; each band is then filled on
+** its own, which keeps the frame and z-buffer rows that are being
+** written in cache and leaves the bands independent of each other.
 */
 void R_DrawParticles(void)
 {
+  projparticle_t *pp;
   particle_t *p;
-  int i;
+  int i, b, numprojected, numbands, numbins;
+
+  if (!r_newrefdef.num_particles)
+    return;
 
   VectorScale(vright, xscaleshrink, r_pright);
   VectorScale(vup, yscaleshrink, r_pup);
   VectorCopy(vpn, r_ppn);
 
+  numbands = ((r_refdef.vrectbottom - 1) >> PARTICLE_BANDSHIFT) + 1;
+  r_projparticles = R_GrowParticleArray(r_projparticles, &r_numallocatedprojparticles, r_newrefdef.num_particles,
+                                        sizeof(*r_projparticles));
+  r_bandstart = R_GrowParticleArray(r_bandstart, &r_numallocatedbands, numbands + 1, sizeof(*r_bandstart));
+  memset(r_bandstart, 0, (numbands + 1) * sizeof(*r_bandstart));
+
+  // project, counting how many particles touch each band
+  numprojected = 0;
+  numbins = 0;
+  pp = r_projparticles;
   for (p = r_newrefdef.particles, i = 0; i < r_newrefdef.num_particles; i++, p++) {
+    if (!R_ProjectParticle(p, pp))
+      continue;
 
-    if (p->alpha > 0.66)
-      partparms.level = PARTICLE_OPAQUE;
-    else if (p->alpha > 0.33)
-      partparms.level = PARTICLE_66;
-    else
-      partparms.level = PARTICLE_33;
+    for (b = pp->v >> PARTICLE_BANDSHIFT; b <= (pp->v + pp->pix - 1) >> PARTICLE_BANDSHIFT; b++) {
+      r_bandstart[b + 1]++;
+      numbins++;
+    }
+
+    numprojected++;
+    pp++;
+  }
 
-    partparms.particle = p;
-    partparms.color = p->color;
+  if (!numprojected)
+    return;
 
-    R_DrawParticle();
+  for (b = 0; b < numbands; b++)
+    r_bandstart[b + 1] += r_bandstart[b];
+
+  // sort into the bands
+  r_particlebins = R_GrowParticleArray(r_particlebins, &r_numallocatedbins, numbins, sizeof(*r_particlebins));
+  for (i = 0, pp = r_projparticles; i < numprojected; i++, pp++) {
+    for (b = pp->v >> PARTICLE_BANDSHIFT; b <= (pp->v + pp->pix - 1) >> PARTICLE_BANDSHIFT; b++)
+      r_particlebins[r_bandstart[b]++] = i;
   }
+
+  // r_bandstart[b] now holds the end of band b
+  for (b = 0, i = 0; b < numbands; b++) {
+    int top;
+
+    top = b << PARTICLE_BANDSHIFT;
+    for (; i < r_bandstart[b]; i++)
+      R_DrawParticle(&r_projparticles[r_particlebins[i]], top, top + (1 << PARTICLE_BANDSHIFT));
+  }
+}
+
+/*
+** R_FreeParticles
+*/
+void R_FreeParticles(void)
+{
+  free(r_projparticles);
+  free(r_particlebins);
+  free(r_bandstart);
+  r_projparticles = NULL;
+  r_particlebins = NULL;
+  r_bandstart = NULL;
+  r_numallocatedprojparticles = r_numallocatedbins = r_numallocatedbands = 0;
 }
@@ -478,14 +478,14 @@ void R_RenderFace(msurface_t *fa, int clipflags)
     return;
   }
 
-  // skip out if no more surfs
-  if ((surface_p) >= surf_max) {
+  // skip out if no more surfs and the arena can't grow
+  if (surface_p >= surf_max && !R_GrowSurfaces()) {
     r_outofsurfaces++;
     return;
   }
 
-  // ditto if not enough edges left, or switch to auxedges if possible
-  if ((edge_p + fa->numedges + 4) >= edge_max) {
+  // ditto if not enough edges left
+  if ((edge_p + fa->numedges + 4) >= edge_max && !R_GrowEdges(fa->numedges + 4)) {
     r_outofedges += fa->numedges;
     return;
   }
@@ -648,14 +648,14 @@ void R_RenderBmodelFace(bedge_t *pedges, msurface_t *psurf)
     return;
   }
 
-  // skip out if no more surfs
-  if (surface_p >= surf_max) {
+  // skip out if no more surfs and the arena can't grow
+  if (surface_p >= surf_max && !R_GrowSurfaces()) {
     r_outofsurfaces++;
     return;
   }
 
-  // ditto if not enough edges left, or switch to auxedges if possible
-  if ((edge_p + psurf->numedges + 4) >= edge_max) {
+  // ditto if not enough edges left
+  if ((edge_p + psurf->numedges + 4) >= edge_max && !R_GrowEdges(psurf->numedges + 4)) {
     r_outofedges += psurf->numedges;
     return;
   }
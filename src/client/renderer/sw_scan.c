@@ -365,38 +365,171 @@ void NonTurbulent8(espan_t *pspan)
 // PGM
 //====================
 
+/*
+=============
+D_DrawSpanRun
+
+Writes one perspective-correct run of at most 16 texels. s and t step
+linearly across the run; u and v are the screen position of the first pixel
+and select the dither kernel entries when r_udither is on.
+=============
+*/
+static void D_DrawSpanRun(pixel_t *pdest, const unsigned char *pbase, int count, int s, int t, int sstep, int tstep,
+                          int u, int v, qboolean dither)
+{
+#ifdef SW_SSE2
+  int offsets[16];
+  int i;
+  __m128i vs, vt, vsstep, vtstep, vsmask, vwidth;
+  __m128i vds, vdt, vextents, vextentt;
+
+  // four texels per lane group; the texel offset (s >> 16) + (t >> 16) *
+  // cachewidth is one multiply-add of the packed 16-bit integer parts
+  vs = _mm_add_epi32(_mm_set1_epi32(s), _mm_set_epi32(sstep * 3, sstep * 2, sstep, 0));
+  vt = _mm_add_epi32(_mm_set1_epi32(t), _mm_set_epi32(tstep * 3, tstep * 2, tstep, 0));
+  vsstep = _mm_set1_epi32(sstep * 4);
+  vtstep = _mm_set1_epi32(tstep * 4);
+  vsmask = _mm_set1_epi32((int) 0xffff0000);
+  vwidth = _mm_set1_epi32((1 << 16) | cachewidth);
+
+  if (dither) {
+    const int(*kernel)[2] = r_ditherkernel[v & 1];
+    int x0 = u & 1;
+    int x1 = x0 ^ 1;
+
+    vds = _mm_set_epi32(kernel[x1][0], kernel[x0][0], kernel[x1][0], kernel[x0][0]);
+    vdt = _mm_set_epi32(kernel[x1][1], kernel[x0][1], kernel[x1][1], kernel[x0][1]);
+    vextents = _mm_set1_epi32(bbextents);
+    vextentt = _mm_set1_epi32(bbextentt);
+
+    for (i = 0; i < count; i += 4) {
+      __m128i ds = _mm_add_epi32(vs, vds);
+      __m128i dt = _mm_add_epi32(vt, vdt);
+      __m128i over;
+
+      // clamp to texture bounds to prevent artifacts at edges
+      over = _mm_cmpgt_epi32(ds, vextents);
+      ds = _mm_or_si128(_mm_and_si128(over, vextents), _mm_andnot_si128(over, ds));
+      over = _mm_cmpgt_epi32(dt, vextentt);
+      dt = _mm_or_si128(_mm_and_si128(over, vextentt), _mm_andnot_si128(over, dt));
+
+      _mm_storeu_si128((__m128i *) &offsets[i],
+                       _mm_madd_epi16(_mm_or_si128(_mm_and_si128(ds, vsmask), _mm_srli_epi32(dt, 16)), vwidth));
+      vs = _mm_add_epi32(vs, vsstep);
+      vt = _mm_add_epi32(vt, vtstep);
+    }
+  } else {
+    for (i = 0; i < count; i += 4) {
+      _mm_storeu_si128((__m128i *) &offsets[i],
+                       _mm_madd_epi16(_mm_or_si128(_mm_and_si128(vs, vsmask), _mm_srli_epi32(vt, 16)), vwidth));
+      vs = _mm_add_epi32(vs, vsstep);
+      vt = _mm_add_epi32(vt, vtstep);
+    }
+  }
+
+  for (i = 0; i < count; i++)
+    pdest[i] = pbase[offsets[i]];
+#else
+  if (!dither) {
+    do {
+      *pdest++ = *(pbase + (s >> 16) + (t >> 16) * cachewidth);
+      s += sstep;
+      t += tstep;
+    } while (--count > 0);
+  } else {
+    const int(*kernel)[2] = r_ditherkernel[v & 1];
+
+    do {
+      int idiths = s + kernel[u & 1][0];
+      int iditht = t + kernel[u & 1][1];
+
+      /* Clamp to texture bounds to prevent artifacts at edges */
+      if (idiths > bbextents)
+        idiths = bbextents;
+      if (iditht > bbextentt)
+        iditht = bbextentt;
+
+      *pdest++ = *(pbase + (idiths >> 16) + (iditht >> 16) * cachewidth);
+      s += sstep;
+      t += tstep;
+      u++;
+    } while (--count > 0);
+  }
+#endif
+}
+
+/*
+=============
+D_DrawZSpan
+=============
+*/
+static void D_DrawZSpan(zvalue_t *pdest, int count, int izi, int izistep)
+{
+#ifdef SW_SSE2
+  if (count >= 4) {
+    __m128i vizi = _mm_add_epi32(_mm_set1_epi32(izi), _mm_set_epi32(izistep * 3, izistep * 2, izistep, 0));
+    __m128i vizistep = _mm_set1_epi32(izistep * 4);
+
+    do {
+      _mm_storeu_si128((__m128i *) pdest, _mm_srai_epi32(vizi, 16));
+      vizi = _mm_add_epi32(vizi, vizistep);
+      pdest += 4;
+      count -= 4;
+    } while (count >= 4);
+
+    izi = _mm_cvtsi128_si32(vizi);
+  }
+#endif
+
+  while (count > 0) {
+    *pdest++ = izi >> 16;
+    izi += izistep;
+    count--;
+  }
+}
+
 /*
 =============
 D_DrawSpans16
 
-  FIXME: actually make this subdivide by 16 instead of 8!!!
+Texture maps the spans with a perspective divide every 16 pixels. When drawz
+is set the 1/z values are written to the z-buffer in the same pass, which
+saves walking the span list a second time.
 =============
 */
-void D_DrawSpans16(espan_t *pspan)
+void D_DrawSpans16(espan_t *pspan, qboolean drawz)
 {
   int spancount;
   unsigned char *pbase;
   int snext, tnext, sstep, tstep;
+  int izistep;
   float spancountminus1;
-  float sdivz8stepu, tdivz8stepu, zi8stepu;
+  float sdivz16stepu, tdivz16stepu, zi16stepu;
+  qboolean dither;
 
   sstep = 0; // keep compiler happy
   tstep = 0; // ditto
 
   pbase = (unsigned char *) cacheblock;
 
-  sdivz8stepu = d_sdivzstepu * 8;
-  tdivz8stepu = d_tdivzstepu * 8;
-  zi8stepu = d_zistepu * 8;
+  sdivz16stepu = d_sdivzstepu * 16;
+  tdivz16stepu = d_tdivzstepu * 16;
+  zi16stepu = d_zistepu * 16;
+
+  // we count on FP exceptions being turned off to avoid range problems
+  izistep = (int) (d_zistepu * 0x8000 * 0x10000);
+
+  dither = r_udither->value != 0;
 
   do {
     pixel_t *pdest;
-    int count, s, t;
+    int count, s, t, u;
     float sdivz, tdivz, zi, z, du, dv;
 
     pdest = d_viewbuffer + (r_screenwidth * pspan->v) + pspan->u;
 
     count = pspan->count;
+    u = pspan->u;
 
     // calculate the initial s/z, t/z, 1/z, s, and t and clamp
     du = (float) pspan->u;
@@ -407,6 +540,9 @@ void D_DrawSpans16(espan_t *pspan)
     zi = d_ziorigin + dv * d_zistepv + du * d_zistepu;
     z = (float) 0x10000 / zi; // prescale to 16.16 fixed-point
 
+    if (drawz)
+      D_DrawZSpan(d_pzbuffer + (d_zwidth * pspan->v) + pspan->u, count, (int) (zi * 0x8000 * 0x10000), izistep);
+
     s = (int) (sdivz * z) + sadjust;
     if (s > bbextents)
       s = bbextents;
@@ -421,8 +557,8 @@ void D_DrawSpans16(espan_t *pspan)
 
     do {
       // calculate s and t at the far end of the span
-      if (count >= 8)
-        spancount = 8;
+      if (count >= 16)
+        spancount = 16;
       else
         spancount = count;
 
@@ -431,27 +567,27 @@ void D_DrawSpans16(espan_t *pspan)
       if (count) {
         // calculate s/z, t/z, zi->fixed s and t at far end of span,
         // calculate s and t steps across span by shifting
-        sdivz += sdivz8stepu;
-        tdivz += tdivz8stepu;
-        zi += zi8stepu;
+        sdivz += sdivz16stepu;
+        tdivz += tdivz16stepu;
+        zi += zi16stepu;
         z = (float) 0x10000 / zi; // prescale to 16.16 fixed-point
 
         snext = (int) (sdivz * z) + sadjust;
         if (snext > bbextents)
           snext = bbextents;
-        else if (snext < 8)
-          snext = 8; // prevent round-off error on <0 steps from
+        else if (snext < 16)
+          snext = 16; // prevent round-off error on <0 steps from
         //  from causing overstepping & running off the
         //  edge of the texture
 
         tnext = (int) (tdivz * z) + tadjust;
         if (tnext > bbextentt)
           tnext = bbextentt;
-        else if (tnext < 8)
-          tnext = 8; // guard against round-off error on <0 steps
+        else if (tnext < 16)
+          tnext = 16; // guard against round-off error on <0 steps
 
-        sstep = (snext - s) >> 3;
-        tstep = (tnext - t) >> 3;
+        sstep = (snext - s) >> 4;
+        tstep = (tnext - t) >> 4;
       } else {
         // calculate s/z, t/z, zi->fixed s and t at last pixel in span (so
         // can't step off polygon), clamp, calculate s and t steps across
@@ -465,16 +601,16 @@ void D_DrawSpans16(espan_t *pspan)
         snext = (int) (sdivz * z) + sadjust;
         if (snext > bbextents)
           snext = bbextents;
-        else if (snext < 8)
-          snext = 8; // prevent round-off error on <0 steps from
+        else if (snext < 16)
+          snext = 16; // prevent round-off error on <0 steps from
         //  from causing overstepping & running off the
         //  edge of the texture
 
         tnext = (int) (tdivz * z) + tadjust;
         if (tnext > bbextentt)
           tnext = bbextentt;
-        else if (tnext < 8)
-          tnext = 8; // guard against round-off error on <0 steps
+        else if (tnext < 16)
+          tnext = 16; // guard against round-off error on <0 steps
 
         if (spancount > 1) {
           sstep = (snext - s) / (spancount - 1);
@@ -482,35 +618,9 @@ void D_DrawSpans16(espan_t *pspan)
         }
       }
 
-      if (r_udither->value == 0) {
-        do {
-          *pdest++ = *(pbase + (s >> 16) + (t >> 16) * cachewidth);
-          s += sstep;
-          t += tstep;
-        } while (--spancount > 0);
-      } else {
-        int sc = spancount;
-        do {
-          int idiths = s;
-          int iditht = t;
-
-          int X = (pspan->u + (sc - spancount)) & 1;
-          int Y = pspan->v & 1;
-
-          idiths += r_ditherkernel[Y][X][0];
-          iditht += r_ditherkernel[Y][X][1];
-
-          /* Clamp to texture bounds to prevent artifacts at edges */
-          if (idiths > bbextents)
-            idiths = bbextents;
-          if (iditht > bbextentt)
-            iditht = bbextentt;
-
-          *pdest++ = *(pbase + (idiths >> 16) + (iditht >> 16) * cachewidth);
-          s += sstep;
-          t += tstep;
-        } while (--spancount > 0);
-      }
+      D_DrawSpanRun(pdest, pbase, spancount, s, t, sstep, tstep, u, pspan->v, dither);
+      pdest += spancount;
+      u += spancount;
 
       s = snext;
       t = tnext;
@@ -534,28 +644,15 @@ void D_DrawZSpans(espan_t *pspan)
   izistep = (int) (d_zistepu * 0x8000 * 0x10000);
 
   do {
-    int count;
-    int izi;
-    zvalue_t *pdest;
     float zi;
     float du, dv;
 
-    pdest = d_pzbuffer + (d_zwidth * pspan->v) + pspan->u;
-
-    count = pspan->count;
-
     // calculate the initial 1/z
     du = (float) pspan->u;
     dv = (float) pspan->v;
 
     zi = d_ziorigin + dv * d_zistepv + du * d_zistepu;
     // we count on FP exceptions being turned off to avoid range problems
-    izi = (int) (zi * 0x8000 * 0x10000);
-
-    while (count > 0) {
-      *pdest++ = izi >> 16;
-      izi += izistep;
-      count--;
-    }
+    D_DrawZSpan(d_pzbuffer + (d_zwidth * pspan->v) + pspan->u, pspan->count, (int) (zi * 0x8000 * 0x10000), izistep);
   } while ((pspan = pspan->pnext) != NULL);
 }
@@ -65,6 +65,9 @@ typedef struct
 } carea_t;
 
 byte *cmod_base;
+byte *map_file; /* the raw .bsp, kept for the renderer */
+int map_filelen;
+unsigned map_checksum;
 byte map_visibility[MAX_MAP_VISIBILITY];
 byte pvsrow[MAX_MAP_LEAFS / 8];
 byte phsrow[MAX_MAP_LEAFS / 8];
@@ -1395,12 +1398,11 @@ cmodel_t *CM_LoadMap(char *name, qboolean clientload, unsigned *checksum)
   int i;
   dheader_t header;
   int length;
-  static unsigned last_checksum;
 
   map_noareas = Cvar_Get("map_noareas", "0", 0);
 
   if (!strcmp(map_name, name) && (clientload || !Cvar_VariableValue("flushmap"))) {
-    *checksum = last_checksum;
+    *checksum = map_checksum;
 
     if (!clientload) {
       memset(portalopen, 0, sizeof(portalopen));
@@ -1420,6 +1422,12 @@ cmodel_t *CM_LoadMap(char *name, qboolean clientload, unsigned *checksum)
   map_entitystring[0] = 0;
   map_name[0] = 0;
 
+  if (map_file) {
+    FS_FreeFile(map_file);
+    map_file = NULL;
+    map_filelen = 0;
+  }
+
   if (!name || !name[0]) {
     numleafs = 1;
     numclusters = 1;
@@ -1434,8 +1442,8 @@ cmodel_t *CM_LoadMap(char *name, qboolean clientload, unsigned *checksum)
     Com_Error(ERR_DROP, "Couldn't load %s", name);
   }
 
-  last_checksum = LittleLong(Com_BlockChecksum(buf, length));
-  *checksum = last_checksum;
+  map_checksum = LittleLong(Com_BlockChecksum(buf, length));
+  *checksum = map_checksum;
 
   header = *(dheader_t *) buf;
 
@@ -1464,7 +1472,9 @@ cmodel_t *CM_LoadMap(char *name, qboolean clientload, unsigned *checksum)
   CMod_LoadVisibility(&header.lumps[LUMP_VISIBILITY]);
   CMod_LoadEntityString(&header.lumps[LUMP_ENTITIES]);
 
-  FS_FreeFile(buf);
+  /* the renderer loads the same file right after us */
+  map_file = (byte *) buf;
+  map_filelen = length;
 
   CM_InitBoxHull();
 
@@ -1476,6 +1486,23 @@ cmodel_t *CM_LoadMap(char *name, qboolean clientload, unsigned *checksum)
   return &map_cmodels[0];
 }
 
+/*
+ * Hands the .bsp read by CM_LoadMap to the renderer so it isn't read and
+ * checksummed a second time. The buffer must be treated as read only and
+ * stays valid until the next map is loaded.
+ */
+byte *CM_MapFile(char *name, int *length, unsigned *checksum)
+{
+  if (!map_file || strcmp(map_name, name)) {
+    return NULL;
+  }
+
+  *length = map_filelen;
+  *checksum = map_checksum;
+
+  return map_file;
+}
+
 cmodel_t *CM_InlineModel(char *name)
 {
   int num;
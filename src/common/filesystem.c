@@ -96,6 +96,9 @@ cvar_t *fs_basedir;
 cvar_t *fs_cddir;
 cvar_t *fs_gamedirvar;
 cvar_t *fs_debug;
+cvar_t *fs_trace;
+
+FILE *fs_traceFile;
 
 fsHandle_t *FS_GetFileByHandle(fileHandle_t f);
 
@@ -249,6 +252,53 @@ void FS_FCloseFile(fileHandle_t f)
   memset(handle, 0, sizeof(*handle));
 }
 
+/*
+ * Appends a line to the file access trace named by fs_trace. The trace
+ * is read by the pak tool to lay out pack contents in the order they
+ * are loaded.
+ */
+void FS_TracePrintf(const char *format, ...)
+{
+  char path[MAX_OSPATH];
+  va_list argPtr;
+
+  if (!fs_trace || (fs_trace->string[0] == '\0')) {
+    if (fs_traceFile) {
+      fclose(fs_traceFile);
+      fs_traceFile = NULL;
+    }
+
+    return;
+  }
+
+  if (!fs_traceFile) {
+    Com_sprintf(path, sizeof(path), "%s/%s", fs_gamedir, fs_trace->string);
+    FS_CreatePath(path);
+
+    fs_traceFile = fopen(path, "a");
+
+    if (!fs_traceFile) {
+      Com_Printf("WARNING: couldn't open trace file '%s'.\n", path);
+      Cvar_Set("fs_trace", "");
+      return;
+    }
+  }
+
+  va_start(argPtr, format);
+  vfprintf(fs_traceFile, format, argPtr);
+  va_end(argPtr);
+
+  fflush(fs_traceFile);
+}
+
+/*
+ * Starts a new section of the access trace, called when a map is loaded.
+ */
+void FS_TraceMap(const char *mapname)
+{
+  FS_TracePrintf("# %s\n", mapname);
+}
+
 /*
  * Finds the file in the search path. Returns filesize and an open FILE *. Used
  * for streaming data out of either a pak file or a seperate file.
@@ -300,6 +350,7 @@ int FS_FOpenFile(const char *name, fileHandle_t *f, qboolean gamedir_only)
 
             if (handle->file) {
               fseek(handle->file, pack->files[i].offset, SEEK_SET);
+              FS_TracePrintf("%s\n", pack->files[i].name);
               return pack->files[i].size;
             }
           }
@@ -327,6 +378,7 @@ int FS_FOpenFile(const char *name, fileHandle_t *f, qboolean gamedir_only)
           Com_Printf("FS_FOpenFile: '%s' (found in '%s').\n", handle->name, search->path);
         }
 
+        FS_TracePrintf("%s\n", handle->name);
         return FS_FileLength(handle->file);
       }
     }
@@ -1152,6 +1204,7 @@ void FS_InitFilesystem(void)
   fs_cddir = Cvar_Get("cddir", "", CVAR_NOSET);
   fs_gamedirvar = Cvar_Get("game", "", CVAR_LATCH | CVAR_SERVERINFO);
   fs_debug = Cvar_Get("fs_debug", "0", 0);
+  fs_trace = Cvar_Get("fs_trace", "", 0);
 
   // Build search path
   FS_BuildRawPath();
@@ -169,6 +169,16 @@ void Info_Print(char *s);
 
 #define PROTOCOL_VERSION 34
 
+/* capabilities a client offers after the userinfo in its
+   connect string, servers that don't know them ignore it */
+#define NETF_GAMESTATE 1 /* svc_gamestate instead of configstrings and baselines commands */
+#define NETF_FRAGMENT 2  /* fragmented reliable stream, confirmed in client_connect */
+#define NETF_COMPRESS 4  /* Huffman coded packet payloads, confirmed in client_connect */
+
+/* configstrings and baselines of a level, as one LZSS compressed blob */
+#define MAX_GAMESTATE (MAX_CONFIGSTRINGS * (MAX_QPATH + 4) + MAX_EDICTS * 64)
+#define GAMESTATE_FRAGMENT 1024
+
 /* ========================================= */
 
 #define PORT_MASTER 27900
@@ -207,7 +217,8 @@ enum svc_ops_e
   svc_playerinfo,          /* variable */
   svc_packetentities,      /* [...] */
   svc_deltapacketentities, /* [...] */
-  svc_frame
+  svc_frame,
+  svc_gamestate /* [long] spawncount [short] version [long] length [short] fragment [...] */
 };
 
 /* ============================================== */
@@ -564,6 +575,25 @@ void NET_Sleep(int msec);
 #define OLD_AVG 0.99
 #define MAX_LATENT 32
 
+/* fragmented reliable stream, see netchan.c */
+#define NETCHAN_FRAGMENT 512 /* reliable bytes per fragment */
+#define NETCHAN_WINDOW 32    /* fragments in flight, one selective ack bit each */
+#define NETCHAN_MAXRELIABLE (NETCHAN_FRAGMENT * NETCHAN_WINDOW)
+
+/* uncoded payload of a packet on a compressing channel */
+#define NETCHAN_MAXPAYLOAD (MAX_MSGLEN * 2)
+
+/* a received packet plus every reliable message it completes */
+#define MAX_NETMESSAGE (NETCHAN_MAXRELIABLE * 2 + NETCHAN_MAXPAYLOAD)
+
+typedef struct
+{
+  int length;   /* 0 if the slot is free */
+  qboolean last; /* ends a reliable message */
+  int sequence; /* packet it was last sent in, 0 if not yet */
+  byte data[NETCHAN_FRAGMENT];
+} netfragment_t;
+
 typedef struct
 {
   qboolean fatal_error;
@@ -590,22 +620,50 @@ typedef struct
   int last_reliable_sequence; /* sequence number of last send */
 
   /* reliable staging and holding areas */
-  sizebuf_t message;                 /* writing buffer to send to server */
-  byte message_buf[MAX_MSGLEN - 16]; /* leave space for header */
+  sizebuf_t message;                      /* writing buffer to send to server */
+  byte message_buf[NETCHAN_MAXRELIABLE]; /* only MAX_MSGLEN - 16 used unfragmented */
 
   /* message is copied to this buffer when it is first transfered */
   int reliable_length;
   byte reliable_buf[MAX_MSGLEN - 16]; /* unacked reliable message */
+
+  /* fragmented reliable stream, when both ends offered NETF_FRAGMENT */
+  qboolean fragmented;
+  int fragment_base; /* oldest unacknowledged outgoing fragment */
+  int fragment_next; /* id for the next outgoing fragment */
+  netfragment_t out_fragments[NETCHAN_WINDOW];
+  int incoming_fragment; /* next fragment to deliver, all before it arrived */
+  netfragment_t in_fragments[NETCHAN_WINDOW];
+  int partial_length; /* start of a message still missing fragments */
+  byte partial_buf[NETCHAN_MAXRELIABLE];
+
+  /* fragment counters */
+  int fragments_sent;
+  int fragments_resent; /* sent again after the peer acked past them */
+  int fragments_received;
+  int fragments_duplicate;
+
+  /* payload compression, when both ends offered NETF_COMPRESS */
+  qboolean compressed;
+  int coded_length; /* payload bytes the last packet went out with */
+  int coded_packets;
+  int coded_in; /* payload bytes before and after coding */
+  int coded_out;
+  int coded_usec;
 } netchan_t;
 
 extern netadr_t net_from;
 extern sizebuf_t net_message;
-extern byte net_message_buffer[MAX_MSGLEN];
+extern byte net_message_buffer[MAX_NETMESSAGE];
 
 void Netchan_Init(void);
 
 void Netchan_Setup(netsrc_t sock, netchan_t *chan, netadr_t adr, int qport);
 
+void Netchan_Fragment(netchan_t *chan);
+
+void Netchan_Compress(netchan_t *chan);
+
 qboolean Netchan_NeedReliable(netchan_t *chan);
 
 void Netchan_Transmit(netchan_t *chan, int length, byte *data);
@@ -626,6 +684,8 @@ cmodel_t *CM_LoadMap(char *name, qboolean clientload, unsigned *checksum);
 
 cmodel_t *CM_InlineModel(char *name); /* *1, *2, etc */
 
+byte *CM_MapFile(char *name, int *length, unsigned *checksum);
+
 int CM_NumClusters(void);
 
 int CM_NumInlineModels(void);
@@ -708,6 +768,8 @@ typedef enum
 
 void FS_DPrintf(const char *format, ...);
 
+void FS_TraceMap(const char *mapname);
+
 int FS_FOpenFile(const char *name, fileHandle_t *f, qboolean gamedir_only);
 
 void FS_FCloseFile(fileHandle_t f);
@@ -776,6 +838,18 @@ unsigned Com_BlockChecksum(void *buffer, int length);
 
 byte COM_BlockSequenceCRCByte(byte *base, int length, int sequence);
 
+int LZSS_Compress(const byte *in, int inlen, byte *out, int outsize);
+
+int LZSS_Decompress(const byte *in, int inlen, byte *out, int outsize);
+
+void Huff_Init(void);
+
+int Huff_Cost(const byte *in, int inlen);
+
+int Huff_Compress(const byte *in, int inlen, byte *out, int outsize);
+
+int Huff_Decompress(const byte *in, int inlen, byte *out, int outlen);
+
 extern cvar_t *developer;
 extern cvar_t *modder;
 extern cvar_t *dedicated;
@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 1997-2001 Id Software, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * =======================================================================
+ *
+ * A static Huffman coder for packet payloads. Both ends build the same
+ * canonical code from a byte histogram of recorded server traffic, so
+ * nothing but the coded bits goes over the wire. Codes are at most
+ * HUFF_MAXBITS long and packed least significant bit first, which lets
+ * the decoder resolve a symbol with a single table lookup.
+ *
+ * =======================================================================
+ */
+
+#include "header/common.h"
+
+#define HUFF_MAXBITS 12
+#define HUFF_TABLESIZE (1 << HUFF_MAXBITS)
+
+/* payload bytes the server sent while a player ran and fired
+   through a few crowded maps, most of them in open combat */
+static const int huff_counts[256] = {
+  44652, 46652,  8727,  7146,  2973,  3394,  2970,  2309,  2483,  3116,  1959,  1150,  1160,  1198,  1458,  2232,
+   7326,  4662,  2636,  8758, 13145,  5127,  5772,  8598,  1275,   975,  1437,   611,  1728,   899,   887,  1720,
+   1687,  1118,  1451,   829,   416,   877,   352,  1279,   440,   351,  1422,   470,   413,   903,  1161,   655,
+   1392,  1519,  1002,  1616,   640,  1427,   365,   867,  1316,   449,   399,   923,   701,   446,   826,   597,
+   1534,   450,   439,  1153,   494,   419,   932,   681,   391,   830,   676,   855,   329,   340,  1135,   261,
+   1321,  1023,   433,   384,   885,   649,   320,   369,  1478,  1078,   335,   722,  6644,  5542,  5237,  6011,
+   5516,  5418,  5814,  5429,   915,   472,   306,  1171,   496,   393,  1172,   314,   441,   937,   718,   890,
+    495,   610,   980,   369,   373,  1126,   268,   309,  1312,   311,   271,   288,   596,   771,   241,   421,
+  17661,   324,   262,  1002,  1267,   283,   977,  1016,   816,   249,   642,   769,   277,   261,  1080,   585,
+    735,  1237,   432,  1813,  1546,  1114,  1269,   988,  1187,   744,   259,   219,  2082,   321,   360,   444,
+    393,   787,   248,   747,   742,   265,   270,  1707,   297,   240,  1022,   221,   812,   270,   485,   682,
+    358,   865,   760,   271,   268,  1719,   259,   538,   705,   366,   783,   337,   485,   825,   274,   693,
+   2134,  1131,   333,  1056,   283,   866,   236,   749,  1026,   526,   627,  1046,   454,   432,  1653,   249,
+    677,  1557,   991,  1602,  1360,  1623,  2575,  1711,  1612,  1746,  1095,  1475,  1701,   982,  1336,  1499,
+   1357,  1408,   770,  1142,  1185,   658,   609,   802,   670,  1142,  1015,   597,  1181,   785,  1095,  1230,
+    733,  1009,  1246,   694,  1052,  1151,   930,  1413,  1327,  1563,  1918,  1911,  2043,  2487,  2157,  4481
+};
+
+static int huff_code[256]; /* bit reversed, ready to be packed */
+static int huff_length[256];
+static unsigned short huff_decode[HUFF_TABLESIZE]; /* length << 8 | symbol */
+static qboolean huff_ready;
+
+/*
+ * Builds the code lengths, halving the weights
+ * until the longest code fits in HUFF_MAXBITS
+ */
+static void Huff_BuildLengths(void)
+{
+  int weight[512], parent[512];
+  qboolean alive[512];
+  int nodes, a, b, i, len, maxlen;
+
+  for (i = 0; i < 256; i++) {
+    weight[i] = huff_counts[i] + 1;
+  }
+
+  for (;;) {
+    for (i = 0; i < 256; i++) {
+      alive[i] = true;
+    }
+
+    /* join the two lightest nodes until only the root is left */
+    for (nodes = 256; nodes < 511; nodes++) {
+      a = b = -1;
+
+      for (i = 0; i < nodes; i++) {
+        if (!alive[i]) {
+          continue;
+        }
+
+        if ((a < 0) || (weight[i] < weight[a])) {
+          b = a;
+          a = i;
+        } else if ((b < 0) || (weight[i] < weight[b])) {
+          b = i;
+        }
+      }
+
+      weight[nodes] = weight[a] + weight[b];
+      parent[a] = parent[b] = nodes;
+      alive[a] = alive[b] = false;
+      alive[nodes] = true;
+    }
+
+    maxlen = 0;
+
+    for (i = 0; i < 256; i++) {
+      for (len = 0, a = i; a != 510; a = parent[a]) {
+        len++;
+      }
+
+      huff_length[i] = len;
+
+      if (len > maxlen) {
+        maxlen = len;
+      }
+    }
+
+    if (maxlen <= HUFF_MAXBITS) {
+      return;
+    }
+
+    for (i = 0; i < 256; i++) {
+      weight[i] = 1 + weight[i] / 2;
+    }
+  }
+}
+
+void Huff_Init(void)
+{
+  int code, len, i, j, reversed;
+
+  if (huff_ready) {
+    return;
+  }
+
+  Huff_BuildLengths();
+
+  /* hand out canonical codes, shortest first */
+  code = 0;
+
+  for (len = 1; len <= HUFF_MAXBITS; len++) {
+    for (i = 0; i < 256; i++) {
+      if (huff_length[i] != len) {
+        continue;
+      }
+
+      for (reversed = 0, j = 0; j < len; j++) {
+        reversed |= ((code >> j) & 1) << (len - 1 - j);
+      }
+
+      huff_code[i] = reversed;
+      code++;
+
+      /* every index whose low bits hold the code decodes to it */
+      for (j = reversed; j < HUFF_TABLESIZE; j += 1 << len) {
+        huff_decode[j] = (len << 8) | i;
+      }
+    }
+
+    code <<= 1;
+  }
+
+  huff_ready = true;
+}
+
+/*
+ * Returns the size of a coded buffer in bits
+ */
+int Huff_Cost(const byte *in, int inlen)
+{
+  int bits, i;
+
+  bits = 0;
+
+  for (i = 0; i < inlen; i++) {
+    bits += huff_length[in[i]];
+  }
+
+  return bits;
+}
+
+/*
+ * Returns the coded size, or -1 if it would not fit in outsize
+ */
+int Huff_Compress(const byte *in, int inlen, byte *out, int outsize)
+{
+  unsigned bits;
+  int count, outlen, i;
+
+  bits = 0;
+  count = outlen = 0;
+
+  for (i = 0; i < inlen; i++) {
+    bits |= huff_code[in[i]] << count;
+    count += huff_length[in[i]];
+
+    for (; count >= 8; count -= 8) {
+      if (outlen >= outsize) {
+        return -1;
+      }
+
+      out[outlen++] = bits & 255;
+      bits >>= 8;
+    }
+  }
+
+  if (count) {
+    if (outlen >= outsize) {
+      return -1;
+    }
+
+    out[outlen++] = bits;
+  }
+
+  return outlen;
+}
+
+/*
+ * Decodes exactly outlen bytes. Returns outlen,
+ * or -1 if the input runs out before that.
+ */
+int Huff_Decompress(const byte *in, int inlen, byte *out, int outlen)
+{
+  unsigned bits;
+  int count, pos, entry, i;
+
+  bits = 0;
+  count = pos = 0;
+
+  for (i = 0; i < outlen; i++) {
+    for (; count < HUFF_MAXBITS && pos < inlen; count += 8) {
+      bits |= in[pos++] << count;
+    }
+
+    entry = huff_decode[bits & (HUFF_TABLESIZE - 1)];
+
+    if ((entry >> 8) > count) {
+      return -1;
+    }
+
+    out[i] = entry & 255;
+    bits >>= entry >> 8;
+    count -= entry >> 8;
+  }
+
+  return outlen;
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 1997-2001 Id Software, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * =======================================================================
+ *
+ * A small LZSS coder for bulk protocol data. Each flag byte announces
+ * eight items, least significant bit first: a clear bit is a literal
+ * byte, a set bit a two byte back reference holding a 12 bit distance
+ * and a 4 bit length.
+ *
+ * =======================================================================
+ */
+
+#include "header/common.h"
+
+#define LZSS_WINDOW 4096
+#define LZSS_MINMATCH 3
+#define LZSS_MAXMATCH (LZSS_MINMATCH + 15)
+#define LZSS_HASHBITS 12
+#define LZSS_HASHSIZE (1 << LZSS_HASHBITS)
+#define LZSS_MAXCHAIN 32
+
+static int lzss_head[LZSS_HASHSIZE];
+static int lzss_prev[LZSS_WINDOW];
+
+static int LZSS_Hash(const byte *p)
+{
+  return ((p[0] << 8) ^ (p[1] << 4) ^ p[2]) & (LZSS_HASHSIZE - 1);
+}
+
+/*
+ * Returns the compressed size, or -1 if it would not fit in outsize
+ */
+int LZSS_Compress(const byte *in, int inlen, byte *out, int outsize)
+{
+  int pos, outlen, flagpos, bit;
+  int cand, chain, len, best, bestdist, maxlen, i, h;
+
+  for (i = 0; i < LZSS_HASHSIZE; i++) {
+    lzss_head[i] = -1;
+  }
+
+  pos = outlen = 0;
+  flagpos = -1;
+  bit = 8;
+
+  while (pos < inlen) {
+    if (bit == 8) {
+      if (outlen >= outsize) {
+        return -1;
+      }
+
+      flagpos = outlen++;
+      out[flagpos] = 0;
+      bit = 0;
+    }
+
+    /* walk the hash chain for the longest match in the window */
+    best = bestdist = 0;
+    maxlen = inlen - pos < LZSS_MAXMATCH ? inlen - pos : LZSS_MAXMATCH;
+
+    if (maxlen >= LZSS_MINMATCH) {
+      cand = lzss_head[LZSS_Hash(in + pos)];
+
+      for (chain = 0; chain < LZSS_MAXCHAIN && cand >= 0 && pos - cand <= LZSS_WINDOW; chain++) {
+        for (len = 0; len < maxlen && in[cand + len] == in[pos + len]; len++) {
+        }
+
+        if (len > best) {
+          best = len;
+          bestdist = pos - cand;
+
+          if (len == maxlen) {
+            break;
+          }
+        }
+
+        cand = lzss_prev[cand & (LZSS_WINDOW - 1)];
+      }
+    }
+
+    if (best >= LZSS_MINMATCH) {
+      if (outlen + 2 > outsize) {
+        return -1;
+      }
+
+      out[flagpos] |= 1 << bit;
+      out[outlen++] = (bestdist - 1) & 255;
+      out[outlen++] = (((bestdist - 1) >> 8) << 4) | (best - LZSS_MINMATCH);
+    } else {
+      if (outlen >= outsize) {
+        return -1;
+      }
+
+      best = 1;
+      out[outlen++] = in[pos];
+    }
+
+    bit++;
+
+    /* every position covered goes into the chains */
+    for (i = 0; i < best; i++, pos++) {
+      if (pos + LZSS_MINMATCH <= inlen) {
+        h = LZSS_Hash(in + pos);
+        lzss_prev[pos & (LZSS_WINDOW - 1)] = lzss_head[h];
+        lzss_head[h] = pos;
+      }
+    }
+  }
+
+  return outlen;
+}
+
+/*
+ * Returns the decompressed size, or -1 if the data is
+ * malformed or would not fit in outsize
+ */
+int LZSS_Decompress(const byte *in, int inlen, byte *out, int outsize)
+{
+  int pos, outlen, flags, bit, dist, len;
+
+  pos = outlen = 0;
+
+  while (pos < inlen) {
+    flags = in[pos++];
+
+    for (bit = 0; bit < 8 && pos < inlen; bit++) {
+      if (!(flags & (1 << bit))) {
+        if (outlen >= outsize) {
+          return -1;
+        }
+
+        out[outlen++] = in[pos++];
+        continue;
+      }
+
+      if (pos + 2 > inlen) {
+        return -1;
+      }
+
+      dist = (in[pos] | ((in[pos + 1] >> 4) << 8)) + 1;
+      len = (in[pos + 1] & 15) + LZSS_MINMATCH;
+      pos += 2;
+
+      if ((dist > outlen) || (outlen + len > outsize)) {
+        return -1;
+      }
+
+      /* may overlap itself, so copy forwards a byte at a time */
+      for (; len > 0; len--, outlen++) {
+        out[outlen] = out[outlen - dist];
+      }
+    }
+  }
+
+  return outlen;
+}
@@ -79,15 +79,48 @@
  * frame, such as during the connection stage while waiting for the
  * client to load, then a packet only needs to be delivered if there is
  * something in the unacknowledged reliable
+ *
+ * fragmented reliable stream
+ * --------------------------
+ * When both ends offered NETF_FRAGMENT while connecting, the reliable
+ * message is no longer held back until the last one is acknowledged.
+ * Each time it is transmitted it is cut into numbered fragments of up
+ * to NETCHAN_FRAGMENT bytes, and up to NETCHAN_WINDOW of them may be
+ * in flight. The header then continues with
+ *
+ * 32	next fragment expected, every one before it arrived
+ * 32	bit n: fragment expected + n arrived out of order
+ *
+ * and a reliable payload is a count byte followed by that many
+ * fragments, each a 32 bit id, 16 bits of length with the top bit set
+ * on the last fragment of a message, and the data. A fragment is sent
+ * again once the peer acknowledged the packet it went out in without
+ * acknowledging the fragment. The receiver hands whole messages over in
+ * order, ahead of the unreliable part of the packet that completed them.
+ *
+ * compressed payload
+ * ------------------
+ * When both ends offered NETF_COMPRESS, everything after the header is
+ * preceded by
+ *
+ * 1	the payload is Huffman coded
+ * 15	uncoded payload length
+ *
+ * and the reliable and unreliable parts are coded together with the
+ * static code in huffman.c. A payload that would not shrink goes out as
+ * it is. The unreliable part may be up to NETCHAN_MAXPAYLOAD bytes
+ * before coding, as long as the coded packet fits in MAX_MSGLEN.
  */
 
 cvar_t *showpackets;
 cvar_t *showdrop;
 cvar_t *qport;
+cvar_t *net_fragment;
+cvar_t *net_compress;
 
 netadr_t net_from;
 sizebuf_t net_message;
-byte net_message_buffer[MAX_MSGLEN];
+byte net_message_buffer[MAX_NETMESSAGE];
 
 void Netchan_Init(void)
 {
@@ -99,6 +132,10 @@ void Netchan_Init(void)
   showpackets = Cvar_Get("showpackets", "0", 0);
   showdrop = Cvar_Get("showdrop", "0", 0);
   qport = Cvar_Get("qport", va("%i", port), CVAR_NOSET);
+  net_fragment = Cvar_Get("net_fragment", "1", 0);
+  net_compress = Cvar_Get("net_compress", "1", 0);
+
+  Huff_Init();
 }
 
 /*
@@ -148,10 +185,333 @@ void Netchan_Setup(netsrc_t sock, netchan_t *chan, netadr_t adr, int qport)
   chan->incoming_sequence = 0;
   chan->outgoing_sequence = 1;
 
-  SZ_Init(&chan->message, chan->message_buf, sizeof(chan->message_buf));
+  /* an unfragmented reliable message has to fit in one packet */
+  SZ_Init(&chan->message, chan->message_buf, MAX_MSGLEN - 16);
   chan->message.allowoverflow = true;
 }
 
+/*
+ * Switches a freshly set up channel to the fragmented
+ * reliable stream, once both ends agreed on it
+ */
+void Netchan_Fragment(netchan_t *chan)
+{
+  chan->fragmented = true;
+  chan->message.maxsize = sizeof(chan->message_buf);
+}
+
+/*
+ * Switches a freshly set up channel to coded
+ * payloads, once both ends agreed on it
+ */
+void Netchan_Compress(netchan_t *chan)
+{
+  chan->compressed = true;
+}
+
+/*
+ * Cuts the staged reliable message into fragments
+ * once the window has room for all of them
+ */
+static void Netchan_QueueFragments(netchan_t *chan)
+{
+  netfragment_t *frag;
+  int count, offset, len;
+
+  if (!chan->message.cursize) {
+    return;
+  }
+
+  count = (chan->message.cursize + NETCHAN_FRAGMENT - 1) / NETCHAN_FRAGMENT;
+
+  if (chan->fragment_next - chan->fragment_base + count > NETCHAN_WINDOW) {
+    return; /* wait for acks */
+  }
+
+  for (offset = 0; offset < chan->message.cursize; offset += len) {
+    len = chan->message.cursize - offset;
+
+    if (len > NETCHAN_FRAGMENT) {
+      len = NETCHAN_FRAGMENT;
+    }
+
+    frag = &chan->out_fragments[chan->fragment_next % NETCHAN_WINDOW];
+    frag->length = len;
+    frag->last = (offset + len == chan->message.cursize);
+    frag->sequence = 0;
+    memcpy(frag->data, chan->message_buf + offset, len);
+
+    chan->fragment_next++;
+  }
+
+  chan->message.cursize = 0;
+}
+
+/*
+ * Picks the fragments that go into the next packet, the ones never sent
+ * and the ones lost on the way. Leaves room for the unreliable part
+ * when it can, but always sends something if there is anything to send.
+ */
+static int Netchan_PickFragments(netchan_t *chan, int length, int *picks)
+{
+  netfragment_t *frag;
+  int id, count, room, size;
+
+  count = 0;
+  size = 0;
+  room = MAX_MSGLEN - 19; /* header, ack block and count byte */
+
+  if (chan->compressed) {
+    room -= 2; /* payload length */
+  }
+
+  for (id = chan->fragment_base; id < chan->fragment_next && count < NETCHAN_WINDOW; id++) {
+    frag = &chan->out_fragments[id % NETCHAN_WINDOW];
+
+    if (!frag->length) {
+      continue; /* acked */
+    }
+
+    if (frag->sequence && (chan->incoming_acknowledged < frag->sequence)) {
+      continue; /* still in flight */
+    }
+
+    if ((size + 6 + frag->length > room - length) && (count || (6 + frag->length > room))) {
+      break;
+    }
+
+    size += 6 + frag->length;
+    picks[count++] = id;
+  }
+
+  return count;
+}
+
+static void Netchan_WriteFragments(netchan_t *chan, sizebuf_t *send, int *picks, int count)
+{
+  netfragment_t *frag;
+  int i;
+
+  MSG_WriteByte(send, count);
+
+  for (i = 0; i < count; i++) {
+    frag = &chan->out_fragments[picks[i] % NETCHAN_WINDOW];
+
+    if (frag->sequence) {
+      chan->fragments_resent++;
+    }
+
+    MSG_WriteLong(send, picks[i]);
+    MSG_WriteShort(send, frag->length | (frag->last ? 0x8000 : 0));
+    SZ_Write(send, frag->data, frag->length);
+
+    frag->sequence = chan->outgoing_sequence;
+    chan->fragments_sent++;
+  }
+}
+
+/*
+ * Selective acknowledge of the fragments
+ * received past the next expected one
+ */
+static unsigned Netchan_FragmentMask(netchan_t *chan)
+{
+  unsigned mask;
+  int i;
+
+  mask = 0;
+
+  for (i = 1; i < NETCHAN_WINDOW; i++) {
+    if (chan->in_fragments[(chan->incoming_fragment + i) % NETCHAN_WINDOW].length) {
+      mask |= 1u << i;
+    }
+  }
+
+  return mask;
+}
+
+static void Netchan_AckFragments(netchan_t *chan, int expected, unsigned mask)
+{
+  netfragment_t *frag;
+  int id;
+
+  if ((expected < chan->fragment_base) || (expected > chan->fragment_next)) {
+    return; /* stale or bogus */
+  }
+
+  for (id = chan->fragment_base; id < chan->fragment_next; id++) {
+    if ((id < expected) || ((id - expected < NETCHAN_WINDOW) && (mask & (1u << (id - expected))))) {
+      chan->out_fragments[id % NETCHAN_WINDOW].length = 0;
+    }
+  }
+
+  /* slide the window past everything acknowledged in order */
+  while (chan->fragment_base < chan->fragment_next) {
+    frag = &chan->out_fragments[chan->fragment_base % NETCHAN_WINDOW];
+
+    if (frag->length) {
+      break;
+    }
+
+    chan->fragment_base++;
+  }
+}
+
+/*
+ * Stores the fragments of a packet and rewrites msg to hold every
+ * reliable message they completed followed by the unreliable part
+ */
+static qboolean Netchan_ReadFragments(netchan_t *chan, sizebuf_t *msg, qboolean reliable)
+{
+  static byte deliver[MAX_NETMESSAGE];
+  netfragment_t *frag;
+  int count, id, len, size, i;
+  qboolean last;
+
+  if (reliable) {
+    count = MSG_ReadByte(msg);
+
+    for (i = 0; i < count; i++) {
+      id = MSG_ReadLong(msg);
+      len = MSG_ReadShort(msg);
+      last = (len & 0x8000) != 0;
+      len &= 0x7fff;
+
+      if ((len <= 0) || (len > NETCHAN_FRAGMENT) || (msg->readcount + len > msg->cursize)) {
+        Com_Printf("%s:Bad fragment\n", NET_AdrToString(chan->remote_address));
+        return false;
+      }
+
+      if ((id < chan->incoming_fragment) || (id >= chan->incoming_fragment + NETCHAN_WINDOW) ||
+          chan->in_fragments[id % NETCHAN_WINDOW].length) {
+        chan->fragments_duplicate++;
+      } else {
+        frag = &chan->in_fragments[id % NETCHAN_WINDOW];
+        frag->length = len;
+        frag->last = last;
+        memcpy(frag->data, msg->data + msg->readcount, len);
+        chan->fragments_received++;
+      }
+
+      msg->readcount += len;
+    }
+  }
+
+  /* hand over whole messages in order */
+  size = 0;
+
+  for (frag = &chan->in_fragments[chan->incoming_fragment % NETCHAN_WINDOW]; frag->length;
+       frag = &chan->in_fragments[chan->incoming_fragment % NETCHAN_WINDOW]) {
+    if (chan->partial_length + frag->length > (int) sizeof(chan->partial_buf)) {
+      Com_Printf("%s:Oversize reliable message\n", NET_AdrToString(chan->remote_address));
+      chan->fatal_error = true;
+      return false;
+    }
+
+    memcpy(chan->partial_buf + chan->partial_length, frag->data, frag->length);
+    chan->partial_length += frag->length;
+
+    if (frag->last) {
+      memcpy(deliver + size, chan->partial_buf, chan->partial_length);
+      size += chan->partial_length;
+      chan->partial_length = 0;
+    }
+
+    frag->length = 0;
+    chan->incoming_fragment++;
+  }
+
+  len = msg->cursize - msg->readcount;
+
+  if (size + len > (int) sizeof(deliver)) {
+    Com_Printf("%s:Oversize packet\n", NET_AdrToString(chan->remote_address));
+    return false;
+  }
+
+  if (len > 0) {
+    memcpy(deliver + size, msg->data + msg->readcount, len);
+    size += len;
+  }
+
+  if (size > msg->maxsize) {
+    Com_Printf("%s:Oversize message\n", NET_AdrToString(chan->remote_address));
+    return false;
+  }
+
+  memcpy(msg->data, deliver, size);
+  msg->cursize = size;
+  msg->readcount = 0;
+
+  return true;
+}
+
+/*
+ * Codes the payload into the packet, or copies it when coding does not
+ * make it smaller. Drops the unreliable part if it can't fit either way.
+ */
+static void Netchan_WritePayload(netchan_t *chan, sizebuf_t *send, sizebuf_t *payload, int reliable)
+{
+  static byte coded[MAX_MSGLEN];
+  long long start;
+  int room, len;
+
+  start = Sys_Microseconds();
+  room = send->maxsize - send->cursize - 2;
+
+  len = Huff_Compress(payload->data, payload->cursize, coded, room);
+
+  if ((len < 0) && (payload->cursize > room)) {
+    Com_Printf("Netchan_Transmit: dumped unreliable\n");
+    payload->cursize = reliable;
+    len = Huff_Compress(payload->data, payload->cursize, coded, room);
+  }
+
+  if ((len >= 0) && (len < payload->cursize)) {
+    MSG_WriteShort(send, payload->cursize | 0x8000);
+    SZ_Write(send, coded, len);
+  } else {
+    len = payload->cursize;
+    MSG_WriteShort(send, len);
+    SZ_Write(send, payload->data, len);
+  }
+
+  chan->coded_length = len;
+  chan->coded_packets++;
+  chan->coded_in += payload->cursize;
+  chan->coded_out += len;
+  chan->coded_usec += (int) (Sys_Microseconds() - start);
+}
+
+/*
+ * Decodes the payload of a packet in place
+ */
+static qboolean Netchan_ReadPayload(netchan_t *chan, sizebuf_t *msg)
+{
+  static byte raw[NETCHAN_MAXPAYLOAD];
+  int len, coded;
+
+  len = MSG_ReadShort(msg) & 0xffff;
+  coded = msg->cursize - msg->readcount;
+
+  if (!(len & 0x8000)) {
+    if (len == coded) {
+      return true;
+    }
+  } else {
+    len &= 0x7fff;
+
+    if ((len <= (int) sizeof(raw)) && (msg->readcount + len <= msg->maxsize) &&
+        (Huff_Decompress(msg->data + msg->readcount, coded, raw, len) == len)) {
+      memcpy(msg->data + msg->readcount, raw, len);
+      msg->cursize = msg->readcount + len;
+      return true;
+    }
+  }
+
+  Com_Printf("%s:Bad payload\n", NET_AdrToString(chan->remote_address));
+  return false;
+}
+
 /*
  * Returns true if the last reliable message has acked
  */
@@ -192,10 +552,13 @@ qboolean Netchan_NeedReliable(netchan_t *chan)
  */
 void Netchan_Transmit(netchan_t *chan, int length, byte *data)
 {
-  sizebuf_t send;
+  sizebuf_t send, payload, *out;
   byte send_buf[MAX_MSGLEN];
+  byte payload_buf[NETCHAN_MAXPAYLOAD];
   qboolean send_reliable;
   unsigned w1, w2;
+  int picks[NETCHAN_WINDOW];
+  int numpicks, reliable;
 
   /* check for message overflow */
   if (chan->message.overflowed) {
@@ -204,13 +567,21 @@ void Netchan_Transmit(netchan_t *chan, int length, byte *data)
     return;
   }
 
-  send_reliable = Netchan_NeedReliable(chan);
+  numpicks = 0;
 
-  if (!chan->reliable_length && chan->message.cursize) {
-    memcpy(chan->reliable_buf, chan->message_buf, chan->message.cursize);
-    chan->reliable_length = chan->message.cursize;
-    chan->message.cursize = 0;
-    chan->reliable_sequence ^= 1;
+  if (chan->fragmented) {
+    Netchan_QueueFragments(chan);
+    numpicks = Netchan_PickFragments(chan, length, picks);
+    send_reliable = numpicks > 0;
+  } else {
+    send_reliable = Netchan_NeedReliable(chan);
+
+    if (!chan->reliable_length && chan->message.cursize) {
+      memcpy(chan->reliable_buf, chan->message_buf, chan->message.cursize);
+      chan->reliable_length = chan->message.cursize;
+      chan->message.cursize = 0;
+      chan->reliable_sequence ^= 1;
+    }
   }
 
   /* write the packet header */
@@ -219,9 +590,6 @@ void Netchan_Transmit(netchan_t *chan, int length, byte *data)
   w1 = (chan->outgoing_sequence & ~(1 << 31)) | (send_reliable << 31);
   w2 = (chan->incoming_sequence & ~(1 << 31)) | (chan->incoming_reliable_sequence << 31);
 
-  chan->outgoing_sequence++;
-  chan->last_sent = curtime;
-
   MSG_WriteLong(&send, w1);
   MSG_WriteLong(&send, w2);
 
@@ -230,19 +598,45 @@ void Netchan_Transmit(netchan_t *chan, int length, byte *data)
     MSG_WriteShort(&send, qport->value);
   }
 
-  /* copy the reliable message to the packet first */
-  if (send_reliable) {
-    SZ_Write(&send, chan->reliable_buf, chan->reliable_length);
-    chan->last_reliable_sequence = chan->outgoing_sequence;
+  if (chan->fragmented) {
+    MSG_WriteLong(&send, chan->incoming_fragment);
+    MSG_WriteLong(&send, Netchan_FragmentMask(chan));
+  }
+
+  /* a coded payload is staged uncoded first */
+  if (chan->compressed) {
+    SZ_Init(&payload, payload_buf, sizeof(payload_buf));
+    out = &payload;
+  } else {
+    out = &send;
+  }
+
+  if (chan->fragmented) {
+    if (send_reliable) {
+      Netchan_WriteFragments(chan, out, picks, numpicks);
+    }
+  } else if (send_reliable) {
+    /* copy the reliable message to the packet first */
+    SZ_Write(out, chan->reliable_buf, chan->reliable_length);
+    chan->last_reliable_sequence = chan->outgoing_sequence + 1;
   }
 
+  chan->outgoing_sequence++;
+  chan->last_sent = curtime;
+
+  reliable = out->cursize;
+
   /* add the unreliable part if space is available */
-  if (send.maxsize - send.cursize >= length) {
-    SZ_Write(&send, data, length);
+  if (out->maxsize - out->cursize >= length) {
+    SZ_Write(out, data, length);
   } else {
     Com_Printf("Netchan_Transmit: dumped unreliable\n");
   }
 
+  if (chan->compressed) {
+    Netchan_WritePayload(chan, &send, &payload, reliable);
+  }
+
   /* send the datagram */
   NET_SendPacket(chan->sock, send.cursize, send.data, chan->remote_address);
 
@@ -265,6 +659,8 @@ qboolean Netchan_Process(netchan_t *chan, sizebuf_t *msg)
 {
   unsigned sequence, sequence_ack;
   unsigned reliable_ack, reliable_message;
+  unsigned mask;
+  int expected;
 
   /* get sequence numbers */
   MSG_BeginReading(msg);
@@ -276,6 +672,14 @@ qboolean Netchan_Process(netchan_t *chan, sizebuf_t *msg)
     (void) MSG_ReadShort(msg);
   }
 
+  expected = 0;
+  mask = 0;
+
+  if (chan->fragmented) {
+    expected = MSG_ReadLong(msg);
+    mask = MSG_ReadLong(msg);
+  }
+
   reliable_message = sequence >> 31;
   reliable_ack = sequence_ack >> 31;
 
@@ -301,6 +705,10 @@ qboolean Netchan_Process(netchan_t *chan, sizebuf_t *msg)
     return false;
   }
 
+  if (chan->compressed && !Netchan_ReadPayload(chan, msg)) {
+    return false;
+  }
+
   /* dropped packets don't keep the message from being used */
   chan->dropped = sequence - (chan->incoming_sequence + 1);
 
@@ -310,20 +718,29 @@ qboolean Netchan_Process(netchan_t *chan, sizebuf_t *msg)
     }
   }
 
-  /* if the current outgoing reliable message has been acknowledged
-   * clear the buffer to make way for the next */
-  if (reliable_ack == chan->reliable_sequence) {
-    chan->reliable_length = 0; /* it has been received */
-  }
-
-  /* if this message contains a reliable message, bump
-   * incoming_reliable_sequence */
   chan->incoming_sequence = sequence;
   chan->incoming_acknowledged = sequence_ack;
-  chan->incoming_reliable_acknowledged = reliable_ack;
 
-  if (reliable_message) {
-    chan->incoming_reliable_sequence ^= 1;
+  if (chan->fragmented) {
+    Netchan_AckFragments(chan, expected, mask);
+
+    if (!Netchan_ReadFragments(chan, msg, reliable_message)) {
+      return false;
+    }
+  } else {
+    /* if the current outgoing reliable message has been acknowledged
+     * clear the buffer to make way for the next */
+    if (reliable_ack == chan->reliable_sequence) {
+      chan->reliable_length = 0; /* it has been received */
+    }
+
+    /* if this message contains a reliable message, bump
+     * incoming_reliable_sequence */
+    chan->incoming_reliable_acknowledged = reliable_ack;
+
+    if (reliable_message) {
+      chan->incoming_reliable_sequence ^= 1;
+    }
   }
 
   /* the message can now be read from the current message pointer */
@@ -329,7 +329,7 @@ void Cmd_Give_f(edict_t *ent)
     }
   } else {
     it_ent = G_Spawn();
-    it_ent->classname = it->classname;
+    G_SetClassname(it_ent, it->classname);
     SpawnItem(it_ent, it);
     Touch_Item(it_ent, ent, NULL, NULL);
 
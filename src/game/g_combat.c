@@ -329,6 +329,9 @@ void T_Damage(edict_t *targ, edict_t *inflictor, edict_t *attacker, vec3_t dir,
     return;
   }
 
+  /* knockback, pain and death all disturb a parked entity */
+  G_WakeEntity(targ);
+
   /* friendly fire avoidance if enabled you
      can't hurt teammates (but you can hurt
      yourself) knockback still occurs */
@@ -474,7 +477,8 @@ void T_Damage(edict_t *targ, edict_t *inflictor, edict_t *attacker, vec3_t dir,
 void T_RadiusDamage(edict_t *inflictor, edict_t *attacker, float damage, edict_t *ignore, float radius, int mod)
 {
   float points;
-  edict_t *ent = NULL;
+  edict_t *touch[MAX_EDICTS], *ent;
+  int i, num;
   vec3_t v;
   vec3_t dir;
 
@@ -482,7 +486,17 @@ void T_RadiusDamage(edict_t *inflictor, edict_t *attacker, float damage, edict_t
     return;
   }
 
-  while ((ent = findradius(ent, inflictor->s.origin, radius)) != NULL) {
+  num = SV_RadiusEdicts(inflictor->s.origin, radius, touch, MAX_EDICTS, AREA_SOLID | AREA_TRIGGERS);
+
+  for (i = 0; i < num; i++) {
+    ent = touch[i];
+
+    /* an earlier victim may have taken it
+       with it, same as a findradius walk */
+    if (!ent->inuse || (ent->solid == SOLID_NOT)) {
+      continue;
+    }
+
     if (ent == ignore) {
       continue;
     }
@@ -134,6 +134,8 @@ void Move_Calc(edict_t *ent, vec3_t dest, void (*func)(edict_t *))
     return;
   }
 
+  G_WakeEntity(ent);
+
   VectorClear(ent->velocity);
   VectorSubtract(dest, ent->s.origin, ent->moveinfo.dir);
   ent->moveinfo.remaining_distance = VectorNormalize(ent->moveinfo.dir);
@@ -236,6 +238,8 @@ void AngleMove_Calc(edict_t *ent, void (*func)(edict_t *))
     return;
   }
 
+  G_WakeEntity(ent);
+
   VectorClear(ent->avelocity);
   ent->moveinfo.endfunc = func;
 
@@ -1738,7 +1742,7 @@ void SP_func_water(edict_t *self)
     self->spawnflags |= DOOR_TOGGLE;
   }
 
-  self->classname = "func_door";
+  G_SetClassname(self, "func_door");
 
   SV_LinkEdict(self);
 }
@@ -2408,7 +2412,7 @@ void SP_func_door_secret(edict_t *ent)
     ent->touch = door_touch;
   }
 
-  ent->classname = "func_door";
+  G_SetClassname(ent, "func_door");
 
   SV_LinkEdict(ent);
 }
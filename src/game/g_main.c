@@ -139,6 +139,14 @@ void InitGame(void)
   /* dm map list */
   sv_maplist = Cvar_Get("sv_maplist", "", 0);
 
+  /* only run entities that are moving or about to think */
+  g_dormant = Cvar_Get("g_dormant", "1", 0);
+
+  /* walking monsters follow the navigation graph,
+     searching at most g_navbudget nodes a frame */
+  g_nav = Cvar_Get("g_nav", "1", 0);
+  g_navbudget = Cvar_Get("g_navbudget", "4096", 0);
+
   /* items */
   InitItems();
 
@@ -195,7 +203,7 @@ edict_t *CreateTargetChangeLevel(char *map)
   }
 
   ent = G_Spawn();
-  ent->classname = "target_changelevel";
+  G_SetClassname(ent, "target_changelevel");
   Com_sprintf(level.nextmap, sizeof(level.nextmap), "%s", map);
   ent->map = level.nextmap;
   return ent;
@@ -381,10 +389,29 @@ void G_RunFrame(void)
   /* treat each object in turn
      even the world gets a chance
      to think */
-  ent = &g_edicts[0];
+  G_ScheduleEntities();
+
+  for (i = 0; i < globals.num_edicts; i++) {
+    /* parked entities are left alone
+       until something wakes them */
+    if (level.scheduled) {
+      if (!level.awake[i >> 5]) {
+        i |= 31;
+        continue;
+      }
+
+      if (!(level.awake[i >> 5] & (1u << (i & 31)))) {
+        continue;
+      }
+    }
+
+    ent = &g_edicts[i];
 
-  for (i = 0; i < globals.num_edicts; i++, ent++) {
     if (!ent->inuse) {
+      if (i > maxclients->value) {
+        G_SleepEntity(ent);
+      }
+
       continue;
     }
 
@@ -407,6 +434,7 @@ void G_RunFrame(void)
     }
 
     G_RunEntity(ent);
+    G_SleepEntity(ent);
   }
 
   /* see if it is time to end a deathmatch */
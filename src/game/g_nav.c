@@ -0,0 +1,829 @@
+/*
+ * Copyright (C) 1997-2001 Id Software, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * =======================================================================
+ *
+ * Navigation graph for walking monsters. At map load the world is
+ * sampled on a grid of columns, every floor a monster can stand on
+ * becomes a node and neighbouring nodes a monster can step between
+ * are linked. Monsters chasing a distant goal ask for an A* path and
+ * walk it waypoint by waypoint, leaving the trial and error stepping
+ * in M_MoveToGoal for the last few units and for whatever the graph
+ * does not know about (doors, other monsters).
+ *
+ * =======================================================================
+ */
+
+#include "../server/header/server.h"
+
+#define NAV_CELL 32
+#define NAV_MAXCOLUMNS 65536
+#define NAV_MAXFLOORS 4
+#define NAV_MAXNODES 65536
+#define NAV_SUBSTEP 16
+#define NAV_SEARCHES 4 /* search trees kept for different goals */
+#define NAV_STEPSIZE 18
+#define NAV_NEARGOAL 96 /* closer than this is left to stepping */
+#define NAV_REPATH 1.0  /* seconds between searches for a moving goal */
+#define NAV_RETRY 2.0   /* seconds before trying again after a failure */
+#define NAV_BLOCKED 0.5 /* seconds of plain stepping when the path is blocked */
+
+typedef struct
+{
+  vec3_t origin;
+  int links[8];  /* node in each direction, or -1 */
+  int component; /* nodes with different components can't reach each other */
+} navnode_t;
+
+/* a search tree, stamped so nothing has to be cleared between searches */
+typedef struct
+{
+  float *gcost;
+  float *fcost; /* gcost plus the estimate to start */
+  int *parent;  /* next node towards goal */
+  int *stamps;
+  int *heap; /* open nodes by fcost */
+  int *heappos;
+  int heapcount;
+  int stamp;
+  int goal;
+  int start;
+  float time;
+  int usedframe;
+} navsearch_t;
+
+static const int nav_dirs[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+
+/* the hull of an infantry or soldier, the common walkers */
+static vec3_t nav_mins = {-16, -16, -24};
+static vec3_t nav_maxs = {16, 16, 32};
+
+static struct
+{
+  int cell;
+  int xcols, ycols;
+  vec3_t mins;
+
+  int *firstnode; /* per column, nodes of a column are stored top down */
+  int *numfloors;
+
+  navnode_t *nodes;
+  int numnodes;
+  int numlinks;
+  int numcomponents;
+  int buildmsec;
+
+  navsearch_t searches[NAV_SEARCHES];
+
+  int budgetframe;
+  int budgetused;
+} nav;
+
+static int Nav_Column(int x, int y)
+{
+  return y * nav.xcols + x;
+}
+
+/*
+ * Drops the hull onto the floor under start. Returns false
+ * if there is no floor within a step or it is too steep.
+ */
+static qboolean Nav_DropHull(vec3_t start, int headnode, vec3_t out)
+{
+  vec3_t end;
+  trace_t trace;
+
+  VectorCopy(start, end);
+  end[2] -= 2 * NAV_STEPSIZE;
+
+  trace = CM_BoxTrace(start, end, nav_mins, nav_maxs, headnode, MASK_MONSTERSOLID);
+
+  if (trace.allsolid || trace.startsolid || (trace.fraction == 1.0) || (trace.plane.normal[2] < 0.7)) {
+    return false;
+  }
+
+  VectorCopy(trace.endpos, out);
+  return true;
+}
+
+/*
+ * Walks the hull from one node to another in short steps
+ * the way SV_movestep does: up a step, across, and down.
+ */
+static qboolean Nav_CanStep(vec3_t from, vec3_t to, int headnode)
+{
+  vec3_t pos, up, across, delta;
+  trace_t trace;
+  int i, steps;
+
+  VectorSubtract(to, from, delta);
+  steps = (int) ceil(sqrt(delta[0] * delta[0] + delta[1] * delta[1]) / NAV_SUBSTEP);
+  VectorCopy(from, pos);
+
+  for (i = 1; i <= steps; i++) {
+    VectorCopy(pos, up);
+    up[2] += NAV_STEPSIZE;
+
+    across[0] = from[0] + delta[0] * i / steps;
+    across[1] = from[1] + delta[1] * i / steps;
+    across[2] = up[2];
+
+    trace = CM_BoxTrace(up, across, nav_mins, nav_maxs, headnode, MASK_MONSTERSOLID);
+
+    if (trace.allsolid || trace.startsolid || (trace.fraction != 1.0)) {
+      return false;
+    }
+
+    if (!Nav_DropHull(across, headnode, pos)) {
+      return false;
+    }
+  }
+
+  return fabs(pos[2] - to[2]) <= 1;
+}
+
+static void Nav_FindFloors(int x, int y, int headnode)
+{
+  vec3_t start, end, org;
+  trace_t trace;
+  navnode_t *node;
+  int i, col;
+
+  col = Nav_Column(x, y);
+  nav.firstnode[col] = nav.numnodes;
+
+  start[0] = end[0] = nav.mins[0] + (x + 0.5) * nav.cell;
+  start[1] = end[1] = nav.mins[1] + (y + 0.5) * nav.cell;
+  start[2] = sv.models[1]->maxs[2];
+  end[2] = sv.models[1]->mins[2];
+
+  while (nav.numfloors[col] < NAV_MAXFLOORS && nav.numnodes < NAV_MAXNODES) {
+    /* get out of the solid first, a gap thinner
+       than a step won't hold a monster anyway */
+    while (start[2] > end[2] && (CM_PointContents(start, headnode) & MASK_MONSTERSOLID)) {
+      start[2] -= 16;
+    }
+
+    if (start[2] <= end[2]) {
+      break;
+    }
+
+    trace = CM_BoxTrace(start, end, vec3_origin, vec3_origin, headnode, MASK_MONSTERSOLID);
+
+    if (trace.fraction == 1.0) {
+      break;
+    }
+
+    VectorCopy(trace.endpos, org);
+    start[2] = trace.endpos[2] - 1;
+
+    if (trace.plane.normal[2] < 0.7) {
+      continue;
+    }
+
+    org[2] += 1;
+
+    if (CM_PointContents(org, headnode) & (CONTENTS_LAVA | CONTENTS_SLIME)) {
+      continue;
+    }
+
+    org[2] += -nav_mins[2] + NAV_STEPSIZE - 1;
+
+    if (!Nav_DropHull(org, headnode, org)) {
+      continue;
+    }
+
+    node = &nav.nodes[nav.numnodes++];
+    VectorCopy(org, node->origin);
+
+    for (i = 0; i < 8; i++) {
+      node->links[i] = -1;
+    }
+
+    nav.numfloors[col]++;
+  }
+}
+
+/*
+ * Links a node with the nodes in the columns east, north east,
+ * north and north west of it. A link is only made if the step
+ * works both ways, so the far end gets the reverse link. Floors
+ * whose reverse link already leads elsewhere are passed over,
+ * the searches count on every link having its way back.
+ */
+static void Nav_LinkNode(int x, int y, int n, int headnode)
+{
+  navnode_t *node, *other;
+  int d, nx, ny, col, i, best;
+  float dz, bestdz;
+
+  node = &nav.nodes[n];
+
+  for (d = 0; d < 4; d++) {
+    nx = x + nav_dirs[d][0];
+    ny = y + nav_dirs[d][1];
+
+    if ((nx < 0) || (nx >= nav.xcols) || (ny >= nav.ycols)) {
+      continue;
+    }
+
+    col = Nav_Column(nx, ny);
+    best = -1;
+    bestdz = 2 * NAV_STEPSIZE;
+
+    for (i = nav.firstnode[col]; i < nav.firstnode[col] + nav.numfloors[col]; i++) {
+      if (nav.nodes[i].links[d + 4] >= 0) {
+        continue;
+      }
+
+      dz = fabs(nav.nodes[i].origin[2] - node->origin[2]);
+
+      if (dz <= bestdz) {
+        best = i;
+        bestdz = dz;
+      }
+    }
+
+    if (best < 0) {
+      continue;
+    }
+
+    other = &nav.nodes[best];
+
+    if (!Nav_CanStep(node->origin, other->origin, headnode) || !Nav_CanStep(other->origin, node->origin, headnode)) {
+      continue;
+    }
+
+    node->links[d] = best;
+    other->links[d + 4] = n;
+    nav.numlinks += 2;
+  }
+}
+
+static void Nav_MarkComponents(void)
+{
+  int *stack;
+  int i, d, n, count, next;
+
+  for (i = 0; i < nav.numnodes; i++) {
+    nav.nodes[i].component = -1;
+  }
+
+  stack = Z_TagMalloc(nav.numnodes * sizeof(int), TAG_LEVEL);
+
+  for (i = 0; i < nav.numnodes; i++) {
+    if (nav.nodes[i].component >= 0) {
+      continue;
+    }
+
+    nav.nodes[i].component = nav.numcomponents;
+    stack[0] = i;
+    count = 1;
+
+    while (count) {
+      n = stack[--count];
+
+      for (d = 0; d < 8; d++) {
+        next = nav.nodes[n].links[d];
+
+        if ((next >= 0) && (nav.nodes[next].component < 0)) {
+          nav.nodes[next].component = nav.numcomponents;
+          stack[count++] = next;
+        }
+      }
+    }
+
+    nav.numcomponents++;
+  }
+
+  Z_Free(stack);
+}
+
+/*
+ * Builds the graph for the map that was just loaded.
+ * Called from SpawnEntities, after the level memory
+ * of the previous map has been released.
+ */
+void Nav_Init(void)
+{
+  int headnode, numcolumns, x, y, n, i, start;
+  navnode_t *nodes;
+  navsearch_t *search;
+
+  memset(&nav, 0, sizeof(nav));
+
+  if (!sv.models[1]) {
+    return;
+  }
+
+  start = Sys_Milliseconds();
+  headnode = sv.models[1]->headnode;
+  VectorCopy(sv.models[1]->mins, nav.mins);
+
+  /* coarsen the grid on huge maps */
+  for (nav.cell = NAV_CELL;; nav.cell *= 2) {
+    nav.xcols = (int) ceil((sv.models[1]->maxs[0] - nav.mins[0]) / nav.cell);
+    nav.ycols = (int) ceil((sv.models[1]->maxs[1] - nav.mins[1]) / nav.cell);
+
+    if (nav.xcols * nav.ycols <= NAV_MAXCOLUMNS) {
+      break;
+    }
+  }
+
+  if ((nav.xcols <= 0) || (nav.ycols <= 0)) {
+    return;
+  }
+
+  numcolumns = nav.xcols * nav.ycols;
+  nav.firstnode = Z_TagMalloc(numcolumns * sizeof(int), TAG_LEVEL);
+  nav.numfloors = Z_TagMalloc(numcolumns * sizeof(int), TAG_LEVEL);
+  memset(nav.numfloors, 0, numcolumns * sizeof(int));
+  nodes = Z_TagMalloc(NAV_MAXNODES * sizeof(navnode_t), TAG_LEVEL);
+  nav.nodes = nodes;
+
+  for (y = 0; y < nav.ycols; y++) {
+    for (x = 0; x < nav.xcols; x++) {
+      Nav_FindFloors(x, y, headnode);
+    }
+  }
+
+  if (!nav.numnodes) {
+    Z_Free(nav.firstnode);
+    Z_Free(nav.numfloors);
+    Z_Free(nodes);
+    memset(&nav, 0, sizeof(nav));
+    return;
+  }
+
+  /* trim the node array down to what was used */
+  nav.nodes = Z_TagMalloc(nav.numnodes * sizeof(navnode_t), TAG_LEVEL);
+  memcpy(nav.nodes, nodes, nav.numnodes * sizeof(navnode_t));
+  Z_Free(nodes);
+
+  for (y = 0; y < nav.ycols; y++) {
+    for (x = 0; x < nav.xcols; x++) {
+      for (n = 0; n < nav.numfloors[Nav_Column(x, y)]; n++) {
+        Nav_LinkNode(x, y, nav.firstnode[Nav_Column(x, y)] + n, headnode);
+      }
+    }
+  }
+
+  Nav_MarkComponents();
+
+  for (i = 0; i < NAV_SEARCHES; i++) {
+    search = &nav.searches[i];
+    search->gcost = Z_TagMalloc(nav.numnodes * sizeof(float), TAG_LEVEL);
+    search->fcost = Z_TagMalloc(nav.numnodes * sizeof(float), TAG_LEVEL);
+    search->parent = Z_TagMalloc(nav.numnodes * sizeof(int), TAG_LEVEL);
+    search->stamps = Z_TagMalloc(nav.numnodes * sizeof(int), TAG_LEVEL);
+    memset(search->stamps, 0, nav.numnodes * sizeof(int));
+    search->heap = Z_TagMalloc(nav.numnodes * sizeof(int), TAG_LEVEL);
+    search->heappos = Z_TagMalloc(nav.numnodes * sizeof(int), TAG_LEVEL);
+    search->goal = -1;
+  }
+
+  nav.buildmsec = Sys_Milliseconds() - start;
+}
+
+/*
+ * Returns the node a monster standing at org is on, or -1
+ */
+static int Nav_NearestNode(vec3_t org)
+{
+  int x, y, cx, cy, i, col, best, ring;
+  float dz, bestdist, dist;
+  vec3_t delta;
+
+  if (!nav.numnodes) {
+    return -1;
+  }
+
+  cx = (int) floor((org[0] - nav.mins[0]) / nav.cell);
+  cy = (int) floor((org[1] - nav.mins[1]) / nav.cell);
+
+  best = -1;
+  bestdist = 0;
+
+  /* the own column first, the eight around it if that fails */
+  for (ring = 0; ring <= 1 && best < 0; ring++) {
+    for (y = cy - ring; y <= cy + ring; y++) {
+      for (x = cx - ring; x <= cx + ring; x++) {
+        if ((x < 0) || (y < 0) || (x >= nav.xcols) || (y >= nav.ycols)) {
+          continue;
+        }
+
+        col = Nav_Column(x, y);
+
+        for (i = nav.firstnode[col]; i < nav.firstnode[col] + nav.numfloors[col]; i++) {
+          VectorSubtract(nav.nodes[i].origin, org, delta);
+          dz = fabs(delta[2]);
+
+          if (dz > 2 * NAV_STEPSIZE) {
+            continue;
+          }
+
+          dist = delta[0] * delta[0] + delta[1] * delta[1] + dz * dz;
+
+          if ((best < 0) || (dist < bestdist)) {
+            best = i;
+            bestdist = dist;
+          }
+        }
+      }
+    }
+  }
+
+  return best;
+}
+
+/*
+ * Octile distance, what the links between the two nodes
+ * would cost if nothing were in the way
+ */
+static float Nav_Estimate(int a, int b)
+{
+  float dx, dy;
+
+  dx = fabs(nav.nodes[a].origin[0] - nav.nodes[b].origin[0]);
+  dy = fabs(nav.nodes[a].origin[1] - nav.nodes[b].origin[1]);
+
+  if (dx < dy) {
+    return dy + (M_SQRT2 - 1) * dx;
+  }
+
+  return dx + (M_SQRT2 - 1) * dy;
+}
+
+static void Nav_HeapSet(navsearch_t *search, int i, int node)
+{
+  search->heap[i] = node;
+  search->heappos[node] = i;
+}
+
+static void Nav_HeapUp(navsearch_t *search, int i)
+{
+  int node, up;
+
+  node = search->heap[i];
+
+  while (i > 0) {
+    up = (i - 1) / 2;
+
+    if (search->fcost[search->heap[up]] <= search->fcost[node]) {
+      break;
+    }
+
+    Nav_HeapSet(search, i, search->heap[up]);
+    i = up;
+  }
+
+  Nav_HeapSet(search, i, node);
+}
+
+static void Nav_HeapDown(navsearch_t *search, int i)
+{
+  int node, child;
+
+  node = search->heap[i];
+
+  while ((child = 2 * i + 1) < search->heapcount) {
+    if ((child + 1 < search->heapcount) &&
+        (search->fcost[search->heap[child + 1]] < search->fcost[search->heap[child]])) {
+      child++;
+    }
+
+    if (search->fcost[node] <= search->fcost[search->heap[child]]) {
+      break;
+    }
+
+    Nav_HeapSet(search, i, search->heap[child]);
+    i = child;
+  }
+
+  Nav_HeapSet(search, i, node);
+}
+
+static int Nav_HeapPop(navsearch_t *search)
+{
+  int node;
+
+  node = search->heap[0];
+  search->heapcount--;
+
+  if (search->heapcount) {
+    Nav_HeapSet(search, 0, search->heap[search->heapcount]);
+    Nav_HeapDown(search, 0);
+  }
+
+  return node;
+}
+
+/*
+ * Returns the search tree growing out from goal, or one
+ * from close enough to it, or NULL if there is none
+ */
+static navsearch_t *Nav_GetSearch(int goal)
+{
+  navsearch_t *search;
+  int i;
+
+  for (i = 0; i < NAV_SEARCHES; i++) {
+    search = &nav.searches[i];
+
+    if (search->goal == goal) {
+      return search;
+    }
+  }
+
+  /* a goal that keeps moving a few units, like a running
+     player, would otherwise restart the search every time */
+  for (i = 0; i < NAV_SEARCHES; i++) {
+    search = &nav.searches[i];
+
+    if ((search->goal >= 0) && (level.time < search->time + NAV_REPATH) &&
+        (nav.nodes[search->goal].component == nav.nodes[goal].component) &&
+        (Nav_Estimate(goal, search->goal) < NAV_NEARGOAL)) {
+      return search;
+    }
+  }
+
+  return NULL;
+}
+
+/*
+ * Starts a search tree from goal, recycling the least recently
+ * used one of those that are done or idle. A tree still working
+ * towards a start that was asked for last frame is kept, or its
+ * path would never be finished once there are more goals than
+ * trees. Returns NULL if all of them are busy.
+ */
+static navsearch_t *Nav_NewSearch(int goal)
+{
+  navsearch_t *search, *best;
+  int i;
+
+  best = NULL;
+
+  for (i = 0; i < NAV_SEARCHES; i++) {
+    search = &nav.searches[i];
+
+    if ((search->goal >= 0) && search->heapcount && (search->stamps[search->start] != search->stamp + 2) &&
+        (search->usedframe >= level.framenum - 1)) {
+      continue;
+    }
+
+    if (!best || (search->usedframe < best->usedframe)) {
+      best = search;
+    }
+  }
+
+  if (!best) {
+    return NULL;
+  }
+
+  search = best;
+
+  /* a node is open at stamp + 1 and closed at stamp + 2 */
+  if (search->stamp > 0x7ffffff0) {
+    memset(search->stamps, 0, nav.numnodes * sizeof(int));
+    search->stamp = 0;
+  }
+
+  search->stamp += 2;
+  search->goal = goal;
+  search->start = goal;
+  search->time = level.time;
+
+  search->gcost[goal] = 0;
+  search->fcost[goal] = 0;
+  search->parent[goal] = -1;
+  search->stamps[goal] = search->stamp + 1;
+  search->heapcount = 0;
+  Nav_HeapSet(search, search->heapcount++, goal);
+
+  return search;
+}
+
+/*
+ * A* from goal back to start. The search runs backwards so
+ * that its closed nodes, whose cost is final, all lead to
+ * the goal: monsters after the same goal share one search
+ * and most of them find their start already closed. Fills
+ * path with the first waypoints after start and returns
+ * how many there are, 0 if the goal can't be reached, or
+ * -1 if this frame's budget ran out before it was found
+ * or no search tree was free for it.
+ */
+static int Nav_FindPath(int start, int goal, int *path, int maxpath)
+{
+  navsearch_t *search;
+  int n, d, next, i, open, closed;
+  float cost;
+
+  if (nav.nodes[start].component != nav.nodes[goal].component) {
+    return 0;
+  }
+
+  if (nav.budgetframe != level.framenum) {
+    nav.budgetframe = level.framenum;
+    nav.budgetused = 0;
+  }
+
+  search = Nav_GetSearch(goal);
+
+  if (!search) {
+    /* don't throw a tree away for a search that can't run */
+    if (nav.budgetused >= g_navbudget->value) {
+      return -1;
+    }
+
+    search = Nav_NewSearch(goal);
+
+    if (!search) {
+      return -1;
+    }
+  }
+
+  search->usedframe = level.framenum;
+  open = search->stamp + 1;
+  closed = search->stamp + 2;
+
+  /* aim what is left of the open set at the new start */
+  if ((search->stamps[start] != closed) && (start != search->start)) {
+    search->start = start;
+
+    for (i = 0; i < search->heapcount; i++) {
+      n = search->heap[i];
+      search->fcost[n] = search->gcost[n] + Nav_Estimate(n, start);
+    }
+
+    for (i = search->heapcount / 2 - 1; i >= 0; i--) {
+      Nav_HeapDown(search, i);
+    }
+  }
+
+  while (search->stamps[start] != closed) {
+    if (!search->heapcount) {
+      return 0;
+    }
+
+    if (nav.budgetused >= g_navbudget->value) {
+      return -1;
+    }
+
+    nav.budgetused++;
+    n = Nav_HeapPop(search);
+    search->stamps[n] = closed;
+
+    for (d = 0; d < 8; d++) {
+      next = nav.nodes[n].links[d];
+
+      if ((next < 0) || (search->stamps[next] == closed)) {
+        continue;
+      }
+
+      cost = search->gcost[n] + ((d & 1) ? M_SQRT2 * nav.cell : nav.cell);
+
+      if ((search->stamps[next] == open) && (search->gcost[next] <= cost)) {
+        continue;
+      }
+
+      search->gcost[next] = cost;
+      search->fcost[next] = cost + Nav_Estimate(next, start);
+      search->parent[next] = n;
+
+      if (search->stamps[next] != open) {
+        search->stamps[next] = open;
+        Nav_HeapSet(search, search->heapcount++, next);
+      }
+
+      Nav_HeapUp(search, search->heappos[next]);
+    }
+  }
+
+  i = 0;
+
+  for (n = search->parent[start]; n >= 0 && i < maxpath; n = search->parent[n]) {
+    path[i++] = n;
+  }
+
+  return i;
+}
+
+/*
+ * Moves a walking monster along a path to its goal. Returns
+ * false when the caller should step around on its own, be it
+ * because the goal is close, there is no path or the way is
+ * blocked by something the graph doesn't know about.
+ */
+qboolean Nav_MoveToGoal(edict_t *ent, edict_t *goal, float dist)
+{
+  monsterinfo_t *mi;
+  vec3_t delta;
+  int start, end, count, i;
+
+  if (!ent || !goal || !nav.numnodes || !g_nav->value) {
+    return false;
+  }
+
+  if (ent->flags & (FL_FLY | FL_SWIM)) {
+    return false;
+  }
+
+  for (i = 0; i < 3; i++) {
+    if ((ent->mins[i] < nav_mins[i]) || (ent->maxs[i] > nav_maxs[i])) {
+      return false;
+    }
+  }
+
+  VectorSubtract(goal->s.origin, ent->s.origin, delta);
+
+  if (VectorLength(delta) < NAV_NEARGOAL) {
+    return false;
+  }
+
+  mi = &ent->monsterinfo;
+
+  /* knocked off the path, start over */
+  if (mi->navcount) {
+    VectorSubtract(nav.nodes[mi->navpath[0]].origin, ent->s.origin, delta);
+
+    if (delta[0] * delta[0] + delta[1] * delta[1] > 9 * nav.cell * nav.cell) {
+      mi->navcount = 0;
+    }
+  }
+
+  end = Nav_NearestNode(goal->s.origin);
+
+  if ((end >= 0) && (end != mi->navgoal || !mi->navcount) && (level.time >= mi->navtime)) {
+    start = Nav_NearestNode(ent->s.origin);
+
+    if (start < 0) {
+      return false;
+    }
+
+    count = (start == end) ? 0 : Nav_FindPath(start, end, mi->navpath, NAV_MAXPATH);
+
+    if (count < 0) {
+      return false; /* try again next frame */
+    }
+
+    mi->navcount = count;
+    mi->navgoal = end;
+    mi->navtime = level.time + (count ? NAV_REPATH : NAV_RETRY);
+  }
+
+  /* drop the waypoints we have reached */
+  while (mi->navcount) {
+    VectorSubtract(nav.nodes[mi->navpath[0]].origin, ent->s.origin, delta);
+
+    if (delta[0] * delta[0] + delta[1] * delta[1] > dist * dist + nav.cell * nav.cell / 4) {
+      break;
+    }
+
+    mi->navcount--;
+    memmove(mi->navpath, mi->navpath + 1, mi->navcount * sizeof(mi->navpath[0]));
+  }
+
+  if (!mi->navcount) {
+    return false;
+  }
+
+  if (SV_StepDirection(ent, vectoyaw(delta), dist)) {
+    return true;
+  }
+
+  /* something the graph doesn't know about is in the
+     way, step around it for a while and then repath */
+  mi->navcount = 0;
+  mi->navtime = level.time + NAV_BLOCKED;
+  return false;
+}
+
+void Nav_Stats(void)
+{
+  if (!nav.numnodes) {
+    PF_cprintf(NULL, PRINT_HIGH, "No navigation graph.\n");
+    return;
+  }
+
+  PF_cprintf(NULL, PRINT_HIGH, "%i x %i columns of %i units\n", nav.xcols, nav.ycols, nav.cell);
+  PF_cprintf(NULL, PRINT_HIGH, "%i nodes, %i links, %i components\n", nav.numnodes, nav.numlinks, nav.numcomponents);
+  PF_cprintf(NULL, PRINT_HIGH, "built in %i msec\n", nav.buildmsec);
+}
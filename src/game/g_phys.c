@@ -137,6 +137,9 @@ void SV_Impact(edict_t *e1, trace_t *trace)
 
   e2 = trace->ent;
 
+  G_WakeEntity(e1);
+  G_WakeEntity(e2);
+
   if (e1->touch && (e1->solid != SOLID_NOT)) {
     e1->touch(e1, e2, &trace->plane, trace->surface);
   }
@@ -1075,3 +1078,255 @@ void G_RunEntity(edict_t *ent)
     PF_error("SV_Physics: bad movetype %i", (int) ent->movetype);
   }
 }
+
+/* ================================================================== */
+
+/* DORMANT ENTITIES */
+
+/*
+ * Most entities in a level spend their time waiting:
+ * items lying on the floor, triggers, closed doors
+ * and corpses. With g_dormant set, G_RunFrame only
+ * visits the awake set. An entity that has come to
+ * rest is parked, for good or in the think wheel
+ * until its nextthink comes up. Anything that can
+ * disturb a parked entity (linking, touching, use,
+ * damage or starting a mover) wakes it up again.
+ */
+
+static void G_UnwheelEntity(edict_t *ent)
+{
+  edict_t **head;
+
+  if (!ent->wakeframe) {
+    return;
+  }
+
+  head = &level.thinkwheel[ent->wakeframe & (THINKWHEEL_SIZE - 1)];
+
+  if (ent->wheelprev) {
+    ent->wheelprev->wheelnext = ent->wheelnext;
+  } else {
+    *head = ent->wheelnext;
+  }
+
+  if (ent->wheelnext) {
+    ent->wheelnext->wheelprev = ent->wheelprev;
+  }
+
+  ent->wheelnext = ent->wheelprev = NULL;
+  ent->wakeframe = 0;
+}
+
+static void G_WheelEntity(edict_t *ent, float nextthink)
+{
+  edict_t **head;
+  int frame;
+
+  /* SV_RunThink fires once level.time is within a
+     millisecond of nextthink, so err on the early
+     side and let the entity go back to sleep */
+  frame = (int) ((nextthink - 0.01) / FRAMETIME);
+
+  if (frame <= level.framenum) {
+    frame = level.framenum + 1;
+  }
+
+  head = &level.thinkwheel[frame & (THINKWHEEL_SIZE - 1)];
+
+  ent->wakeframe = frame;
+  ent->wheelprev = NULL;
+  ent->wheelnext = *head;
+
+  if (*head) {
+    (*head)->wheelprev = ent;
+  }
+
+  *head = ent;
+}
+
+/*
+ * Returns true if running the entity would do
+ * nothing but check its nextthink
+ */
+static qboolean G_EntityAtRest(edict_t *ent)
+{
+  edict_t *part;
+
+  if (ent->prethink) {
+    return false;
+  }
+
+  /* G_RunFrame has to catch old_origin up first */
+  if (!VectorCompare(ent->s.origin, ent->s.old_origin)) {
+    return false;
+  }
+
+  /* only the world is known to stay put under
+     whatever rests on it */
+  if (ent->groundentity && (ent->groundentity != g_edicts)) {
+    return false;
+  }
+
+  switch ((int) ent->movetype) {
+  case MOVETYPE_NONE:
+    return true;
+  case MOVETYPE_PUSH:
+  case MOVETYPE_STOP:
+    /* the team captain moves and thinks for the slaves */
+    if (ent->flags & FL_TEAMSLAVE) {
+      return true;
+    }
+
+    for (part = ent; part; part = part->teamchain) {
+      if (!VectorCompare(part->velocity, vec3_origin) || !VectorCompare(part->avelocity, vec3_origin)) {
+        return false;
+      }
+    }
+
+    return true;
+  case MOVETYPE_NOCLIP:
+    return VectorCompare(ent->velocity, vec3_origin) && VectorCompare(ent->avelocity, vec3_origin);
+  case MOVETYPE_STEP:
+    return ent->groundentity && VectorCompare(ent->velocity, vec3_origin) &&
+           VectorCompare(ent->avelocity, vec3_origin);
+  case MOVETYPE_TOSS:
+  case MOVETYPE_BOUNCE:
+  case MOVETYPE_FLY:
+  case MOVETYPE_FLYMISSILE:
+    if (ent->flags & FL_TEAMSLAVE) {
+      return true;
+    }
+
+    return ent->groundentity && (ent->velocity[2] <= 0);
+  default:
+    return false;
+  }
+}
+
+/*
+ * Called at the start of every frame to fill
+ * the awake set for G_RunFrame
+ */
+void G_ScheduleEntities(void)
+{
+  edict_t *ent, *next;
+  int i;
+
+  if (!g_dormant->value) {
+    level.scheduled = false;
+    return;
+  }
+
+  if (!level.scheduled) {
+    /* new level or just switched on, everything
+       gets a look before it can be parked */
+    for (i = 0; i < THINKWHEEL_SIZE; i++) {
+      while (level.thinkwheel[i]) {
+        G_UnwheelEntity(level.thinkwheel[i]);
+      }
+    }
+
+    memset(level.awake, 0xff, sizeof(level.awake));
+    level.scheduled = true;
+    return;
+  }
+
+  for (ent = level.thinkwheel[level.framenum & (THINKWHEEL_SIZE - 1)]; ent; ent = next) {
+    next = ent->wheelnext;
+
+    /* further out than one turn of the wheel */
+    if (ent->wakeframe > level.framenum) {
+      continue;
+    }
+
+    G_UnwheelEntity(ent);
+    G_WakeEntity(ent);
+  }
+}
+
+/*
+ * Puts the entity back into the awake set. Cheap
+ * enough to call whenever an entity might have
+ * been disturbed.
+ */
+void G_WakeEntity(edict_t *ent)
+{
+  int n;
+
+  if (!ent) {
+    return;
+  }
+
+  n = ent - g_edicts;
+  level.awake[n >> 5] |= 1u << (n & 31);
+
+  /* slaves are moved by their captain */
+  if ((ent->flags & FL_TEAMSLAVE) && ent->teammaster) {
+    n = ent->teammaster - g_edicts;
+    level.awake[n >> 5] |= 1u << (n & 31);
+  }
+}
+
+/*
+ * Called after the entity ran this frame, parks
+ * it if it has come to rest
+ */
+void G_SleepEntity(edict_t *ent)
+{
+  edict_t *part;
+  float nextthink;
+  int n;
+
+  if (!level.scheduled) {
+    return;
+  }
+
+  G_UnwheelEntity(ent);
+
+  if (ent->inuse && !G_EntityAtRest(ent)) {
+    return;
+  }
+
+  n = ent - g_edicts;
+  level.awake[n >> 5] &= ~(1u << (n & 31));
+
+  if (!ent->inuse) {
+    return;
+  }
+
+  nextthink = ent->nextthink;
+
+  if ((ent->movetype == MOVETYPE_PUSH) || (ent->movetype == MOVETYPE_STOP)) {
+    if (ent->flags & FL_TEAMSLAVE) {
+      return;
+    }
+
+    for (part = ent->teamchain; part; part = part->teamchain) {
+      if ((part->nextthink > 0) && ((nextthink <= 0) || (part->nextthink < nextthink))) {
+        nextthink = part->nextthink;
+      }
+    }
+  }
+
+  if (nextthink > 0) {
+    G_WheelEntity(ent, nextthink);
+  }
+}
+
+/*
+ * Drops a freed entity from the schedule
+ */
+void G_ForgetEntity(edict_t *ent)
+{
+  int n;
+
+  if (!ent) {
+    return;
+  }
+
+  G_UnwheelEntity(ent);
+
+  n = ent - g_edicts;
+  level.awake[n >> 5] &= ~(1u << (n & 31));
+}
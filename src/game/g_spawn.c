@@ -232,15 +232,88 @@ spawn_t spawns[] = {{"item_health", SP_item_health},
                     {NULL, NULL}};
 
 /*
- * Finds the spawn function for
- * the entity and calls it
+ * Items and spawn functions by classname, in an open
+ * addressed table built on first use. Items are put
+ * in first, they win over a spawn function of the
+ * same name just like the old search order.
  */
-void ED_CallSpawn(edict_t *ent)
+#define SPAWNHASH_SIZE 512 /* power of two, well over twice the entries */
+
+typedef struct
+{
+  char *name;
+  gitem_t *item;
+  void (*spawn)(edict_t *ent);
+} spawnslot_t;
+
+static spawnslot_t spawnhash[SPAWNHASH_SIZE];
+static qboolean spawnhash_built;
+
+static unsigned ED_SpawnHash(const char *name)
+{
+  unsigned hash;
+
+  for (hash = 0; *name; name++) {
+    hash = hash * 31 + (byte) *name;
+  }
+
+  return hash;
+}
+
+static spawnslot_t *ED_SpawnSlot(const char *name)
+{
+  spawnslot_t *slot;
+  unsigned h;
+
+  for (h = ED_SpawnHash(name);; h++) {
+    slot = &spawnhash[h & (SPAWNHASH_SIZE - 1)];
+
+    if (!slot->name || !strcmp(slot->name, name)) {
+      return slot;
+    }
+  }
+}
+
+static void ED_BuildSpawnHash(void)
 {
+  spawnslot_t *slot;
   spawn_t *s;
   gitem_t *item;
   int i;
 
+  for (i = 0, item = itemlist; i < game.num_items; i++, item++) {
+    if (!item->classname) {
+      continue;
+    }
+
+    slot = ED_SpawnSlot(item->classname);
+
+    if (!slot->name) {
+      slot->name = item->classname;
+      slot->item = item;
+    }
+  }
+
+  for (s = spawns; s->name; s++) {
+    slot = ED_SpawnSlot(s->name);
+
+    if (!slot->name) {
+      slot->name = s->name;
+      slot->spawn = s->spawn;
+    }
+  }
+
+  spawnhash_built = true;
+}
+
+/*
+ * Finds the spawn function for
+ * the entity and calls it
+ */
+void ED_CallSpawn(edict_t *ent)
+{
+  spawnslot_t *slot;
+
   if (!ent) {
     return;
   }
@@ -251,26 +324,22 @@ void ED_CallSpawn(edict_t *ent)
     return;
   }
 
-  /* check item spawn functions */
-  for (i = 0, item = itemlist; i < game.num_items; i++, item++) {
-    if (!item->classname) {
-      continue;
-    }
+  if (!spawnhash_built) {
+    ED_BuildSpawnHash();
+  }
 
-    if (!strcmp(item->classname, ent->classname)) {
-      /* found it */
-      SpawnItem(ent, item);
-      return;
-    }
+  slot = ED_SpawnSlot(ent->classname);
+
+  if (slot->item) {
+    /* found it */
+    SpawnItem(ent, slot->item);
+    return;
   }
 
-  /* check normal spawn functions */
-  for (s = spawns; s->name; s++) {
-    if (!strcmp(s->name, ent->classname)) {
-      /* found it */
-      s->spawn(ent);
-      return;
-    }
+  if (slot->spawn) {
+    /* found it */
+    slot->spawn(ent);
+    return;
   }
 
   PF_dprintf("%s doesn't have a spawn function\n", ent->classname);
@@ -424,7 +493,11 @@ char *ED_ParseEdict(char *data, edict_t *ent)
   }
 
   if (!init) {
+    G_UnindexNames(ent);
     memset(ent, 0, sizeof(*ent));
+  } else {
+    /* the fields were written directly */
+    G_IndexNames(ent);
   }
 
   return data;
@@ -526,6 +599,8 @@ void SpawnEntities(const char *mapname, char *entities, const char *spawnpoint)
   memset(&level, 0, sizeof(level));
   memset(g_edicts, 0, game.maxentities * sizeof(g_edicts[0]));
 
+  Nav_Init();
+
   Q_strlcpy(level.mapname, mapname, sizeof(level.mapname));
   Q_strlcpy(game.spawnpoint, spawnpoint, sizeof(game.spawnpoint));
 
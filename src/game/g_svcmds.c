@@ -294,6 +294,8 @@ void ServerCommand(void)
     SVCmd_ListIP_f();
   } else if (Q_stricmp(cmd, "writeip") == 0) {
     SVCmd_WriteIP_f();
+  } else if (Q_stricmp(cmd, "nav") == 0) {
+    Nav_Stats();
   } else {
     PF_cprintf(NULL, PRINT_HIGH, "Unknown server command \"%s\"\n", cmd);
   }
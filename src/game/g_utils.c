@@ -35,6 +35,180 @@ void G_ProjectSource(vec3_t point, vec3_t distance, vec3_t forward, vec3_t right
   result[2] = point[2] + forward[2] * distance[0] + right[2] * distance[1] + distance[2];
 }
 
+/*
+ * classname and targetname are indexed for G_Find. Every
+ * hash bucket chains its entities in edict order, so a
+ * G_Find walk through the index returns the same entities
+ * in the same order as a walk over the whole edict list.
+ * The fields must be changed through G_SetClassname and
+ * G_SetTargetname, or indexed again with G_IndexNames.
+ */
+static const int g_namefields[NUM_NAMEINDEXES] = {FOFS(classname), FOFS(targetname)};
+
+static int G_NameHash(const char *name)
+{
+  unsigned hash;
+  int c;
+
+  /* G_Find matches without case */
+  for (hash = 0; *name; name++) {
+    c = (byte) *name;
+
+    if ((c >= 'A') && (c <= 'Z')) {
+      c += 'a' - 'A';
+    }
+
+    hash = hash * 31 + c;
+  }
+
+  return hash & (NAMEHASH_SIZE - 1);
+}
+
+static char *G_NameField(edict_t *ent, int index)
+{
+  return *(char **) ((byte *) ent + g_namefields[index]);
+}
+
+static void G_UnlinkName(edict_t *ent, int index)
+{
+  namelink_t *link;
+
+  link = &ent->namelinks[index];
+
+  if (!link->linked) {
+    return;
+  }
+
+  if (link->prev) {
+    link->prev->namelinks[index].next = link->next;
+  } else {
+    level.namehead[index][link->bucket] = link->next;
+  }
+
+  if (link->next) {
+    link->next->namelinks[index].prev = link->prev;
+  } else {
+    level.nametail[index][link->bucket] = link->prev;
+  }
+
+  memset(link, 0, sizeof(*link));
+}
+
+static void G_LinkName(edict_t *ent, int index)
+{
+  namelink_t *link;
+  edict_t *e;
+  char *name;
+  int h;
+
+  name = G_NameField(ent, index);
+
+  if (!name) {
+    return;
+  }
+
+  h = G_NameHash(name);
+
+  /* entities mostly come in ascending order,
+     so look for the spot from the tail */
+  for (e = level.nametail[index][h]; e && (e > ent); e = e->namelinks[index].prev) {
+  }
+
+  link = &ent->namelinks[index];
+  link->bucket = h;
+  link->linked = true;
+  link->prev = e;
+
+  if (e) {
+    link->next = e->namelinks[index].next;
+    e->namelinks[index].next = ent;
+  } else {
+    link->next = level.namehead[index][h];
+    level.namehead[index][h] = ent;
+  }
+
+  if (link->next) {
+    link->next->namelinks[index].prev = ent;
+  } else {
+    level.nametail[index][h] = ent;
+  }
+}
+
+/*
+ * Indexes the entity under its current names,
+ * for when they were written directly
+ */
+void G_IndexNames(edict_t *ent)
+{
+  int i;
+
+  for (i = 0; i < NUM_NAMEINDEXES; i++) {
+    G_UnlinkName(ent, i);
+    G_LinkName(ent, i);
+  }
+}
+
+void G_UnindexNames(edict_t *ent)
+{
+  int i;
+
+  for (i = 0; i < NUM_NAMEINDEXES; i++) {
+    G_UnlinkName(ent, i);
+  }
+}
+
+void G_SetClassname(edict_t *ent, char *classname)
+{
+  G_UnlinkName(ent, NAMEINDEX_CLASSNAME);
+  ent->classname = classname;
+  G_LinkName(ent, NAMEINDEX_CLASSNAME);
+}
+
+void G_SetTargetname(edict_t *ent, char *targetname)
+{
+  G_UnlinkName(ent, NAMEINDEX_TARGETNAME);
+  ent->targetname = targetname;
+  G_LinkName(ent, NAMEINDEX_TARGETNAME);
+}
+
+static edict_t *G_FindIndexed(edict_t *from, int index, char *match)
+{
+  namelink_t *link;
+  edict_t *e;
+  char *s;
+  int h;
+
+  h = G_NameHash(match);
+
+  if (!from) {
+    e = level.namehead[index][h];
+  } else {
+    link = &from->namelinks[index];
+
+    if (link->linked && (link->bucket == h)) {
+      e = link->next;
+    } else {
+      /* from was renamed or freed since */
+      for (e = level.namehead[index][h]; e && (e <= from); e = e->namelinks[index].next) {
+      }
+    }
+  }
+
+  for (; e; e = e->namelinks[index].next) {
+    if (!e->inuse) {
+      continue;
+    }
+
+    s = G_NameField(e, index);
+
+    if (s && !Q_stricmp(s, match)) {
+      return e;
+    }
+  }
+
+  return NULL;
+}
+
 /*
  * Searches all active entities for the next
  * one that holds the matching string at fieldofs
@@ -47,6 +221,17 @@ void G_ProjectSource(vec3_t point, vec3_t distance, vec3_t forward, vec3_t right
 edict_t *G_Find(edict_t *from, int fieldofs, char *match)
 {
   char *s;
+  int i;
+
+  if (!match) {
+    return NULL;
+  }
+
+  for (i = 0; i < NUM_NAMEINDEXES; i++) {
+    if (fieldofs == g_namefields[i]) {
+      return G_FindIndexed(from, i, match);
+    }
+  }
 
   if (!from) {
     from = g_edicts;
@@ -54,10 +239,6 @@ edict_t *G_Find(edict_t *from, int fieldofs, char *match)
     from++;
   }
 
-  if (!match) {
-    return NULL;
-  }
-
   for (; from < &g_edicts[globals.num_edicts]; from++) {
     if (!from->inuse) {
       continue;
@@ -193,7 +374,7 @@ void G_UseTargets(edict_t *ent, edict_t *activator)
   if (ent->delay) {
     /* create a temp object to fire at a later time */
     t = G_Spawn();
-    t->classname = "DelayedUse";
+    G_SetClassname(t, "DelayedUse");
     t->nextthink = level.time + ent->delay;
     t->think = Think_Delay;
     t->activator = activator;
@@ -261,6 +442,7 @@ void G_UseTargets(edict_t *ent, edict_t *activator)
         PF_dprintf("WARNING: Entity used itself.\n");
       } else {
         if (t->use) {
+          G_WakeEntity(t);
           t->use(t, ent, activator);
         }
       }
@@ -407,9 +589,11 @@ char *G_CopyString(char *in)
 void G_InitEdict(edict_t *e)
 {
   e->inuse = true;
-  e->classname = "noclass";
+  G_SetClassname(e, "noclass");
   e->gravity = 1.0;
   e->s.number = e - g_edicts;
+
+  G_WakeEntity(e);
 }
 
 /*
@@ -465,6 +649,9 @@ void G_FreeEdict(edict_t *ed)
     }
   }
 
+  G_ForgetEntity(ed);
+  G_UnindexNames(ed);
+
   memset(ed, 0, sizeof(*ed));
   ed->classname = "freed";
   ed->freetime = level.time;
@@ -500,6 +687,7 @@ void G_TouchTriggers(edict_t *ent)
       continue;
     }
 
+    G_WakeEntity(hit);
     hit->touch(hit, ent, NULL, NULL);
   }
 }
@@ -531,6 +719,7 @@ void G_TouchSolids(edict_t *ent)
     }
 
     if (ent->touch) {
+      G_WakeEntity(hit);
       ent->touch(hit, ent, NULL, NULL);
     }
 
@@ -548,11 +737,45 @@ void G_TouchSolids(edict_t *ent)
 qboolean KillBox(edict_t *ent)
 {
   trace_t tr;
+  edict_t *touch[MAX_EDICTS], *hit;
+  vec3_t mins, maxs;
+  int i, num;
 
   if (!ent) {
     return false;
   }
 
+  /* nail the box entities from a single area
+     query instead of tracing again after each
+     one. they come in SV_AreaEdicts order, not
+     edict order */
+  VectorAdd(ent->s.origin, ent->mins, mins);
+  VectorAdd(ent->s.origin, ent->maxs, maxs);
+
+  num = SV_AreaEdicts(mins, maxs, touch, MAX_EDICTS, AREA_SOLID);
+
+  for (i = 0; i < num; i++) {
+    hit = touch[i];
+
+    /* the ones a MASK_PLAYERSOLID trace would hit */
+    if (!hit->inuse || (hit == ent) || (hit->solid != SOLID_BBOX) || (hit->svflags & SVF_DEADMONSTER)) {
+      continue;
+    }
+
+    if ((hit->s.origin[0] + hit->mins[0] > maxs[0]) || (hit->s.origin[1] + hit->mins[1] > maxs[1]) ||
+        (hit->s.origin[2] + hit->mins[2] > maxs[2]) || (hit->s.origin[0] + hit->maxs[0] < mins[0]) ||
+        (hit->s.origin[1] + hit->maxs[1] < mins[1]) || (hit->s.origin[2] + hit->maxs[2] < mins[2])) {
+      continue;
+    }
+
+    T_Damage(hit, ent, ent, vec3_origin, ent->s.origin, vec3_origin, 100000, 0, DAMAGE_NO_PROTECTION, MOD_TELEFRAG);
+
+    if (hit->solid) {
+      return false;
+    }
+  }
+
+  /* bmodels and the world are left to the trace */
   while (1) {
     tr = SV_Trace(ent->s.origin, ent->mins, ent->maxs, ent->s.origin, NULL, MASK_PLAYERSOLID);
 
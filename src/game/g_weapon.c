@@ -406,7 +406,7 @@ void fire_blaster(edict_t *self, vec3_t start, vec3_t dir, int damage, int speed
   bolt->nextthink = level.time + 2;
   bolt->think = G_FreeEdict;
   bolt->dmg = damage;
-  bolt->classname = "bolt";
+  G_SetClassname(bolt, "bolt");
 
   if (hyper) {
     bolt->spawnflags = 1;
@@ -560,7 +560,7 @@ void fire_grenade(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int sp
   grenade->think = Grenade_Explode;
   grenade->dmg = damage;
   grenade->dmg_radius = damage_radius;
-  grenade->classname = "grenade";
+  G_SetClassname(grenade, "grenade");
 
   SV_LinkEdict(grenade);
 }
@@ -598,7 +598,7 @@ void fire_grenade2(edict_t *self, vec3_t start, vec3_t aimdir, int damage, int s
   grenade->think = Grenade_Explode;
   grenade->dmg = damage;
   grenade->dmg_radius = damage_radius;
-  grenade->classname = "hgrenade";
+  G_SetClassname(grenade, "hgrenade");
 
   if (held) {
     grenade->spawnflags = 3;
@@ -706,7 +706,7 @@ void fire_rocket(edict_t *self, vec3_t start, vec3_t dir, int damage, int speed,
   rocket->radius_dmg = radius_damage;
   rocket->dmg_radius = damage_radius;
   rocket->s.sound = SV_SoundIndex("weapons/rockfly.wav");
-  rocket->classname = "rocket";
+  G_SetClassname(rocket, "rocket");
 
   if (self->client) {
     check_dodge(self, rocket->s.origin, dir, speed);
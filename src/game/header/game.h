@@ -94,6 +94,23 @@ typedef struct gclient_s gclient_t;
 
 #define FRAMETIME 0.1
 
+#define THINKWHEEL_SIZE 64 /* frames, must be a power of two */
+
+#define NAV_MAXPATH 32 /* waypoints a monster keeps ahead of it */
+
+/* G_Find keeps these fields indexed */
+#define NAMEINDEX_CLASSNAME 0
+#define NAMEINDEX_TARGETNAME 1
+#define NUM_NAMEINDEXES 2
+#define NAMEHASH_SIZE 256
+
+typedef struct
+{
+  edict_t *next, *prev; /* in edict order */
+  int bucket;
+  qboolean linked;
+} namelink_t;
+
 /* memory tags to allow dynamic memory to be cleaned up */
 #define TAG_GAME 765  /* clear when unloading the dll */
 #define TAG_LEVEL 766 /* clear when loading a new level */
@@ -333,6 +350,15 @@ typedef struct
 
   edict_t *current_entity; /* entity running from G_RunFrame */
   int body_que;            /* dead bodies */
+
+  /* dormant entity scheduling */
+  qboolean scheduled;                   /* the sets below are valid */
+  unsigned awake[MAX_EDICTS / 32];      /* entities G_RunFrame visits */
+  edict_t *thinkwheel[THINKWHEEL_SIZE]; /* parked entities by wake frame */
+
+  /* G_Find name indexes */
+  edict_t *namehead[NUM_NAMEINDEXES][NAMEHASH_SIZE];
+  edict_t *nametail[NUM_NAMEINDEXES][NAMEHASH_SIZE];
 } level_locals_t;
 
 /* spawn_temp_t is only used to hold entity field values that
@@ -447,6 +473,11 @@ typedef struct
   int lefty;
   float idle_time;
   int linkcount;
+
+  int navpath[NAV_MAXPATH]; /* graph nodes towards goalentity */
+  int navcount;
+  int navgoal;
+  float navtime; /* next time the path may be searched */
 } monsterinfo_t;
 
 extern game_locals_t game;
@@ -543,6 +574,10 @@ extern cvar_t *flood_waitdelay;
 
 extern cvar_t *sv_maplist;
 
+extern cvar_t *g_dormant;
+extern cvar_t *g_nav;
+extern cvar_t *g_navbudget;
+
 #define world (&g_edicts[0])
 
 /* item spawnflags */
@@ -622,6 +657,14 @@ void G_ProjectSource(vec3_t point, vec3_t distance, vec3_t forward, vec3_t right
 
 edict_t *G_Find(edict_t *from, int fieldofs, char *match);
 
+void G_SetClassname(edict_t *ent, char *classname);
+
+void G_SetTargetname(edict_t *ent, char *targetname);
+
+void G_IndexNames(edict_t *ent);
+
+void G_UnindexNames(edict_t *ent);
+
 edict_t *findradius(edict_t *from, vec3_t org, float rad);
 
 edict_t *G_PickTarget(char *targetname);
@@ -835,11 +878,28 @@ qboolean M_walkmove(edict_t *ent, float yaw, float dist);
 
 void M_MoveToGoal(edict_t *ent, float dist);
 
+qboolean SV_StepDirection(edict_t *ent, float yaw, float dist);
+
 void M_ChangeYaw(edict_t *ent);
 
+/* g_nav.c */
+void Nav_Init(void);
+
+qboolean Nav_MoveToGoal(edict_t *ent, edict_t *goal, float dist);
+
+void Nav_Stats(void);
+
 /* g_phys.c */
 void G_RunEntity(edict_t *ent);
 
+void G_ScheduleEntities(void);
+
+void G_WakeEntity(edict_t *ent);
+
+void G_SleepEntity(edict_t *ent);
+
+void G_ForgetEntity(edict_t *ent);
+
 /* g_main.c */
 void SaveClientData(void);
 
@@ -1026,20 +1086,21 @@ struct edict_s
 
   /* only used locally in game, not by server */
   char *message;
-  char *classname;
+  char *classname; /* change with G_SetClassname */
   int spawnflags;
 
   float timestamp;
 
   float angle; /* set in qe3, -1 = up, -2 = down */
   char *target;
-  char *targetname;
+  char *targetname; /* change with G_SetTargetname */
   char *killtarget;
   char *team;
   char *pathtarget;
   char *deathtarget;
   char *combattarget;
   edict_t *target_ent;
+  namelink_t namelinks[NUM_NAMEINDEXES]; /* classname, targetname */
 
   float speed, accel, decel;
   vec3_t movedir;
@@ -1058,6 +1119,8 @@ struct edict_s
   float ideal_yaw;
 
   float nextthink;
+  int wakeframe; /* frame a parked entity is due, 0 if not in the think wheel */
+  edict_t *wheelnext, *wheelprev;
 
   void (*prethink)(edict_t *ent);
 
@@ -1200,6 +1263,9 @@ cvar_t *flood_waitdelay;
 cvar_t *sv_maplist;
 
 cvar_t *gib_on;
+cvar_t *g_dormant;
+cvar_t *g_nav;
+cvar_t *g_navbudget;
 
 void SpawnEntities(const char *mapname, char *entities, const char *spawnpoint);
 
@@ -549,6 +549,11 @@ void M_MoveToGoal(edict_t *ent, float dist)
     return;
   }
 
+  /* follow the navigation graph while the goal is far off */
+  if (Nav_MoveToGoal(ent, goal, dist)) {
+    return;
+  }
+
   /* bump around... */
   if (((randk() & 3) == 1) || !SV_StepDirection(ent, ent->ideal_yaw, dist)) {
     if (ent->inuse) {
@@ -867,7 +867,7 @@ void InitBodyQue(void)
 
     for (i = 0; i < BODY_QUEUE_SIZE; i++) {
       ent = G_Spawn();
-      ent->classname = "bodyque";
+      G_SetClassname(ent, "bodyque");
     }
   }
 }
@@ -1120,7 +1120,7 @@ void PutClientInServer(edict_t *ent)
   ent->movetype = MOVETYPE_WALK;
   ent->viewheight = 22;
   ent->inuse = true;
-  ent->classname = "player";
+  G_SetClassname(ent, "player");
   ent->mass = 200;
   ent->solid = SOLID_BBOX;
   ent->deadflag = DEAD_NO;
@@ -1279,7 +1279,7 @@ void ClientBegin(edict_t *ent)
        except for the persistant data that was initialized at
        ClientConnect() time */
     G_InitEdict(ent);
-    ent->classname = "player";
+    G_SetClassname(ent, "player");
     InitClientResp(ent->client);
     PutClientInServer(ent);
   }
@@ -1476,7 +1476,7 @@ void ClientDisconnect(edict_t *ent)
   ent->s.modelindex = 0;
   ent->solid = SOLID_NOT;
   ent->inuse = false;
-  ent->classname = "disconnected";
+  G_SetClassname(ent, "disconnected");
   ent->client->pers.connected = false;
 
   playernum = ent - g_edicts - 1;
@@ -1635,6 +1635,7 @@ void ClientThink(edict_t *ent, usercmd_t *ucmd)
         continue;
       }
 
+      G_WakeEntity(other);
       other->touch(other, ent, NULL, NULL);
     }
   }
@@ -8,10 +8,11 @@
 qboolean gfx_init();
 void gfx_get_desktop_size(int *width, int *height);
 qboolean gfx_create_window(qboolean fullscreen, qboolean vsync, int win_width, int win_height, int render_width,
-                           int render_height);
+                           int render_height, int present_queue);
+void gfx_resize_render(int render_width, int render_height);
 void gfx_window_grab_input(qboolean grab);
 qboolean gfx_update_fullscreen(qboolean fullscreen);
-void gfx_update(swstate_t sw_state, viddef_t vid);
+void gfx_update(const swstate_t *sw_state, viddef_t vid);
 qboolean gfx_is_fullscreen();
 int gfx_get_refresh_rate();
 void gfx_reset_refresh_rate();
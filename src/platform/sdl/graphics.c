@@ -2,9 +2,7 @@
 #include "../graphics.h"
 
 static SDL_Window *window = NULL;
-static SDL_Surface *surface = NULL;
-static SDL_Surface *surface_indexed = NULL; // 8-bit indexed source surface
-static SDL_Texture *texture = NULL;
+static SDL_Texture *texture = NULL; // streaming, paletted frames are expanded straight into it
 static SDL_Texture *texture_upscaled = NULL;
 static SDL_Renderer *renderer = NULL;
 static int refreshRate = -1;
@@ -15,6 +13,36 @@ static int render_height = 0;
 static int window_width = 0;
 static int window_height = 0;
 
+// Palette as ARGB8888 texels, rebuilt when the renderer's palette changes
+static Uint32 palette_lut[256];
+static int palette_generation = -1;
+
+// Present pipeline. SDL's render API belongs to the main thread, so only the
+// palette expansion moves off it: gfx_update copies the frame into a free slot
+// for a worker to expand to ARGB, and uploads and presents the newest frame the
+// worker has finished so far. Frames overtaken by a newer one are dropped, so
+// there is at most one present, and one vsync wait, per gfx_update, and that
+// wait stays on the main thread. A frame shows one gfx_update after it was
+// drawn.
+#define PRESENT_SLOTS 3 // waiting, being expanded and finished
+
+typedef struct
+{
+  pixel_t *pixels;
+  Uint32 *texels; // pixels expanded by the worker
+  unsigned char palette[1024];
+  int palettegeneration;
+} presentframe_t;
+
+static SDL_Thread *present_thread = NULL;
+static SDL_mutex *present_lock = NULL;
+static SDL_cond *present_cond = NULL; // signalled on any change below
+static presentframe_t present_frames[PRESENT_SLOTS];
+static int present_waiting = -1;  // slot queued for the worker, or -1
+static int present_working = -1;  // slot the worker is expanding, or -1
+static int present_finished = -1; // newest slot the worker has expanded, or -1
+static qboolean present_quit = false;
+
 qboolean gfx_init()
 {
   if (!SDL_WasInit(SDL_INIT_VIDEO)) {
@@ -48,7 +76,7 @@ void gfx_get_desktop_size(int *width, int *height)
   }
 }
 
-static void CreateUpscaledTexture(void)
+static void CreateUpscaledTexture(qboolean report)
 {
   int w, h;
   int w_upscale, h_upscale;
@@ -92,24 +120,333 @@ static void CreateUpscaledTexture(void)
 
   if (texture_upscaled == NULL) {
     Com_Printf("Failed to create upscaled texture: %s\n", SDL_GetError());
-  } else {
+  } else if (report) {
     Com_Printf("Created upscaled texture: %dx%d (scale %dx%d)\n", w_upscale * render_width, h_upscale * render_height,
                w_upscale, h_upscale);
   }
 }
 
-qboolean gfx_create_window(qboolean fullscreen, qboolean vsync, int win_width, int win_height, int rend_width,
-                           int rend_height)
+// (Re)creates the textures for the current render size
+static qboolean CreateTextures(qboolean report)
 {
-  Uint32 Rmask, Gmask, Bmask, Amask;
-  Uint32 flags = SDL_SWSURFACE;
-  int bpp;
-  int windowPos = SDL_WINDOWPOS_CENTERED;
+  if (texture) {
+    SDL_DestroyTexture(texture);
+  }
+
+  // Texture at render resolution (not window)
+  SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0");
+  texture =
+      SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, render_width, render_height);
+
+  if (texture == NULL) {
+    Com_Printf("Failed to create texture: %s\n", SDL_GetError());
+    return false;
+  }
+
+  // Create the upscaled texture for integer scaling
+  CreateUpscaledTexture(report);
+
+  return true;
+}
+
+static qboolean CreateRenderer(qboolean vsync)
+{
+  if (vsync) {
+    renderer = SDL_CreateRenderer(window, -1,
+                                  SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_TARGETTEXTURE);
+  } else {
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
+  }
+
+  if (renderer == NULL) {
+    Com_Printf("Failed to create renderer: %s\n", SDL_GetError());
+    return false;
+  }
+
+  // Clear to black until it loads
+  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+  SDL_RenderClear(renderer);
+  SDL_RenderPresent(renderer);
+
+  return CreateTextures(true);
+}
+
+static void DestroyRenderer(void)
+{
+  if (texture_upscaled) {
+    SDL_DestroyTexture(texture_upscaled);
+  }
+
+  texture_upscaled = NULL;
+
+  if (texture) {
+    SDL_DestroyTexture(texture);
+  }
+
+  texture = NULL;
+
+  if (renderer) {
+    SDL_DestroyRenderer(renderer);
+  }
+
+  renderer = NULL;
+}
+
+static void UpdatePaletteLUT(const unsigned char *palette, int generation)
+{
+  int i;
+
+  if (generation == palette_generation) {
+    return;
+  }
+
+  for (i = 0; i < 256; i++) {
+    palette_lut[i] = 0xff000000u | (palette[i * 4 + 0] << 16) | (palette[i * 4 + 1] << 8) | palette[i * 4 + 2];
+  }
+
+  palette_generation = generation;
+}
+
+// Expands a row of palette indices into ARGB texels, eight at a time. There is
+// no byte gather in baseline SSE2, so the indices are read as one 64-bit word
+// and looked up with independent stores the compiler can schedule freely.
+static void ExpandRow(Uint32 *dst, const pixel_t *src, int width)
+{
+  int x = 0;
+  Uint64 p;
+
+  for (; x + 8 <= width; x += 8) {
+    memcpy(&p, src + x, sizeof(p));
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    p = SDL_Swap64(p);
+#endif
+    dst[x + 0] = palette_lut[p & 0xff];
+    dst[x + 1] = palette_lut[(p >> 8) & 0xff];
+    dst[x + 2] = palette_lut[(p >> 16) & 0xff];
+    dst[x + 3] = palette_lut[(p >> 24) & 0xff];
+    dst[x + 4] = palette_lut[(p >> 32) & 0xff];
+    dst[x + 5] = palette_lut[(p >> 40) & 0xff];
+    dst[x + 6] = palette_lut[(p >> 48) & 0xff];
+    dst[x + 7] = palette_lut[p >> 56];
+  }
+
+  for (; x < width; x++) {
+    dst[x] = palette_lut[src[x]];
+  }
+}
+
+// Expands a frame into texels, with the lookup table of whichever thread
+// expands frames in the current mode
+static void ExpandFrame(Uint8 *dst, int pitch, const pixel_t *pixels, const unsigned char *palette,
+                        int palettegeneration)
+{
+  int i;
+
+  UpdatePaletteLUT(palette, palettegeneration);
+
+  for (i = 0; i < render_height; i++) {
+    ExpandRow((Uint32 *) (dst + i * pitch), pixels + i * render_width, render_width);
+  }
+}
+
+static void CopyToScreen(void)
+{
+  SDL_RenderClear(renderer);
+
+  if (texture_upscaled != NULL) {
+    // Two-pass rendering for crisp integer scaling
+    SDL_SetRenderTarget(renderer, texture_upscaled);
+    SDL_RenderCopy(renderer, texture, NULL, NULL);
+
+    // Second pass
+    SDL_SetRenderTarget(renderer, NULL);
+    SDL_RenderCopy(renderer, texture_upscaled, NULL, NULL);
+  } else {
+    SDL_SetRenderTarget(renderer, NULL);
+    SDL_RenderCopy(renderer, texture, NULL, NULL);
+  }
+
+  SDL_RenderPresent(renderer);
+}
+
+static qboolean PresentFrame(const pixel_t *pixels, const unsigned char *palette, int palettegeneration)
+{
+  void *dst;
+  int pitch;
+
+  if (SDL_LockTexture(texture, NULL, &dst, &pitch) != 0) {
+    return false;
+  }
+
+  ExpandFrame(dst, pitch, pixels, palette, palettegeneration);
+
+  SDL_UnlockTexture(texture);
+  CopyToScreen();
+
+  return true;
+}
+
+// Expands the newest queued frame. Only the worker's own slot is touched
+// outside the lock, and the render size never changes while frames are queued.
+static int PresentThread(void *data)
+{
+  presentframe_t *frame;
+
+  SDL_LockMutex(present_lock);
+
+  while (!present_quit) {
+    if (present_waiting < 0) {
+      SDL_CondWait(present_cond, present_lock);
+      continue;
+    }
+
+    present_working = present_waiting;
+    present_waiting = -1;
+    frame = &present_frames[present_working];
+    SDL_UnlockMutex(present_lock);
+
+    ExpandFrame((Uint8 *) frame->texels, render_width * sizeof(Uint32), frame->pixels, frame->palette,
+                frame->palettegeneration);
+
+    SDL_LockMutex(present_lock);
+    present_finished = present_working;
+    present_working = -1;
+    SDL_CondBroadcast(present_cond);
+  }
 
-  if (!SDL_PixelFormatEnumToMasks(SDL_PIXELFORMAT_ARGB8888, &bpp, &Rmask, &Gmask, &Bmask, &Amask)) {
+  SDL_UnlockMutex(present_lock);
+
+  return 0;
+}
+
+// Uploads and presents the newest frame the worker has finished, if there is
+// one. Called on the main thread with present_lock held.
+static void PresentFinished(void)
+{
+  presentframe_t *frame;
+  int slot;
+
+  if (present_finished < 0) {
+    return;
+  }
+
+  // the worker can't reuse a slot that is in none of the states
+  slot = present_finished;
+  present_finished = -1;
+  frame = &present_frames[slot];
+  SDL_UnlockMutex(present_lock);
+
+  if (SDL_UpdateTexture(texture, NULL, frame->texels, render_width * sizeof(Uint32)) == 0) {
+    CopyToScreen();
+  } else {
+    Com_Printf("Failed to update texture: %s\n", SDL_GetError());
+  }
+
+  SDL_LockMutex(present_lock);
+}
+
+static void AllocPresentFrames(void)
+{
+  int i;
+
+  for (i = 0; i < PRESENT_SLOTS; i++) {
+    present_frames[i].pixels = malloc(render_width * render_height * sizeof(pixel_t));
+    present_frames[i].texels = malloc(render_width * render_height * sizeof(Uint32));
+    present_frames[i].palettegeneration = -1;
+  }
+}
+
+static void FreePresentFrames(void)
+{
+  int i;
+
+  for (i = 0; i < PRESENT_SLOTS; i++) {
+    free(present_frames[i].pixels);
+    present_frames[i].pixels = NULL;
+    free(present_frames[i].texels);
+    present_frames[i].texels = NULL;
+  }
+}
+
+// Queued frames are dropped, the caller flushes first if it wants them shown
+static void StopPresentThread(void)
+{
+  SDL_LockMutex(present_lock);
+  present_quit = true;
+  SDL_CondBroadcast(present_cond);
+  SDL_UnlockMutex(present_lock);
+
+  SDL_WaitThread(present_thread, NULL);
+  present_thread = NULL;
+
+  FreePresentFrames();
+
+  SDL_DestroyCond(present_cond);
+  present_cond = NULL;
+  SDL_DestroyMutex(present_lock);
+  present_lock = NULL;
+}
+
+static qboolean StartPresentThread(void)
+{
+  present_lock = SDL_CreateMutex();
+  present_cond = SDL_CreateCond();
+
+  AllocPresentFrames();
+
+  present_waiting = -1;
+  present_working = -1;
+  present_finished = -1;
+  present_quit = false;
+
+  present_thread = SDL_CreateThread(PresentThread, "present", NULL);
+
+  if (present_thread == NULL) {
+    Com_Printf("Failed to create present thread: %s\n", SDL_GetError());
+    StopPresentThread();
     return false;
   }
 
+  return true;
+}
+
+// Waits for the worker and presents the last frame it was given
+static void FlushPresentQueue(void)
+{
+  if (present_thread == NULL) {
+    return;
+  }
+
+  SDL_LockMutex(present_lock);
+  while (present_waiting >= 0 || present_working >= 0) {
+    SDL_CondWait(present_cond, present_lock);
+  }
+  PresentFinished();
+  SDL_UnlockMutex(present_lock);
+}
+
+// Changes the render resolution, keeping the window and renderer
+void gfx_resize_render(int rend_width, int rend_height)
+{
+  FlushPresentQueue();
+
+  render_width = rend_width;
+  render_height = rend_height;
+
+  if (present_thread != NULL) {
+    FreePresentFrames();
+    AllocPresentFrames();
+  }
+
+  CreateTextures(false);
+}
+
+qboolean gfx_create_window(qboolean fullscreen, qboolean vsync, int win_width, int win_height, int rend_width,
+                           int rend_height, int queue)
+{
+  Uint32 flags = SDL_SWSURFACE;
+  int windowPos = SDL_WINDOWPOS_CENTERED;
+
   // Store dimensions
   window_width = win_width;
   window_height = win_height;
@@ -128,32 +465,13 @@ qboolean gfx_create_window(qboolean fullscreen, qboolean vsync, int win_width, i
     return false;
   }
 
-  if (vsync) {
-    renderer = SDL_CreateRenderer(window, -1,
-                                  SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_TARGETTEXTURE);
-  } else {
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
-  }
-
-  if (renderer == NULL) {
-    Com_Printf("Failed to create renderer: %s\n", SDL_GetError());
+  if (!CreateRenderer(vsync)) {
     return false;
   }
 
-  // Clear to black until it loads
-  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-  SDL_RenderClear(renderer);
-  SDL_RenderPresent(renderer);
-
-  // Surface and texture render resolution (not window)
-  SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0");
-  surface = SDL_CreateRGBSurface(0, render_width, render_height, bpp, Rmask, Gmask, Bmask, Amask);
-  surface_indexed = SDL_CreateRGBSurface(0, render_width, render_height, 8, 0, 0, 0, 0);
-  texture =
-      SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, render_width, render_height);
-
-  // Create the upscaled texture for integer scaling
-  CreateUpscaledTexture();
+  if (queue > 0 && !StartPresentThread()) {
+    Com_Printf("Expanding frames on the main thread instead.\n");
+  }
 
   SDL_ShowCursor(0);
 
@@ -204,9 +522,10 @@ qboolean gfx_update_fullscreen(qboolean fullscreen)
   }
 
   if (fullscreen != gfx_is_fullscreen()) {
+    FlushPresentQueue();
     SDL_SetWindowFullscreen(window, flags);
     Cvar_SetValue("vid_fullscreen", fullscreen);
-    CreateUpscaledTexture();
+    CreateTextures(false);
 
     return true;
   }
@@ -214,48 +533,59 @@ qboolean gfx_update_fullscreen(qboolean fullscreen)
   return false;
 }
 
-void gfx_update(swstate_t sw_state, viddef_t vid)
+void gfx_update(const swstate_t *sw_state, viddef_t vid)
 {
-  int i;
-  const unsigned char *palette = sw_state.currentpalette;
-  SDL_Color colors[256];
+  presentframe_t *frame;
+  int slot;
 
-  // Set up palette for indexed surface
-  for (i = 0; i < 256; i++) {
-    colors[i].r = palette[i * 4 + 0];
-    colors[i].g = palette[i * 4 + 1];
-    colors[i].b = palette[i * 4 + 2];
-    colors[i].a = 255;
-  }
-  SDL_SetPaletteColors(surface_indexed->format->palette, colors, 0, 256);
+  if (present_thread == NULL) {
+    if (!PresentFrame(vid_buffer, sw_state->currentpalette, sw_state->palettegeneration)) {
+      Com_Printf("Failed to lock texture: %s\n", SDL_GetError());
+    }
 
-  for (i = 0; i < vid.height; i++) {
-    memcpy((Uint8 *) surface_indexed->pixels + i * surface_indexed->pitch, vid_buffer + i * vid.width, vid.width);
+    return;
   }
 
-  SDL_BlitSurface(surface_indexed, NULL, surface, NULL);
-  SDL_UpdateTexture(texture, NULL, surface->pixels, surface->pitch);
-  SDL_RenderClear(renderer);
+  // Show the newest frame the worker has finished, then hand over a copy of
+  // this one and its palette. With every slot taken the waiting frame is
+  // stale and gets overwritten.
+  SDL_LockMutex(present_lock);
+  PresentFinished();
+  for (slot = 0; slot < PRESENT_SLOTS; slot++) {
+    if (slot != present_waiting && slot != present_working && slot != present_finished) {
+      break;
+    }
+  }
+  if (slot == PRESENT_SLOTS) {
+    slot = present_waiting;
+  }
+  present_waiting = -1;
+  frame = &present_frames[slot];
+  SDL_UnlockMutex(present_lock);
 
-  if (texture_upscaled != NULL) {
-    // Two-pass rendering for crisp integer scaling
-    SDL_SetRenderTarget(renderer, texture_upscaled);
-    SDL_RenderCopy(renderer, texture, NULL, NULL);
+  memcpy(frame->pixels, vid_buffer, render_width * render_height * sizeof(pixel_t));
 
-    // Second pass
-    SDL_SetRenderTarget(renderer, NULL);
-    SDL_RenderCopy(renderer, texture_upscaled, NULL, NULL);
-  } else {
-    SDL_SetRenderTarget(renderer, NULL);
-    SDL_RenderCopy(renderer, texture, NULL, NULL);
+  if (frame->palettegeneration != sw_state->palettegeneration) {
+    memcpy(frame->palette, sw_state->currentpalette, sizeof(frame->palette));
+    frame->palettegeneration = sw_state->palettegeneration;
   }
 
-  SDL_RenderPresent(renderer);
+  SDL_LockMutex(present_lock);
+  present_waiting = slot;
+  SDL_CondBroadcast(present_cond);
+  SDL_UnlockMutex(present_lock);
 }
 
+// Milliseconds with sub-millisecond resolution, for the renderer's timers
 float gfx_get_ticks()
 {
-  return SDL_GetTicks();
+  static Uint64 start;
+
+  if (start == 0) {
+    start = SDL_GetPerformanceCounter();
+  }
+
+  return (double) (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
 }
 
 const char *gfx_get_error()
@@ -265,35 +595,11 @@ const char *gfx_get_error()
 
 void gfx_free()
 {
-  if (texture_upscaled) {
-    SDL_DestroyTexture(texture_upscaled);
+  if (present_thread) {
+    StopPresentThread();
   }
 
-  texture_upscaled = NULL;
-
-  if (texture) {
-    SDL_DestroyTexture(texture);
-  }
-
-  texture = NULL;
-
-  if (surface) {
-    SDL_FreeSurface(surface);
-  }
-
-  surface = NULL;
-
-  if (surface_indexed) {
-    SDL_FreeSurface(surface_indexed);
-  }
-
-  surface_indexed = NULL;
-
-  if (renderer) {
-    SDL_DestroyRenderer(renderer);
-  }
-
-  renderer = NULL;
+  DestroyRenderer();
 
   if (window) {
     SDL_DestroyWindow(window);
@@ -43,6 +43,18 @@
 #define NUM_FOR_EDICT(e) (((byte *) (e) - (byte *) globals.edicts) / globals.edict_size)
 #define SV_OUTPUTBUF_LENGTH (MAX_MSGLEN - 16)
 
+/* configstring ranges handed out by SV_FindIndex */
+#define INDEX_MODELS 0
+#define INDEX_SOUNDS 1
+#define INDEX_IMAGES 2
+#define NUM_INDEXRANGES 3
+
+#define INDEX_HASHSIZE 256 /* power of two */
+
+/* versions kept of each entity_state_t, enough
+   for the oldest frame a client may delta from */
+#define ENTITY_HISTORY UPDATE_BACKUP
+
 typedef enum
 {
   ss_dead,    /* no map loaded */
@@ -67,10 +79,27 @@ typedef struct
   char configstrings[MAX_CONFIGSTRINGS][MAX_QPATH];
   entity_state_t baselines[MAX_EDICTS];
 
+  /* names in the SV_FindIndex ranges, chained by hash, and the
+     slots below which none of those ranges has a hole */
+  short indexhash[INDEX_HASHSIZE]; /* configstring, 0 ends a chain */
+  short indexnext[MAX_CONFIGSTRINGS];
+  short indexfree[NUM_INDEXRANGES];
+
+  int entityframe; /* sv.framenum + 1 the entity versions are current for */
+
   /* the multicast buffer is used to send a message to a set of clients
      it is only used to marshall data until SV_Multicast is called */
   sizebuf_t multicast;
   byte multicast_buf[MAX_MSGLEN];
+
+  /* configstrings and baselines for NETF_GAMESTATE clients, compressed
+     at spawn. a configstring change marks it stale, and it is built
+     again once no client is in the middle of fetching it */
+  qboolean gamestatedirty;
+  byte gamestatestale[MAX_CONFIGSTRINGS]; /* changed since the build */
+  int gamestateversion;
+  int gamestatelen; /* 0 if it could not be built */
+  byte gamestate[MAX_GAMESTATE];
 } server_t;
 
 typedef enum
@@ -90,8 +119,17 @@ typedef struct
   int num_entities;
   int first_entity; /* into the circular sv_packet_entities[] */
   int senttime;     /* for ping calculations */
+  qboolean refs;    /* entities are in client_entityrefs */
 } client_frame_t;
 
+/* an entity in a client frame, as a version of its state */
+typedef struct
+{
+  int number;
+  int version;
+  qboolean owned; /* solid is cleared, it belongs to the client */
+} entityref_t;
+
 typedef struct client_s
 {
   client_state_t state;
@@ -127,6 +165,10 @@ typedef struct client_s
 
   int challenge; /* challenge of this user, randomly generated */
 
+  int netflags;          /* NETF_* the client offered when connecting */
+  qboolean gamestate;    /* svc_gamestate is being streamed */
+  int gamestatefragment; /* next fragment to send */
+
   netchan_t netchan;
 } client_t;
 
@@ -152,6 +194,12 @@ typedef struct
                                     */
   int next_client_entities;        /* next client_entity to use */
   entity_state_t *client_entities; /* [num_client_entities] */
+  entityref_t *client_entityrefs;  /* [num_client_entities], instead with sv_entityrefs */
+
+  /* every entity_state_t, bumped to a new version whenever
+     it differs from the last one at the end of a frame */
+  int entity_version[MAX_EDICTS];
+  entity_state_t *entity_history; /* [MAX_EDICTS * ENTITY_HISTORY] */
 
   int last_heartbeat;
 
@@ -176,6 +224,8 @@ extern cvar_t *sv_noreload;      /* don't reload level state when reentering */
 extern cvar_t *sv_airaccelerate; /* don't reload level state when reentering */
 /* development tool */
 extern cvar_t *sv_enforcetime;
+extern cvar_t *sv_areatree;
+extern cvar_t *sv_entityrefs;
 
 extern client_t *sv_client;
 extern edict_t *sv_player;
@@ -184,6 +234,8 @@ void SV_FinalMessage(char *message, qboolean reconnect);
 
 void SV_DropClient(client_t *drop);
 
+void SV_SetConfigstring(int index, char *val);
+
 int SV_ModelIndex(char *name);
 
 int SV_SoundIndex(char *name);
@@ -202,6 +254,8 @@ void SV_InitGame(void);
 
 void SV_Map(qboolean attractloop, char *levelstring, qboolean loadgame);
 
+void SV_BuildGamestate(void);
+
 void SV_PrepWorldFrame(void);
 
 typedef enum
@@ -258,8 +312,14 @@ void SV_LinkEdict(edict_t *ent);
    the entity is not solid */
 int SV_AreaEdicts(vec3_t mins, vec3_t maxs, edict_t **list, int maxcount, int areatype);
 
+int SV_RadiusEdicts(vec3_t org, float radius, edict_t **list, int maxcount, int areatype);
+
 int SV_PointContents(vec3_t p);
 
+void SV_AreaStats_f(void);
+
+void SV_AreaBench_f(void);
+
 trace_t SV_Trace(vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t *passedict, int contentmask);
 
 void PF_dprintf(char *fmt, ...);
@@ -225,8 +225,8 @@ void SV_Status_f(void)
 
   Com_Printf("map              : %s\n", sv.name);
 
-  Com_Printf("num score ping name            lastmsg address               qport \n");
-  Com_Printf("--- ----- ---- --------------- ------- --------------------- ------\n");
+  Com_Printf("num score ping name            lastmsg address               qport coded  usec\n");
+  Com_Printf("--- ----- ---- --------------- ------- --------------------- ----- ----- -----\n");
 
   for (i = 0, cl = svs.clients; i < maxclients->value; i++, cl++) {
     if (!cl->state) {
@@ -264,12 +264,64 @@ void SV_Status_f(void)
 
     Com_Printf("%5i", cl->netchan.qport);
 
+    /* coded share of the payload and coding time per packet */
+    if (cl->netchan.compressed && cl->netchan.coded_in) {
+      Com_Printf(" %4i%% %5.1f", (int) (100.0f * cl->netchan.coded_out / cl->netchan.coded_in),
+                 (float) cl->netchan.coded_usec / cl->netchan.coded_packets);
+    } else {
+      Com_Printf("     -     -");
+    }
+
     Com_Printf("\n");
   }
 
   Com_Printf("\n");
 }
 
+/*
+ * Reliable fragment counters of every client using the fragmented
+ * netchan. Loss is the share of fragments that had to be sent again.
+ */
+void SV_NetStats_f(void)
+{
+  int i, j, l;
+  client_t *cl;
+  netchan_t *chan;
+
+  if (!svs.clients) {
+    Com_Printf("No server running.\n");
+    return;
+  }
+
+  Com_Printf("num name             sent resent  loss  rcvd  dups fly\n");
+  Com_Printf("--- --------------- ----- ------ ----- ----- ----- ---\n");
+
+  for (i = 0, cl = svs.clients; i < maxclients->value; i++, cl++) {
+    if (!cl->state) {
+      continue;
+    }
+
+    chan = &cl->netchan;
+    Com_Printf("%3i %s", i, cl->name);
+    l = 16 - strlen(cl->name);
+
+    for (j = 0; j < l; j++) {
+      Com_Printf(" ");
+    }
+
+    if (!chan->fragmented) {
+      Com_Printf("unfragmented\n");
+      continue;
+    }
+
+    Com_Printf("%5i %6i %4.1f%% %5i %5i %3i\n", chan->fragments_sent, chan->fragments_resent,
+               chan->fragments_sent ? 100.0f * chan->fragments_resent / chan->fragments_sent : 0.0f,
+               chan->fragments_received, chan->fragments_duplicate, chan->fragment_next - chan->fragment_base);
+  }
+
+  Com_Printf("\n");
+}
+
 void SV_ConSay_f(void)
 {
   client_t *client;
@@ -369,8 +421,11 @@ void SV_InitOperatorCommands(void)
   Cmd_AddCommand("heartbeat", SV_Heartbeat_f);
   Cmd_AddCommand("kick", SV_Kick_f);
   Cmd_AddCommand("status", SV_Status_f);
+  Cmd_AddCommand("netstats", SV_NetStats_f);
   Cmd_AddCommand("serverinfo", SV_Serverinfo_f);
   Cmd_AddCommand("dumpuser", SV_DumpUser_f);
+  Cmd_AddCommand("areastats", SV_AreaStats_f);
+  Cmd_AddCommand("areabench", SV_AreaBench_f);
 
   Cmd_AddCommand("map", SV_Map_f);
   Cmd_AddCommand("gamemap", SV_GameMap_f);
@@ -141,6 +141,7 @@ void SVC_DirectConnect(void)
   int version;
   int qport;
   int challenge;
+  int netflags;
 
   adr = net_from;
 
@@ -160,6 +161,17 @@ void SVC_DirectConnect(void)
 
   Q_strlcpy(userinfo, Cmd_Argv(4), sizeof(userinfo));
 
+  /* older clients don't send it */
+  netflags = (int) strtol(Cmd_Argv(5), (char **) NULL, 10);
+
+  if (!Cvar_VariableValue("net_fragment")) {
+    netflags &= ~NETF_FRAGMENT;
+  }
+
+  if (!Cvar_VariableValue("net_compress")) {
+    netflags &= ~NETF_COMPRESS;
+  }
+
   /* force the IP key/value pair so the game can filter based on ip */
   Info_SetValueForKey(userinfo, "ip", NET_AdrToString(net_from));
 
@@ -239,6 +251,7 @@ gotnewcl:
   ent = EDICT_NUM(edictnum);
   newcl->edict = ent;
   newcl->challenge = challenge; /* save challenge for checksumming */
+  newcl->netflags = netflags;
 
   /* get the game a chance to reject this connection or modify the userinfo */
   if (!(ClientConnect(ent, userinfo))) {
@@ -256,11 +269,20 @@ gotnewcl:
   Q_strlcpy(newcl->userinfo, userinfo, sizeof(newcl->userinfo));
   SV_UserinfoChanged(newcl);
 
-  /* send the connect packet to the client */
-  Netchan_OutOfBandPrint(NS_SERVER, adr, "client_connect");
+  /* send the connect packet to the client, with the
+     capabilities it offered that are going to be used */
+  Netchan_OutOfBandPrint(NS_SERVER, adr, "client_connect %i", netflags);
 
   Netchan_Setup(NS_SERVER, &newcl->netchan, adr, qport);
 
+  if (netflags & NETF_FRAGMENT) {
+    Netchan_Fragment(&newcl->netchan);
+  }
+
+  if (netflags & NETF_COMPRESS) {
+    Netchan_Compress(&newcl->netchan);
+  }
+
   newcl->state = cs_connected;
 
   SZ_Init(&newcl->datagram, newcl->datagram_buf, sizeof(newcl->datagram_buf));
@@ -30,16 +30,105 @@
 
 byte fatpvs[65536 / 8];
 
+#define SV_EntityVersion(e, version) (&svs.entity_history[(e) * ENTITY_HISTORY + ((version) & (ENTITY_HISTORY - 1))])
+
+/*
+ * Makes a new version of every entity state that changed since the
+ * last one, once per frame. Client frames then refer to versions
+ * instead of copying the states, and an entity whose version did not
+ * change between two frames is known to be the same without comparing.
+ */
+static void SV_UpdateEntityVersions(void)
+{
+  entity_state_t *last;
+  edict_t *ent;
+  int e;
+
+  if (sv.entityframe == sv.framenum + 1) {
+    return;
+  }
+
+  sv.entityframe = sv.framenum + 1;
+
+  for (e = 1; e < globals.num_edicts; e++) {
+    ent = EDICT_NUM(e);
+
+    /* never sent, it gets a new version once it is */
+    if (!ent->s.modelindex && !ent->s.effects && !ent->s.sound && !ent->s.event) {
+      continue;
+    }
+
+    if (ent->s.number != e) {
+      Com_DPrintf("FIXING ENT->S.NUMBER!!!\n");
+      ent->s.number = e;
+    }
+
+    last = SV_EntityVersion(e, svs.entity_version[e]);
+
+    if (!memcmp(last, &ent->s, sizeof(*last))) {
+      continue;
+    }
+
+    svs.entity_version[e]++;
+    *SV_EntityVersion(e, svs.entity_version[e]) = ent->s;
+  }
+}
+
+/*
+ * Returns the state of an entity in a client frame
+ */
+static entity_state_t *SV_FrameEntity(client_frame_t *frame, int index, entity_state_t *owned)
+{
+  entityref_t *ref;
+
+  index = (frame->first_entity + index) % svs.num_client_entities;
+
+  if (!frame->refs) {
+    return &svs.client_entities[index];
+  }
+
+  ref = &svs.client_entityrefs[index];
+
+  if (!ref->owned) {
+    return SV_EntityVersion(ref->number, ref->version);
+  }
+
+  *owned = *SV_EntityVersion(ref->number, ref->version);
+  owned->solid = 0;
+
+  return owned;
+}
+
+/*
+ * True if an entity is the same version of the
+ * same state in two frames that both use refs
+ */
+static qboolean SV_SameVersion(client_frame_t *from, int oldindex, client_frame_t *to, int newindex)
+{
+  entityref_t *oldref, *newref;
+
+  if (!from->refs || !to->refs) {
+    return false;
+  }
+
+  oldref = &svs.client_entityrefs[(from->first_entity + oldindex) % svs.num_client_entities];
+  newref = &svs.client_entityrefs[(to->first_entity + newindex) % svs.num_client_entities];
+
+  return (oldref->version == newref->version) && (oldref->owned == newref->owned);
+}
+
 /*
  * Writes a delta update of an entity_state_t list to the message.
+ * A coded message is limited by its coded size instead of its length.
  */
-void SV_EmitPacketEntities(client_frame_t *from, client_frame_t *to, sizebuf_t *msg)
+void SV_EmitPacketEntities(client_frame_t *from, client_frame_t *to, sizebuf_t *msg, qboolean coded)
 {
   entity_state_t *oldent, *newent;
+  entity_state_t oldowned, newowned;
   int oldindex, newindex;
   int oldnum, newnum;
   int from_num_entities;
-  int bits;
+  int bits, codedbits, costed;
 
   MSG_WriteByte(msg, svc_packetentities);
 
@@ -53,27 +142,45 @@ void SV_EmitPacketEntities(client_frame_t *from, client_frame_t *to, sizebuf_t *
   oldindex = 0;
   newent = NULL;
   oldent = NULL;
+  codedbits = 0;
+  costed = 0;
 
   while (newindex < to->num_entities || oldindex < from_num_entities) {
-    if (msg->cursize > MAX_MSGLEN - 150) {
+    if (coded) {
+      codedbits += Huff_Cost(msg->data + costed, msg->cursize - costed);
+      costed = msg->cursize;
+
+      if ((codedbits / 8 > MAX_MSGLEN - 150) || (msg->cursize > msg->maxsize - 150)) {
+        break;
+      }
+    } else if (msg->cursize > MAX_MSGLEN - 150) {
       break;
     }
 
     if (newindex >= to->num_entities) {
       newnum = 9999;
     } else {
-      newent = &svs.client_entities[(to->first_entity + newindex) % svs.num_client_entities];
+      newent = SV_FrameEntity(to, newindex, &newowned);
       newnum = newent->number;
     }
 
     if (oldindex >= from_num_entities) {
       oldnum = 9999;
     } else {
-      oldent = &svs.client_entities[(from->first_entity + oldindex) % svs.num_client_entities];
+      oldent = SV_FrameEntity(from, oldindex, &oldowned);
       oldnum = oldent->number;
     }
 
     if (newnum == oldnum) {
+      /* an unchanged version writes nothing, unless it is a
+         player, a beam or has an event, which always go out */
+      if (SV_SameVersion(from, oldindex, to, newindex) && (newnum > maxclients->value) &&
+          !(newent->renderfx & RF_BEAM) && !newent->event) {
+        oldindex++;
+        newindex++;
+        continue;
+      }
+
       /* delta update from old position. because the force
          parm is false, this will not result in any bytes
          being emited if the entity has not changed at all
@@ -347,7 +454,7 @@ void SV_WriteFrameToClient(client_t *client, sizebuf_t *msg)
   SV_WritePlayerstateToClient(oldframe, frame, msg);
 
   /* delta encode the entities */
-  SV_EmitPacketEntities(oldframe, frame, msg);
+  SV_EmitPacketEntities(oldframe, frame, msg, client->netchan.compressed);
 }
 
 /*
@@ -414,6 +521,7 @@ void SV_BuildClientFrame(client_t *client)
   edict_t *clent;
   client_frame_t *frame;
   entity_state_t *state;
+  entityref_t *ref;
   int l;
   int clientarea, clientcluster;
   int leafnum;
@@ -453,6 +561,11 @@ void SV_BuildClientFrame(client_t *client)
   /* build up the list of visible entities */
   frame->num_entities = 0;
   frame->first_entity = svs.next_client_entities;
+  frame->refs = sv_entityrefs->value != 0;
+
+  if (frame->refs) {
+    SV_UpdateEntityVersions();
+  }
 
   c_fullsend = 0;
 
@@ -528,6 +641,17 @@ void SV_BuildClientFrame(client_t *client)
       }
     }
 
+    if (frame->refs) {
+      ref = &svs.client_entityrefs[svs.next_client_entities % svs.num_client_entities];
+      ref->number = e;
+      ref->version = svs.entity_version[e];
+      ref->owned = (ent->owner == client->edict);
+
+      svs.next_client_entities++;
+      frame->num_entities++;
+      continue;
+    }
+
     /* add it to the circular client_entities array */
     state = &svs.client_entities[svs.next_client_entities % svs.num_client_entities];
 
@@ -182,7 +182,7 @@ void PF_Configstring(int index, char *val)
   }
 
   /* change the string in sv */
-  strcpy(sv.configstrings[index], val);
+  SV_SetConfigstring(index, val);
 
   if (sv.state != ss_loading) {
     /* send the update to everyone */
@@ -192,6 +192,11 @@ void PF_Configstring(int index, char *val)
     MSG_WriteString(&sv.multicast, val);
 
     SV_Multicast(vec3_origin, MULTICAST_ALL_R);
+
+    /* clients fetching the gamestate get the old string
+       in it, and this one again when they are done */
+    sv.gamestatestale[index] = true;
+    sv.gamestatedirty = true;
   }
 }
 
@@ -29,18 +29,159 @@
 server_static_t svs; /* persistant server info */
 server_t sv;         /* local server */
 
-int SV_FindIndex(char *name, int start, int max, qboolean create)
+static const struct
 {
-  int i;
+  int start;
+  int max;
+} sv_indexranges[NUM_INDEXRANGES] = {{CS_MODELS, MAX_MODELS}, {CS_SOUNDS, MAX_SOUNDS}, {CS_IMAGES, MAX_IMAGES}};
+
+static int SV_IndexHash(const char *name)
+{
+  unsigned hash;
+
+  for (hash = 0; *name; name++) {
+    hash = hash * 31 + (byte) *name;
+  }
+
+  return hash & (INDEX_HASHSIZE - 1);
+}
+
+/*
+ * Returns the SV_FindIndex range a configstring is in, or -1
+ */
+static int SV_IndexRange(int index)
+{
+  int r;
+
+  for (r = 0; r < NUM_INDEXRANGES; r++) {
+    if ((index > sv_indexranges[r].start) && (index < sv_indexranges[r].start + sv_indexranges[r].max)) {
+      return r;
+    }
+  }
+
+  return -1;
+}
+
+static void SV_UnhashIndex(int index)
+{
+  short *link;
+
+  if ((SV_IndexRange(index) < 0) || !sv.configstrings[index][0]) {
+    return;
+  }
+
+  for (link = &sv.indexhash[SV_IndexHash(sv.configstrings[index])]; *link; link = &sv.indexnext[*link]) {
+    if (*link == index) {
+      *link = sv.indexnext[index];
+      return;
+    }
+  }
+}
+
+static void SV_HashIndex(int index)
+{
+  int r, h;
+
+  r = SV_IndexRange(index);
+
+  if (r < 0) {
+    return;
+  }
+
+  if (!sv.configstrings[index][0]) {
+    /* a hole, lookups in this range stop here */
+    if (index - sv_indexranges[r].start < sv.indexfree[r]) {
+      sv.indexfree[r] = index - sv_indexranges[r].start;
+    }
+
+    return;
+  }
+
+  h = SV_IndexHash(sv.configstrings[index]);
+  sv.indexnext[index] = sv.indexhash[h];
+  sv.indexhash[h] = index;
+}
+
+/*
+ * Returns the first empty slot of a range below limit, or limit.
+ * Every slot below sv.indexfree is known to be in use.
+ */
+static int SV_IndexFree(int range, int limit)
+{
+  int start, i;
+
+  start = sv_indexranges[range].start;
+
+  i = sv.indexfree[range] ? sv.indexfree[range] : 1;
+
+  if (i >= limit) {
+    return limit;
+  }
+
+  for (; i < limit && sv.configstrings[start + i][0]; i++) {
+  }
+
+  sv.indexfree[range] = i;
+
+  return i;
+}
+
+/*
+ * Changes a configstring without telling the clients. Long
+ * strings run on into the following slots, like the statusbar.
+ */
+void SV_SetConfigstring(int index, char *val)
+{
+  int last, i;
+
+  last = index + (int) strlen(val) / MAX_QPATH;
+
+  if (last >= MAX_CONFIGSTRINGS) {
+    last = MAX_CONFIGSTRINGS - 1;
+  }
+
+  for (i = index; i <= last; i++) {
+    SV_UnhashIndex(i);
+  }
+
+  strcpy(sv.configstrings[index], val);
+
+  for (i = index; i <= last; i++) {
+    SV_HashIndex(i);
+  }
+}
+
+/*
+ * Returns the slot of name in a range, adding it at the first empty
+ * slot if needed. The hash finds it, but a name past an empty slot
+ * doesn't count, the same as if the range were searched in order.
+ */
+int SV_FindIndex(char *name, int range, qboolean create)
+{
+  int start, max, found, i;
 
   if (!name || !name[0]) {
     return 0;
   }
 
-  for (i = 1; i < max && sv.configstrings[start + i][0]; i++) {
-    if (!strcmp(sv.configstrings[start + i], name)) {
+  start = sv_indexranges[range].start;
+  max = sv_indexranges[range].max;
+  found = 0;
+
+  for (i = sv.indexhash[SV_IndexHash(name)]; i; i = sv.indexnext[i]) {
+    if ((i > start) && (i < start + max) && (!found || (i < found)) && !strcmp(sv.configstrings[i], name)) {
+      found = i;
+    }
+  }
+
+  if (found) {
+    i = SV_IndexFree(range, found - start);
+
+    if (i == found - start) {
       return i;
     }
+  } else {
+    i = SV_IndexFree(range, max);
   }
 
   if (!create) {
@@ -52,6 +193,7 @@ int SV_FindIndex(char *name, int start, int max, qboolean create)
   }
 
   Q_strlcpy(sv.configstrings[start + i], name, sizeof(sv.configstrings[start + i]));
+  SV_HashIndex(start + i);
 
   if (sv.state != ss_loading) {
     /* send the update to everyone */
@@ -66,17 +208,17 @@ int SV_FindIndex(char *name, int start, int max, qboolean create)
 
 int SV_ModelIndex(char *name)
 {
-  return SV_FindIndex(name, CS_MODELS, MAX_MODELS, true);
+  return SV_FindIndex(name, INDEX_MODELS, true);
 }
 
 int SV_SoundIndex(char *name)
 {
-  return SV_FindIndex(name, CS_SOUNDS, MAX_SOUNDS, true);
+  return SV_FindIndex(name, INDEX_SOUNDS, true);
 }
 
 int SV_ImageIndex(char *name)
 {
-  return SV_FindIndex(name, CS_IMAGES, MAX_IMAGES, true);
+  return SV_FindIndex(name, INDEX_IMAGES, true);
 }
 
 /*
@@ -108,6 +250,61 @@ void SV_CreateBaseline(void)
   }
 }
 
+/*
+ * Packs every configstring and baseline as the same messages the
+ * configstrings and baselines commands send, and compresses them into
+ * sv.gamestate so a NETF_GAMESTATE client can fetch the lot in one go
+ */
+void SV_BuildGamestate(void)
+{
+  static byte raw[MAX_GAMESTATE];
+  sizebuf_t msg;
+  entity_state_t nullstate;
+  entity_state_t *base;
+  int i;
+
+  sv.gamestatedirty = false;
+  memset(sv.gamestatestale, 0, sizeof(sv.gamestatestale));
+  sv.gamestateversion++;
+  sv.gamestatelen = 0;
+
+  SZ_Init(&msg, raw, sizeof(raw));
+  msg.allowoverflow = true;
+
+  for (i = 0; i < MAX_CONFIGSTRINGS; i++) {
+    if (sv.configstrings[i][0]) {
+      MSG_WriteByte(&msg, svc_configstring);
+      MSG_WriteShort(&msg, i);
+      MSG_WriteString(&msg, sv.configstrings[i]);
+    }
+  }
+
+  memset(&nullstate, 0, sizeof(nullstate));
+
+  for (i = 0; i < MAX_EDICTS; i++) {
+    base = &sv.baselines[i];
+
+    if (base->modelindex || base->sound || base->effects) {
+      MSG_WriteByte(&msg, svc_spawnbaseline);
+      MSG_WriteDeltaEntity(&nullstate, base, &msg, true, true);
+    }
+  }
+
+  if (msg.overflowed) {
+    Com_Printf("SV_BuildGamestate: overflow\n");
+    return;
+  }
+
+  sv.gamestatelen = LZSS_Compress(raw, msg.cursize, sv.gamestate, sizeof(sv.gamestate));
+
+  if (sv.gamestatelen < 0) {
+    sv.gamestatelen = 0;
+    return;
+  }
+
+  Com_DPrintf("Gamestate: %i bytes, %i compressed\n", msg.cursize, sv.gamestatelen);
+}
+
 /*
  * Change the server to a new map, taking all connected
  * clients along with it.
@@ -116,6 +313,7 @@ void SV_SpawnServer(char *server, char *spawnpoint, server_state_t serverstate,
 {
   int i;
   unsigned checksum;
+  char name[MAX_QPATH];
 
   if (attractloop) {
     Cvar_Set("paused", "0");
@@ -123,6 +321,7 @@ void SV_SpawnServer(char *server, char *spawnpoint, server_state_t serverstate,
 
   Com_Printf("Server init\n");
   Com_DPrintf("SpawnServer: %s\n", server);
+  FS_TraceMap(server);
 
   svs.spawncount++; /* any partially connected client will be restarted */
   sv.state = ss_dead;
@@ -157,6 +356,7 @@ void SV_SpawnServer(char *server, char *spawnpoint, server_state_t serverstate,
     }
 
     svs.clients[i].lastframe = -1;
+    svs.clients[i].gamestate = false;
   }
 
   sv.time = 1000;
@@ -167,7 +367,8 @@ void SV_SpawnServer(char *server, char *spawnpoint, server_state_t serverstate,
   if (serverstate != ss_game) {
     sv.models[1] = CM_LoadMap("", false, &checksum); /* no real map */
   } else {
-    Com_sprintf(sv.configstrings[CS_MODELS + 1], sizeof(sv.configstrings[CS_MODELS + 1]), "maps/%s.bsp", server);
+    Com_sprintf(name, sizeof(name), "maps/%s.bsp", server);
+    SV_SetConfigstring(CS_MODELS + 1, name);
     sv.models[1] = CM_LoadMap(sv.configstrings[CS_MODELS + 1], false, &checksum);
   }
 
@@ -177,7 +378,8 @@ void SV_SpawnServer(char *server, char *spawnpoint, server_state_t serverstate,
   SV_ClearWorld();
 
   for (i = 1; i < CM_NumInlineModels(); i++) {
-    Com_sprintf(sv.configstrings[CS_MODELS + 1 + i], sizeof(sv.configstrings[CS_MODELS + 1 + i]), "*%i", i);
+    Com_sprintf(name, sizeof(name), "*%i", i);
+    SV_SetConfigstring(CS_MODELS + 1 + i, name);
     sv.models[i + 1] = CM_InlineModel(sv.configstrings[CS_MODELS + 1 + i]);
   }
 
@@ -204,6 +406,10 @@ void SV_SpawnServer(char *server, char *spawnpoint, server_state_t serverstate,
   /* create a baseline for more efficient communications */
   SV_CreateBaseline();
 
+  if (serverstate == ss_game) {
+    SV_BuildGamestate();
+  }
+
   /* set serverinfo variable */
   Cvar_FullSet("mapname", sv.name, CVAR_SERVERINFO | CVAR_NOSET);
 }
@@ -268,6 +474,8 @@ void SV_InitGame(void)
   svs.clients = Z_Malloc(sizeof(client_t) * maxclients->value);
   svs.num_client_entities = maxclients->value * UPDATE_BACKUP * 64;
   svs.client_entities = Z_Malloc(sizeof(entity_state_t) * svs.num_client_entities);
+  svs.client_entityrefs = Z_Malloc(sizeof(entityref_t) * svs.num_client_entities);
+  svs.entity_history = Z_Malloc(sizeof(entity_state_t) * MAX_EDICTS * ENTITY_HISTORY);
 
   /* init network stuff */
   NET_Config((maxclients->value > 1));
@@ -41,6 +41,8 @@ cvar_t *sv_airaccelerate;
 cvar_t *sv_noreload; /* don't reload level state when reentering */
 cvar_t *maxclients;  /* rename sv_maxclients */
 cvar_t *sv_showclamp;
+cvar_t *sv_areatree; /* keep edicts in the dynamic tree, read at map load */
+cvar_t *sv_entityrefs; /* client frames refer to entity versions */
 cvar_t *hostname;
 cvar_t *public_server; /* should heartbeats be sent */
 
@@ -506,6 +508,8 @@ void SV_Init(void)
   sv_enforcetime = Cvar_Get("sv_enforcetime", "0", 0);
   sv_noreload = Cvar_Get("sv_noreload", "0", 0);
   sv_airaccelerate = Cvar_Get("sv_airaccelerate", "0", CVAR_LATCH);
+  sv_areatree = Cvar_Get("sv_areatree", "0", 0);
+  sv_entityrefs = Cvar_Get("sv_entityrefs", "1", 0);
   public_server = Cvar_Get("public", "0", 0);
 
   SZ_Init(&net_message, net_message_buffer, sizeof(net_message_buffer));
@@ -573,5 +577,13 @@ void SV_Shutdown(char *finalmsg, qboolean reconnect)
     Z_Free(svs.client_entities);
   }
 
+  if (svs.client_entityrefs) {
+    Z_Free(svs.client_entityrefs);
+  }
+
+  if (svs.entity_history) {
+    Z_Free(svs.entity_history);
+  }
+
   memset(&svs, 0, sizeof(svs));
 }
@@ -26,6 +26,8 @@
 
 #include "header/server.h"
 
+#define GAMESTATE_BURST 3 /* fragments per frame, the loopback queues only four packets */
+
 char sv_outputbuf[SV_OUTPUTBUF_LENGTH];
 
 void SV_FlushRedirect(int sv_redirected, char *outputbuf)
@@ -349,12 +351,13 @@ void SV_StartSound(vec3_t origin, edict_t *entity, int channel, int soundindex,
 
 qboolean SV_SendClientDatagram(client_t *client)
 {
-  byte msg_buf[MAX_MSGLEN];
+  byte msg_buf[NETCHAN_MAXPAYLOAD];
   sizebuf_t msg;
 
   SV_BuildClientFrame(client);
 
-  SZ_Init(&msg, msg_buf, sizeof(msg_buf));
+  /* a coded packet can carry more than MAX_MSGLEN bytes of frame */
+  SZ_Init(&msg, msg_buf, client->netchan.compressed ? NETCHAN_MAXPAYLOAD : MAX_MSGLEN);
   msg.allowoverflow = true;
 
   /* send over all the relevant entity_state_t
@@ -383,7 +386,11 @@ qboolean SV_SendClientDatagram(client_t *client)
   Netchan_Transmit(&client->netchan, msg.cursize, msg.data);
 
   /* record the size for rate estimation */
-  client->message_size[sv.framenum % RATE_MESSAGES] = msg.cursize;
+  if (client->netchan.compressed) {
+    client->message_size[sv.framenum % RATE_MESSAGES] = client->netchan.coded_length;
+  } else {
+    client->message_size[sv.framenum % RATE_MESSAGES] = msg.cursize;
+  }
 
   return true;
 }
@@ -417,6 +424,74 @@ qboolean SV_RateDrop(client_t *c)
   return false;
 }
 
+/*
+ * Streams svc_gamestate fragments to a connecting client, as many as
+ * its rate window has room for each frame, and cycles through them
+ * until it reports the whole blob. A lost fragment simply comes around
+ * again. The blob is not rebuilt while this goes on, so configstring
+ * changes can't restart the client's reassembly.
+ */
+void SV_SendGamestate(client_t *c)
+{
+  byte msgbuf[MAX_MSGLEN];
+  sizebuf_t msg;
+  int fragments, budget, sent, offset, len, i;
+
+  /* don't overrun bandwidth */
+  if (SV_RateDrop(c)) {
+    return;
+  }
+
+  fragments = (sv.gamestatelen + GAMESTATE_FRAGMENT - 1) / GAMESTATE_FRAGMENT;
+
+  if (c->netchan.remote_address.type == NA_LOOPBACK) {
+    budget = sv.gamestatelen;
+  } else {
+    /* whatever is left of the rate window after the earlier frames */
+    budget = c->rate;
+
+    for (i = 0; i < RATE_MESSAGES; i++) {
+      if (i != sv.framenum % RATE_MESSAGES) {
+        budget -= c->message_size[i];
+      }
+    }
+  }
+
+  c->message_size[sv.framenum % RATE_MESSAGES] = 0;
+
+  /* the loopback only queues a few packets */
+  for (sent = 0; sent < fragments && sent < GAMESTATE_BURST && budget > 0; sent++) {
+    c->gamestatefragment %= fragments;
+    offset = c->gamestatefragment * GAMESTATE_FRAGMENT;
+    len = sv.gamestatelen - offset;
+
+    if (len > GAMESTATE_FRAGMENT) {
+      len = GAMESTATE_FRAGMENT;
+    }
+
+    SZ_Init(&msg, msgbuf, sizeof(msgbuf));
+    MSG_WriteByte(&msg, svc_gamestate);
+    MSG_WriteLong(&msg, svs.spawncount);
+    MSG_WriteShort(&msg, sv.gamestateversion);
+    MSG_WriteLong(&msg, sv.gamestatelen);
+    MSG_WriteShort(&msg, c->gamestatefragment);
+    SZ_Write(&msg, sv.gamestate + offset, len);
+
+    Netchan_Transmit(&c->netchan, msg.cursize, msg.data);
+
+    /* record the size for rate estimation */
+    if (c->netchan.compressed) {
+      len = c->netchan.coded_length;
+    } else {
+      len = msg.cursize;
+    }
+
+    c->message_size[sv.framenum % RATE_MESSAGES] += len;
+    c->gamestatefragment++;
+    budget -= len;
+  }
+}
+
 void SV_SendClientMessages(void)
 {
   int i;
@@ -451,6 +526,8 @@ void SV_SendClientMessages(void)
       }
 
       SV_SendClientDatagram(c);
+    } else if (c->gamestate && (sv.state == ss_game)) {
+      SV_SendGamestate(c);
     } else {
       /* just update reliable	if needed */
       if (c->netchan.message.cursize || (curtime - c->netchan.last_sent > 1000)) {
@@ -30,6 +30,20 @@
 
 edict_t *sv_player;
 
+static qboolean SV_GamestateStreaming(void)
+{
+  client_t *c;
+  int i;
+
+  for (i = 0, c = svs.clients; i < maxclients->value; i++, c++) {
+    if ((c->state == cs_connected) && c->gamestate) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 /*
  * Sends the first message from the server to a connected client.
  * This will be sent on the initial connection and upon each server load.
@@ -77,9 +91,61 @@ void SV_New_f(void)
     sv_client->edict = ent;
     memset(&sv_client->lastcmd, 0, sizeof(sv_client->lastcmd));
 
-    /* begin fetching configstrings */
+    /* bring the gamestate up to date, unless another
+       client is still collecting the current one */
+    sv_client->gamestate = false;
+
+    if (sv.gamestatedirty && !SV_GamestateStreaming()) {
+      SV_BuildGamestate();
+    }
+
+    /* stream the whole gamestate if the client takes it,
+       else begin fetching configstrings */
+    if ((sv_client->netflags & NETF_GAMESTATE) && sv.gamestatelen) {
+      sv_client->gamestate = true;
+      sv_client->gamestatefragment = 0;
+    } else {
+      MSG_WriteByte(&sv_client->netchan.message, svc_stufftext);
+      MSG_WriteString(&sv_client->netchan.message, va("cmd configstrings %i 0\n", svs.spawncount));
+    }
+  }
+}
+
+/*
+ * The client has reassembled the whole svc_gamestate. Configstrings
+ * that changed after the blob was built reached it reliably while it
+ * was still collecting, and the older strings in the blob have just
+ * replaced them, so they are sent again.
+ */
+void SV_Gamestate_f(void)
+{
+  int start;
+
+  Com_DPrintf("Gamestate() from %s\n", sv_client->name);
+
+  if ((int) strtol(Cmd_Argv(1), (char **) NULL, 10) != svs.spawncount) {
+    Com_DPrintf("SV_Gamestate_f from different level\n");
+    return;
+  }
+
+  sv_client->gamestate = false;
+  start = (int) strtol(Cmd_Argv(2), (char **) NULL, 10);
+
+  /* write a packet full of data */
+  while (sv_client->netchan.message.cursize < MAX_MSGLEN / 2 && start < MAX_CONFIGSTRINGS) {
+    if (sv.gamestatestale[start]) {
+      MSG_WriteByte(&sv_client->netchan.message, svc_configstring);
+      MSG_WriteShort(&sv_client->netchan.message, start);
+      MSG_WriteString(&sv_client->netchan.message, sv.configstrings[start]);
+    }
+
+    start++;
+  }
+
+  /* send next command */
+  if (start < MAX_CONFIGSTRINGS) {
     MSG_WriteByte(&sv_client->netchan.message, svc_stufftext);
-    MSG_WriteString(&sv_client->netchan.message, va("cmd configstrings %i 0\n", svs.spawncount));
+    MSG_WriteString(&sv_client->netchan.message, va("cmd gamestate %i %i\n", svs.spawncount, start));
   }
 }
 
@@ -181,6 +247,7 @@ void SV_Begin_f(void)
   }
 
   sv_client->state = cs_spawned;
+  sv_client->gamestate = false;
 
   /* call the game begin function */
   ClientBegin(sv_player);
@@ -249,6 +316,7 @@ ucmd_t ucmds[] = {
     {"new", SV_New_f},
     {"configstrings", SV_Configstrings_f},
     {"baselines", SV_Baselines_f},
+    {"gamestate", SV_Gamestate_f},
     {"begin", SV_Begin_f},
     {"nextserver", SV_Nextserver_f},
     {"disconnect", SV_Disconnect_f},
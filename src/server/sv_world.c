@@ -50,6 +50,58 @@ edict_t **area_list;
 int area_count, area_maxcount;
 int area_type;
 
+/*
+ * Solid and trigger edicts are also kept in a pair of balanced dynamic
+ * AABB trees. Leafs hold the edict box fattened by AREA_FATMARGIN, so an
+ * edict moving a few units per frame only touches the tree once it
+ * leaves its fat box, and the tree adapts to where the edicts actually
+ * are instead of a fixed midpoint split of the world.
+ *
+ * Only one of the two structures is kept up to date. sv_areatree is
+ * read when the map is loaded: with the tree, ent->area is linked into
+ * sv_arealinked instead of an area node, so area.prev still tells the
+ * game the entity is linked. The area nodes stay the default, they are
+ * faster until a map has several hundred linked edicts.
+ */
+#define AREA_NULLNODE -1
+#define AREA_FATMARGIN 8
+#define AREA_TREENODES (MAX_EDICTS * 2)
+#define AREA_STACK 256
+
+typedef struct
+{
+  vec3_t mins, maxs;
+  int parent;      /* next free node while on the free list */
+  int children[2]; /* AREA_NULLNODE for leafs */
+  int height;      /* 0 for leafs */
+  edict_t *ent;
+} areatreenode_t;
+
+typedef struct
+{
+  areatreenode_t nodes[AREA_TREENODES];
+  int root;
+  int freelist;
+  int numleafs;
+} areatree_t;
+
+typedef struct
+{
+  int queries;
+  int nodes;    /* area nodes or tree nodes visited */
+  int tested;   /* edict boxes tested */
+  int returned; /* edicts handed back */
+  int inserts;  /* tree leafs (re)inserted */
+  int absorbed; /* relinks that stayed inside the fat box */
+} areastats_t;
+
+static areatree_t sv_areatrees[2]; /* solid, triggers */
+static int sv_areaproxy[MAX_EDICTS];
+static areatree_t *sv_areaproxytree[MAX_EDICTS];
+static areastats_t sv_areastats;
+static qboolean sv_areausetree;
+static link_t sv_arealinked;
+
 int SV_HullForEntity(edict_t *ent);
 
 /* ClearLink is used for new headnodes */
@@ -115,15 +167,326 @@ areanode_t *SV_CreateAreaNode(int depth, vec3_t mins, vec3_t maxs)
   return anode;
 }
 
+static void SV_AreaTreeClear(areatree_t *tree)
+{
+  int i;
+
+  for (i = 0; i < AREA_TREENODES; i++) {
+    tree->nodes[i].parent = i + 1;
+    tree->nodes[i].height = -1;
+  }
+
+  tree->nodes[AREA_TREENODES - 1].parent = AREA_NULLNODE;
+  tree->root = AREA_NULLNODE;
+  tree->freelist = 0;
+  tree->numleafs = 0;
+}
+
+static int SV_AreaTreeAllocNode(areatree_t *tree)
+{
+  areatreenode_t *node;
+  int n;
+
+  /* a tree of MAX_EDICTS leafs never needs more than AREA_TREENODES */
+  n = tree->freelist;
+
+  if (n == AREA_NULLNODE) {
+    Com_Error(ERR_DROP, "SV_AreaTreeAllocNode: no free nodes");
+  }
+
+  node = &tree->nodes[n];
+  tree->freelist = node->parent;
+  node->parent = AREA_NULLNODE;
+  node->children[0] = node->children[1] = AREA_NULLNODE;
+  node->height = 0;
+  node->ent = NULL;
+
+  return n;
+}
+
+static void SV_AreaTreeFreeNode(areatree_t *tree, int n)
+{
+  tree->nodes[n].parent = tree->freelist;
+  tree->nodes[n].height = -1;
+  tree->freelist = n;
+}
+
+/* half the surface area, the cost of descending into a box */
+static float SV_AreaBoxCost(const vec3_t mins, const vec3_t maxs)
+{
+  float dx, dy, dz;
+
+  dx = maxs[0] - mins[0];
+  dy = maxs[1] - mins[1];
+  dz = maxs[2] - mins[2];
+
+  return dx * dy + dy * dz + dz * dx;
+}
+
+static float SV_AreaUnionCost(const areatreenode_t *a, const areatreenode_t *b)
+{
+  vec3_t mins, maxs;
+  int i;
+
+  for (i = 0; i < 3; i++) {
+    mins[i] = a->mins[i] < b->mins[i] ? a->mins[i] : b->mins[i];
+    maxs[i] = a->maxs[i] > b->maxs[i] ? a->maxs[i] : b->maxs[i];
+  }
+
+  return SV_AreaBoxCost(mins, maxs);
+}
+
+static void SV_AreaTreeRefit(areatree_t *tree, int n)
+{
+  areatreenode_t *node, *a, *b;
+  int i;
+
+  node = &tree->nodes[n];
+  a = &tree->nodes[node->children[0]];
+  b = &tree->nodes[node->children[1]];
+
+  for (i = 0; i < 3; i++) {
+    node->mins[i] = a->mins[i] < b->mins[i] ? a->mins[i] : b->mins[i];
+    node->maxs[i] = a->maxs[i] > b->maxs[i] ? a->maxs[i] : b->maxs[i];
+  }
+
+  node->height = 1 + (a->height > b->height ? a->height : b->height);
+}
+
+static void SV_AreaTreeReplaceChild(areatree_t *tree, int parent, int oldchild, int newchild)
+{
+  if (parent == AREA_NULLNODE) {
+    tree->root = newchild;
+  } else if (tree->nodes[parent].children[0] == oldchild) {
+    tree->nodes[parent].children[0] = newchild;
+  } else {
+    tree->nodes[parent].children[1] = newchild;
+  }
+}
+
+/*
+ * If one child of n is more than one level taller than the other,
+ * rotate it up into n's place. Returns the node now at n's position.
+ */
+static int SV_AreaTreeBalance(areatree_t *tree, int n)
+{
+  areatreenode_t *a, *c;
+  int up, other, high, low, balance;
+
+  a = &tree->nodes[n];
+
+  if (a->height < 2) {
+    return n;
+  }
+
+  balance = tree->nodes[a->children[1]].height - tree->nodes[a->children[0]].height;
+
+  if ((balance >= -1) && (balance <= 1)) {
+    return n;
+  }
+
+  /* the taller child moves up, n keeps the other child and takes
+     the shorter grandchild */
+  up = a->children[balance > 1];
+  other = a->children[balance < -1];
+  c = &tree->nodes[up];
+
+  if (tree->nodes[c->children[0]].height > tree->nodes[c->children[1]].height) {
+    high = c->children[0];
+    low = c->children[1];
+  } else {
+    high = c->children[1];
+    low = c->children[0];
+  }
+
+  c->parent = a->parent;
+  SV_AreaTreeReplaceChild(tree, c->parent, n, up);
+  c->children[0] = n;
+  c->children[1] = high;
+
+  a->parent = up;
+  a->children[0] = other;
+  a->children[1] = low;
+  tree->nodes[low].parent = n;
+
+  SV_AreaTreeRefit(tree, n);
+  SV_AreaTreeRefit(tree, up);
+
+  return up;
+}
+
+static void SV_AreaTreeFixUpwards(areatree_t *tree, int n)
+{
+  while (n != AREA_NULLNODE) {
+    n = SV_AreaTreeBalance(tree, n);
+    SV_AreaTreeRefit(tree, n);
+    n = tree->nodes[n].parent;
+  }
+}
+
+static void SV_AreaTreeInsertLeaf(areatree_t *tree, int leaf)
+{
+  areatreenode_t *node, *l;
+  float cost, inherit, cost0, cost1;
+  int n, sibling, oldparent, newparent, i;
+
+  tree->numleafs++;
+
+  if (tree->root == AREA_NULLNODE) {
+    tree->root = leaf;
+    tree->nodes[leaf].parent = AREA_NULLNODE;
+    return;
+  }
+
+  /* descend towards the sibling that grows the tree the least */
+  l = &tree->nodes[leaf];
+  n = tree->root;
+
+  while (tree->nodes[n].height > 0) {
+    node = &tree->nodes[n];
+    cost = 2 * SV_AreaUnionCost(node, l);
+    inherit = cost - 2 * SV_AreaBoxCost(node->mins, node->maxs);
+    cost0 = SV_AreaUnionCost(&tree->nodes[node->children[0]], l) + inherit;
+    cost1 = SV_AreaUnionCost(&tree->nodes[node->children[1]], l) + inherit;
+
+    if (tree->nodes[node->children[0]].height > 0) {
+      cost0 -= SV_AreaBoxCost(tree->nodes[node->children[0]].mins, tree->nodes[node->children[0]].maxs);
+    }
+
+    if (tree->nodes[node->children[1]].height > 0) {
+      cost1 -= SV_AreaBoxCost(tree->nodes[node->children[1]].mins, tree->nodes[node->children[1]].maxs);
+    }
+
+    if ((cost < cost0) && (cost < cost1)) {
+      break;
+    }
+
+    n = cost0 < cost1 ? node->children[0] : node->children[1];
+  }
+
+  sibling = n;
+  oldparent = tree->nodes[sibling].parent;
+  newparent = SV_AreaTreeAllocNode(tree);
+
+  for (i = 0; i < 3; i++) {
+    tree->nodes[newparent].mins[i] = tree->nodes[sibling].mins[i];
+    tree->nodes[newparent].maxs[i] = tree->nodes[sibling].maxs[i];
+  }
+
+  tree->nodes[newparent].parent = oldparent;
+  tree->nodes[newparent].children[0] = sibling;
+  tree->nodes[newparent].children[1] = leaf;
+  SV_AreaTreeReplaceChild(tree, oldparent, sibling, newparent);
+  tree->nodes[sibling].parent = newparent;
+  tree->nodes[leaf].parent = newparent;
+
+  SV_AreaTreeFixUpwards(tree, newparent);
+}
+
+static void SV_AreaTreeRemoveLeaf(areatree_t *tree, int leaf)
+{
+  int parent, grandparent, sibling;
+
+  tree->numleafs--;
+
+  if (leaf == tree->root) {
+    tree->root = AREA_NULLNODE;
+    return;
+  }
+
+  parent = tree->nodes[leaf].parent;
+  grandparent = tree->nodes[parent].parent;
+  sibling = tree->nodes[parent].children[0] == leaf ? tree->nodes[parent].children[1] : tree->nodes[parent].children[0];
+
+  SV_AreaTreeReplaceChild(tree, grandparent, parent, sibling);
+  tree->nodes[sibling].parent = grandparent;
+  SV_AreaTreeFreeNode(tree, parent);
+
+  SV_AreaTreeFixUpwards(tree, grandparent);
+}
+
+static void SV_AreaTreeUnlink(edict_t *ent)
+{
+  int e;
+
+  e = NUM_FOR_EDICT(ent);
+
+  if (sv_areaproxy[e] == AREA_NULLNODE) {
+    return;
+  }
+
+  SV_AreaTreeRemoveLeaf(sv_areaproxytree[e], sv_areaproxy[e]);
+  SV_AreaTreeFreeNode(sv_areaproxytree[e], sv_areaproxy[e]);
+  sv_areaproxy[e] = AREA_NULLNODE;
+  sv_areaproxytree[e] = NULL;
+}
+
+/*
+ * Moves the edict's leaf after a relink. Nothing changes while the
+ * new box still fits in the fat box it was inserted with.
+ */
+static void SV_AreaTreeLink(edict_t *ent)
+{
+  areatree_t *tree;
+  areatreenode_t *node;
+  int e, leaf, i;
+
+  e = NUM_FOR_EDICT(ent);
+  tree = &sv_areatrees[ent->solid == SOLID_TRIGGER];
+  leaf = sv_areaproxy[e];
+
+  if ((leaf != AREA_NULLNODE) && (sv_areaproxytree[e] == tree)) {
+    node = &tree->nodes[leaf];
+
+    if ((ent->absmin[0] >= node->mins[0]) && (ent->absmin[1] >= node->mins[1]) && (ent->absmin[2] >= node->mins[2]) &&
+        (ent->absmax[0] <= node->maxs[0]) && (ent->absmax[1] <= node->maxs[1]) && (ent->absmax[2] <= node->maxs[2])) {
+      sv_areastats.absorbed++;
+      return;
+    }
+  }
+
+  SV_AreaTreeUnlink(ent);
+
+  leaf = SV_AreaTreeAllocNode(tree);
+  node = &tree->nodes[leaf];
+  node->ent = ent;
+
+  for (i = 0; i < 3; i++) {
+    node->mins[i] = ent->absmin[i] - AREA_FATMARGIN;
+    node->maxs[i] = ent->absmax[i] + AREA_FATMARGIN;
+  }
+
+  SV_AreaTreeInsertLeaf(tree, leaf);
+  sv_areaproxy[e] = leaf;
+  sv_areaproxytree[e] = tree;
+  sv_areastats.inserts++;
+}
+
 void SV_ClearWorld(void)
 {
+  int i;
+
   memset(sv_areanodes, 0, sizeof(sv_areanodes));
   sv_numareanodes = 0;
   SV_CreateAreaNode(0, sv.models[1]->mins, sv.models[1]->maxs);
+
+  SV_AreaTreeClear(&sv_areatrees[0]);
+  SV_AreaTreeClear(&sv_areatrees[1]);
+  ClearLink(&sv_arealinked);
+  sv_areausetree = sv_areatree->value != 0;
+
+  for (i = 0; i < MAX_EDICTS; i++) {
+    sv_areaproxy[i] = AREA_NULLNODE;
+    sv_areaproxytree[i] = NULL;
+  }
+
+  memset(&sv_areastats, 0, sizeof(sv_areastats));
 }
 
 void SV_UnlinkEdict(edict_t *ent)
 {
+  SV_AreaTreeUnlink(ent);
+
   if (!ent->area.prev) {
     return; /* not linked in anywhere */
   }
@@ -132,9 +495,47 @@ void SV_UnlinkEdict(edict_t *ent)
   ent->area.prev = ent->area.next = NULL;
 }
 
-void SV_LinkEdict(edict_t *ent)
+/*
+ * Puts an edict with a valid absmin/absmax into
+ * whichever structure answers the area queries
+ */
+static void SV_AreaLinkStructure(edict_t *ent)
 {
   areanode_t *node;
+
+  if (sv_areausetree) {
+    InsertLinkBefore(&ent->area, &sv_arealinked);
+    SV_AreaTreeLink(ent);
+    return;
+  }
+
+  /* find the first node that the ent's box crosses */
+  node = sv_areanodes;
+
+  while (1) {
+    if (node->axis == -1) {
+      break;
+    }
+
+    if (ent->absmin[node->axis] > node->dist) {
+      node = node->children[0];
+    } else if (ent->absmax[node->axis] < node->dist) {
+      node = node->children[1];
+    } else {
+      break; /* crosses the node */
+    }
+  }
+
+  /* link it in */
+  if (ent->solid == SOLID_TRIGGER) {
+    InsertLinkBefore(&ent->area, &node->trigger_edicts);
+  } else {
+    InsertLinkBefore(&ent->area, &node->solid_edicts);
+  }
+}
+
+void SV_LinkEdict(edict_t *ent)
+{
   int leafs[MAX_TOTAL_ENT_LEAFS];
   int clusters[MAX_TOTAL_ENT_LEAFS];
   int num_leafs;
@@ -143,7 +544,9 @@ void SV_LinkEdict(edict_t *ent)
   int topnode;
 
   if (ent->area.prev) {
-    SV_UnlinkEdict(ent); /* unlink from old position */
+    /* unlink from old position, the tree leaf is moved below */
+    RemoveLink(&ent->area);
+    ent->area.prev = ent->area.next = NULL;
   }
 
   if (ent == globals.edicts) {
@@ -151,9 +554,14 @@ void SV_LinkEdict(edict_t *ent)
   }
 
   if (!ent->inuse) {
+    SV_AreaTreeUnlink(ent);
     return;
   }
 
+  /* whatever moved or reshaped it, the game
+     has to look at the entity again */
+  G_WakeEntity(ent);
+
   /* set the size */
   VectorSubtract(ent->maxs, ent->mins, ent->size);
 
@@ -307,32 +715,11 @@ void SV_LinkEdict(edict_t *ent)
   ent->linkcount++;
 
   if (ent->solid == SOLID_NOT) {
+    SV_AreaTreeUnlink(ent);
     return;
   }
 
-  /* find the first node that the ent's box crosses */
-  node = sv_areanodes;
-
-  while (1) {
-    if (node->axis == -1) {
-      break;
-    }
-
-    if (ent->absmin[node->axis] > node->dist) {
-      node = node->children[0];
-    } else if (ent->absmax[node->axis] < node->dist) {
-      node = node->children[1];
-    } else {
-      break; /* crosses the node */
-    }
-  }
-
-  /* link it in */
-  if (ent->solid == SOLID_TRIGGER) {
-    InsertLinkBefore(&ent->area, &node->trigger_edicts);
-  } else {
-    InsertLinkBefore(&ent->area, &node->solid_edicts);
-  }
+  SV_AreaLinkStructure(ent);
 }
 
 void SV_AreaEdicts_r(areanode_t *node)
@@ -340,6 +727,8 @@ void SV_AreaEdicts_r(areanode_t *node)
   link_t *l, *next, *start;
   edict_t *check;
 
+  sv_areastats.nodes++;
+
   /* touch linked edicts */
   if (area_type == AREA_SOLID) {
     start = &node->solid_edicts;
@@ -355,6 +744,8 @@ void SV_AreaEdicts_r(areanode_t *node)
       continue; /* deactivated */
     }
 
+    sv_areastats.tested++;
+
     if ((check->absmin[0] > area_maxs[0]) || (check->absmin[1] > area_maxs[1]) || (check->absmin[2] > area_maxs[2]) ||
         (check->absmax[0] < area_mins[0]) || (check->absmax[1] < area_mins[1]) || (check->absmax[2] < area_mins[2])) {
       continue; /* not touching */
@@ -383,7 +774,82 @@ void SV_AreaEdicts_r(areanode_t *node)
   }
 }
 
-int SV_AreaEdicts(vec3_t mins, vec3_t maxs, edict_t **list, int maxcount, int areatype)
+static void SV_AreaTreeEdicts(areatree_t *tree)
+{
+  areatreenode_t *node, *child;
+  edict_t *check;
+  vec3_t mins, maxs;
+  int stack[AREA_STACK];
+  int sp, i, nodes, tested;
+
+  if (tree->root == AREA_NULLNODE) {
+    return;
+  }
+
+  /* work on copies, the stores below would otherwise force the
+     query box to be reloaded for every node */
+  VectorCopy(area_mins, mins);
+  VectorCopy(area_maxs, maxs);
+  nodes = tested = 0;
+
+  /* children are box tested before they are pushed. the tree is
+     height balanced, so the stack stays far below AREA_STACK */
+  node = &tree->nodes[tree->root];
+
+  if ((node->mins[0] > maxs[0]) || (node->mins[1] > maxs[1]) || (node->mins[2] > maxs[2]) ||
+      (node->maxs[0] < mins[0]) || (node->maxs[1] < mins[1]) || (node->maxs[2] < mins[2])) {
+    return;
+  }
+
+  sp = 0;
+  stack[sp++] = tree->root;
+
+  while (sp) {
+    node = &tree->nodes[stack[--sp]];
+    nodes++;
+
+    if (node->height > 0) {
+      for (i = 0; i < 2; i++) {
+        child = &tree->nodes[node->children[i]];
+
+        if ((child->mins[0] > maxs[0]) || (child->mins[1] > maxs[1]) || (child->mins[2] > maxs[2]) ||
+            (child->maxs[0] < mins[0]) || (child->maxs[1] < mins[1]) || (child->maxs[2] < mins[2])) {
+          continue; /* not touching */
+        }
+
+        stack[sp++] = node->children[i];
+      }
+
+      continue;
+    }
+
+    check = node->ent;
+
+    if (check->solid == SOLID_NOT) {
+      continue; /* deactivated */
+    }
+
+    tested++;
+
+    if ((check->absmin[0] > maxs[0]) || (check->absmin[1] > maxs[1]) || (check->absmin[2] > maxs[2]) ||
+        (check->absmax[0] < mins[0]) || (check->absmax[1] < mins[1]) || (check->absmax[2] < mins[2])) {
+      continue; /* not touching */
+    }
+
+    if (area_count == area_maxcount) {
+      Com_Printf("SV_AreaEdicts: MAXCOUNT\n");
+      break;
+    }
+
+    area_list[area_count] = check;
+    area_count++;
+  }
+
+  sv_areastats.nodes += nodes;
+  sv_areastats.tested += tested;
+}
+
+static int SV_AreaQuery(vec3_t mins, vec3_t maxs, edict_t **list, int maxcount, int areatype, qboolean usetree)
 {
   area_mins = mins;
   area_maxs = maxs;
@@ -392,7 +858,11 @@ int SV_AreaEdicts(vec3_t mins, vec3_t maxs, edict_t **list, int maxcount, int ar
   area_type = areatype;
   area_count = 0;
 
-  SV_AreaEdicts_r(sv_areanodes);
+  if (usetree) {
+    SV_AreaTreeEdicts(&sv_areatrees[areatype == AREA_TRIGGERS]);
+  } else {
+    SV_AreaEdicts_r(sv_areanodes);
+  }
 
   area_mins = 0;
   area_maxs = 0;
@@ -400,9 +870,254 @@ int SV_AreaEdicts(vec3_t mins, vec3_t maxs, edict_t **list, int maxcount, int ar
   area_maxcount = 0;
   area_type = 0;
 
+  sv_areastats.queries++;
+  sv_areastats.returned += area_count;
+
   return area_count;
 }
 
+static int SV_EdictOrder(const void *a, const void *b)
+{
+  return (int) NUM_FOR_EDICT(*(edict_t *const *) a) - (int) NUM_FOR_EDICT(*(edict_t *const *) b);
+}
+
+/*
+ * The area nodes hand edicts back in the order they were linked
+ * into each node. The tree order depends on its shape, which
+ * changes with every rotation, so tree results are sorted by
+ * edict number to keep trace ties and touch order reproducible.
+ */
+int SV_AreaEdicts(vec3_t mins, vec3_t maxs, edict_t **list, int maxcount, int areatype)
+{
+  int count;
+
+  count = SV_AreaQuery(mins, maxs, list, maxcount, areatype, sv_areausetree);
+
+  if (sv_areausetree && (count > 1)) {
+    qsort(list, count, sizeof(list[0]), SV_EdictOrder);
+  }
+
+  return count;
+}
+
+/*
+ * Fills list with the linked edicts of areatype (AREA_SOLID,
+ * AREA_TRIGGERS or both or'ed together) whose bounding box center
+ * lies within radius of org, the test findradius makes. The list
+ * is sorted by edict number, which is the order a findradius walk
+ * visits them in. It is a snapshot: callers that can free or change
+ * entities while going through it have to check each one again.
+ */
+int SV_RadiusEdicts(vec3_t org, float radius, edict_t **list, int maxcount, int areatype)
+{
+  vec3_t mins, maxs, delta;
+  edict_t *check;
+  int type, base, count, num, i, j;
+
+  for (i = 0; i < 3; i++) {
+    mins[i] = org[i] - radius;
+    maxs[i] = org[i] + radius;
+  }
+
+  count = 0;
+
+  for (type = AREA_SOLID; type <= AREA_TRIGGERS; type++) {
+    if (!(areatype & type) || (count == maxcount)) {
+      continue;
+    }
+
+    /* the box around the sphere holds every center
+       inside it, compact the exact matches in place */
+    base = count;
+    num = SV_AreaEdicts(mins, maxs, list + base, maxcount - base, type);
+
+    for (i = 0; i < num; i++) {
+      check = list[base + i];
+
+      for (j = 0; j < 3; j++) {
+        delta[j] = org[j] - (check->s.origin[j] + (check->mins[j] + check->maxs[j]) * 0.5);
+      }
+
+      if (VectorLength(delta) > radius) {
+        continue;
+      }
+
+      list[count++] = check;
+    }
+  }
+
+  qsort(list, count, sizeof(list[0]), SV_EdictOrder);
+
+  return count;
+}
+
+/*
+ * Prints the area query counters gathered since the map was loaded
+ */
+void SV_AreaStats_f(void)
+{
+  if (sv.state != ss_game) {
+    Com_Printf("No map loaded.\n");
+    return;
+  }
+
+  Com_Printf("%s: %i queries, %i nodes, %i tested, %i returned\n", sv_areausetree ? "area tree" : "area nodes",
+             sv_areastats.queries, sv_areastats.nodes, sv_areastats.tested, sv_areastats.returned);
+  Com_Printf("tree: %i solid %i trigger leafs, height %i/%i, %i inserts, %i relinks absorbed\n",
+             sv_areatrees[0].numleafs, sv_areatrees[1].numleafs,
+             sv_areatrees[0].root == AREA_NULLNODE ? 0 : sv_areatrees[0].nodes[sv_areatrees[0].root].height,
+             sv_areatrees[1].root == AREA_NULLNODE ? 0 : sv_areatrees[1].nodes[sv_areatrees[1].root].height,
+             sv_areastats.inserts, sv_areastats.absorbed);
+}
+
+/* about the box a monster or player step traces through */
+static qboolean SV_AreaBenchBox(int e, vec3_t mins, vec3_t maxs)
+{
+  edict_t *ent;
+  int i;
+
+  ent = EDICT_NUM(e);
+
+  if (!ent->inuse || !ent->area.prev) {
+    return false;
+  }
+
+  for (i = 0; i < 3; i++) {
+    mins[i] = ent->absmin[i] - 64;
+    maxs[i] = ent->absmax[i] + 64;
+  }
+
+  return true;
+}
+
+/*
+ * Moves every linked edict into the area nodes or the tree, so
+ * areabench can measure the structure that is not in use
+ */
+static void SV_AreaRelinkAll(qboolean usetree)
+{
+  edict_t *ent;
+  int e;
+
+  sv_areausetree = usetree;
+
+  for (e = 1; e < globals.num_edicts; e++) {
+    ent = EDICT_NUM(e);
+
+    if (!ent->area.prev) {
+      continue;
+    }
+
+    RemoveLink(&ent->area);
+    SV_AreaTreeUnlink(ent);
+    SV_AreaLinkStructure(ent);
+  }
+}
+
+/*
+ * Runs the clipping queries every linked edict would make when moving
+ * against both the area nodes and the area tree, then checks that both
+ * return the same edicts. The world is relinked into each structure in
+ * turn and put back into the one the map was loaded with afterwards.
+ */
+void SV_AreaBench_f(void)
+{
+  static edict_t *list[MAX_EDICTS];
+  static unsigned sums[2][MAX_EDICTS][2];
+  static int counts[2][MAX_EDICTS][2];
+  areastats_t saved, stats;
+  long long start, time;
+  vec3_t mins, maxs;
+  qboolean usetree;
+  unsigned sum;
+  int passes, pass, e, t, type, i, count, mismatches;
+
+  if (sv.state != ss_game) {
+    Com_Printf("No map loaded.\n");
+    return;
+  }
+
+  passes = Cmd_Argc() > 1 ? (int) strtol(Cmd_Argv(1), NULL, 10) : 100;
+
+  if (passes < 1) {
+    passes = 1;
+  }
+
+  saved = sv_areastats;
+  usetree = sv_areausetree;
+  memset(counts, 0, sizeof(counts));
+  memset(sums, 0, sizeof(sums));
+
+  for (t = 0; t < 2; t++) {
+    SV_AreaRelinkAll(t);
+    memset(&sv_areastats, 0, sizeof(sv_areastats));
+    start = Sys_Microseconds();
+
+    for (pass = 0; pass < passes; pass++) {
+      for (e = 1; e < globals.num_edicts; e++) {
+        if (!SV_AreaBenchBox(e, mins, maxs)) {
+          continue;
+        }
+
+        for (type = AREA_SOLID; type <= AREA_TRIGGERS; type++) {
+          SV_AreaQuery(mins, maxs, list, MAX_EDICTS, type, t);
+        }
+      }
+    }
+
+    time = Sys_Microseconds() - start;
+    stats = sv_areastats;
+
+    if (!stats.queries) {
+      Com_Printf("No linked edicts.\n");
+      break;
+    }
+
+    Com_Printf("%-10s: %i queries, %.3f us, %.1f nodes, %.1f tested, %.1f returned per query\n",
+               t ? "area tree" : "area nodes", stats.queries, (double) time / stats.queries,
+               (float) stats.nodes / stats.queries, (float) stats.tested / stats.queries,
+               (float) stats.returned / stats.queries);
+
+    /* keep a checksum of each sorted result to compare the two */
+    for (e = 1; e < globals.num_edicts; e++) {
+      if (!SV_AreaBenchBox(e, mins, maxs)) {
+        continue;
+      }
+
+      for (type = AREA_SOLID; type <= AREA_TRIGGERS; type++) {
+        count = SV_AreaQuery(mins, maxs, list, MAX_EDICTS, type, t);
+        qsort(list, count, sizeof(list[0]), SV_EdictOrder);
+
+        for (sum = 0, i = 0; i < count; i++) {
+          sum = sum * 31 + NUM_FOR_EDICT(list[i]);
+        }
+
+        counts[t][e][type - AREA_SOLID] = count;
+        sums[t][e][type - AREA_SOLID] = sum;
+      }
+    }
+  }
+
+  SV_AreaRelinkAll(usetree);
+  sv_areastats = saved;
+
+  if (t < 2) {
+    return;
+  }
+
+  mismatches = 0;
+
+  for (e = 1; e < globals.num_edicts; e++) {
+    for (type = 0; type < 2; type++) {
+      if ((counts[0][e][type] != counts[1][e][type]) || (sums[0][e][type] != sums[1][e][type])) {
+        mismatches++;
+      }
+    }
+  }
+
+  Com_Printf("%i mismatched queries\n", mismatches);
+}
+
 int SV_PointContents(vec3_t p)
 {
   edict_t *touch[MAX_EDICTS], *hit;
@@ -4,8 +4,13 @@
 #include <stdlib.h>
 #include <math.h>
 
+#include "cmdlib.h"
+#include "threads.h"
+#include "quantlib.h"
+
 unsigned char *table;
 unsigned char pal[768];
+quantizer_t quant;
 
 int findcol(int r, int g, int b)
 {
@@ -42,25 +47,83 @@ int pcxpalload(unsigned char *name, unsigned char *buf)
   return 0;
 }
 
-int main(void)
+/* one blue level, 2048 entries */
+void maketablerow(int x1)
+{
+  long x, y;
+
+  for (x = 0; x < 32; x++)
+    for (y = 0; y < 64; y++)
+      table[(x1 << 11) + (y << 5) + x] = NearestColor(&quant, x * 8, y * 4, x1 * 8);
+}
+
+/* builds the table the old way and reports where it differs */
+void comparetable(void)
+{
+  long x, y, x1;
+  int bad;
+  double start, quanttime;
+  unsigned char *old;
+
+  start = I_FloatTime();
+  RunThreadsOnIndividual(32, false, maketablerow);
+  quanttime = I_FloatTime() - start;
+
+  old = malloc(65536L);
+  start = I_FloatTime();
+  for (x1 = 0; x1 < 32; x1++)
+    for (x = 0; x < 32; x++)
+      for (y = 0; y < 64; y++)
+        old[(x1 << 11) + (y << 5) + x] = findcol(x * 8, y * 4, x1 * 8);
+  printf("linear search: %.3f seconds\n", I_FloatTime() - start);
+  printf("k-d tree:      %.3f seconds (%i threads)\n", quanttime, numthreads);
+
+  bad = 0;
+  for (x = 0; x < 65536; x++)
+    if (old[x] != table[x])
+      bad++;
+  printf("%i of 65536 entries differ\n", bad);
+  free(old);
+}
+
+int main(int argc, char **argv)
 {
-  long x, y, x1, y1, x0, y0;
+  long x;
+  int i;
+  qboolean compare;
   FILE *datfile;
 
+  compare = false;
+  for (i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-threads") && i + 1 < argc)
+      numthreads = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-compare"))
+      compare = true;
+    else {
+      printf("Usage: 16to8 [-threads #] [-compare]\n");
+      exit(1);
+    }
+  }
+
   table = malloc(65536L);
   if (pcxpalload("colormap.pcx", pal)) {
     printf("You need colormap.pcx to run 16to8\n");
     exit(1);
   }
-  printf("32 to go...\n");
-  for (x1 = 0; x1 < 32; x1++) {
-    printf("%d\n", 31 - x1);
-    for (x = 0; x < 32; x++)
-      for (y = 0; y < 64; y++) {
-        table[(x1 << 11) + (y << 5) + x] = findcol(x * 8, y * 4, x1 * 8);
-      }
+
+  /* same starting values as findcol */
+  InitQuantizer(&quant, pal, 0, 255, QUANT_EUCLID_INT);
+  quant.cutoff = 768;
+  quant.fallback = 0;
+
+  ThreadSetDefault();
+  if (compare) {
+    comparetable();
+    return 0;
   }
 
+  RunThreadsOnIndividual(32, true, maketablerow);
+
   printf("Saving 16to8.dat\n");
 
   datfile = fopen("16to8.dat", "wb");
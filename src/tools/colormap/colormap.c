@@ -4,7 +4,13 @@
 #include <stdlib.h>
 #include <math.h>
 
+#include "cmdlib.h"
+#include "threads.h"
+#include "quantlib.h"
+
 unsigned char *cmap, *pal;
+quantizer_t quant;
+qboolean uselinear; /* the old search, for -compare */
 
 int pcxsave(unsigned char *fname)
 {
@@ -87,12 +93,20 @@ short findcol(int r, int g, int b, int beg, int end)
   return c;
 }
 
-void do_color_map(unsigned char *fname)
+short lookupcol(int r, int g, int b)
+{
+  if (uselinear)
+    return findcol(r, g, b, 0, 255);
+  return NearestColor(&quant, r, g, b);
+}
+
+/* 64 shade rows followed by 256 translucency rows */
+void do_color_row(int y)
 {
-  long x, y, r, g, b;
+  long x, r, g, b;
   short c;
 
-  for (y = 0; y < 64; y++)
+  if (y < 64) {
     for (x = 0; x < 256; x++) {
       if (x == 255)
         c = x;
@@ -100,40 +114,106 @@ void do_color_map(unsigned char *fname)
         r = pal[x * 3] * (63 - y) >> 5;
         g = pal[x * 3 + 1] * (63 - y) >> 5;
         b = pal[x * 3 + 2] * (63 - y) >> 5;
-        c = findcol(r, g, b, 0, 255);
+        c = lookupcol(r, g, b);
       }
       cmap[(y << 8) + x] = c;
     }
-  for (y = 0; y < 256; y++)
-    for (x = 0; x < 256; x++) {
-      if (x == 255 || y == 255)
-        c = 255;
-      else {
-        r = (pal[x * 3] * 2 + pal[y * 3]) / 3;
-        g = (pal[x * 3 + 1] * 2 + pal[y * 3 + 1]) / 3;
-        b = (pal[x * 3 + 2] * 2 + pal[y * 3 + 2]) / 3;
-        c = findcol(r, g, b, 0, 255);
-      }
-      cmap[(y + 64 << 8) + x] = c;
+    return;
+  }
+
+  y -= 64;
+  for (x = 0; x < 256; x++) {
+    if (x == 255 || y == 255)
+      c = 255;
+    else {
+      r = (pal[x * 3] * 2 + pal[y * 3]) / 3;
+      g = (pal[x * 3 + 1] * 2 + pal[y * 3 + 1]) / 3;
+      b = (pal[x * 3 + 2] * 2 + pal[y * 3 + 2]) / 3;
+      c = lookupcol(r, g, b);
     }
+    cmap[(y + 64 << 8) + x] = c;
+  }
+}
+
+void do_color_map(unsigned char *fname)
+{
+  RunThreadsOnIndividual(64 + 256, false, do_color_row);
   pcxsave(fname);
 }
 
+/* builds the map both ways and reports where they differ */
+void compare_color_map(void)
+{
+  unsigned char *fast;
+  double start, fasttime;
+  int i, bad;
+
+  start = I_FloatTime();
+  RunThreadsOnIndividual(64 + 256, false, do_color_row);
+  fasttime = I_FloatTime() - start;
+
+  fast = malloc(256 * 320);
+  memcpy(fast, cmap, 256 * 320);
+
+  uselinear = true;
+  start = I_FloatTime();
+  for (i = 0; i < 64 + 256; i++)
+    do_color_row(i);
+  printf("linear search: %.3f seconds\n", I_FloatTime() - start);
+  printf("k-d tree:      %.3f seconds (%i threads)\n", fasttime, numthreads);
+  uselinear = false;
+
+  bad = 0;
+  for (i = 0; i < 256 * 320; i++)
+    if (fast[i] != cmap[i])
+      bad++;
+  printf("%i of %i entries differ\n", bad, 256 * 320);
+  free(fast);
+}
+
 int main(int argc, char *argv[])
 {
   FILE *fil;
+  int i;
+  qboolean compare;
 
   printf("Colormap.exe by Iikka Keränen 1998\n\n");
-  if (argc < 3) {
-    printf("Usage: colormap <palette>.pal <colormap>.pcx\n");
+
+  compare = false;
+  for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+    if (!strcmp(argv[i], "-threads") && i + 1 < argc)
+      numthreads = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-compare"))
+      compare = true;
+    else
+      break;
+  }
+
+  if (argc - i < (compare ? 1 : 2)) {
+    printf("Usage: colormap [-threads #] <palette>.pal <colormap>.pcx\n");
+    printf("       colormap [-threads #] -compare <palette>.pal\n");
     return 0;
   }
   cmap = malloc(256 * 320);
   pal = malloc(768);
-  fil = fopen(argv[1], "rb");
+  fil = fopen(argv[i], "rb");
+  if (!fil) {
+    printf("Can't read file %s\n", argv[i]);
+    return 1;
+  }
   fread(pal, 1, 768, fil);
   fclose(fil);
-  do_color_map(argv[2]);
+
+  /* same range and starting values as findcol */
+  InitQuantizer(&quant, pal, 0, 254, QUANT_MANHATTAN);
+  quant.cutoff = 768;
+  quant.fallback = 0;
+
+  ThreadSetDefault();
+  if (compare)
+    compare_color_map();
+  else
+    do_color_map(argv[i + 1]);
 
   return 0;
 }
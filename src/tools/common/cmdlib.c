@@ -27,6 +27,10 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <sys/stat.h>
 #include <unistd.h>
 
+#ifndef WIN32
+#include <sys/time.h>
+#endif
+
 #ifdef WIN32
 #include <direct.h>
 #endif
@@ -268,26 +272,25 @@ I_FloatTime
 */
 double I_FloatTime(void)
 {
+#ifdef WIN32
   time_t t;
 
   time(&t);
 
   return t;
-#if 0
-    // more precise, less portable
-        struct timeval tp;
-        struct timezone tzp;
-        static int		secbase;
-
-        gettimeofday(&tp, &tzp);
-
-        if (!secbase)
-        {
-            secbase = tp.tv_sec;
-            return tp.tv_usec/1000000.0;
-        }
+#else
+  // more precise, less portable
+  struct timeval tp;
+  static int secbase;
+
+  gettimeofday(&tp, NULL);
+
+  if (!secbase) {
+    secbase = tp.tv_sec;
+    return tp.tv_usec / 1000000.0;
+  }
 
-        return (tp.tv_sec - secbase) + tp.tv_usec/1000000.0;
+  return (tp.tv_sec - secbase) + tp.tv_usec / 1000000.0;
 #endif
 }
 
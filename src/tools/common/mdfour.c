@@ -35,8 +35,6 @@
    It assumes that a int is at least 32 bits long
 */
 
-static struct mdfour *m;
-
 #define F(X, Y, Z) (((X) & (Y)) | ((~(X)) & (Z)))
 #define G(X, Y, Z) (((X) & (Y)) | ((X) & (Z)) | ((Y) & (Z)))
 #define H(X, Y, Z) ((X) ^ (Y) ^ (Z))
@@ -51,7 +49,7 @@ static struct mdfour *m;
 #define ROUND3(a, b, c, d, k, s) a = lshift(a + H(b, c, d) + X[k] + 0x6ED9EBA1, s)
 
 /* this applies md4 to 64 byte chunks */
-static void mdfour64(uint32 *M)
+static void mdfour64(struct mdfour *m, uint32 *M)
 {
   int j;
   uint32 AA, BB, CC, DD;
@@ -167,7 +165,7 @@ void mdfour_begin(struct mdfour *md)
   md->totalN = 0;
 }
 
-static void mdfour_tail(unsigned char *in, int n)
+static void mdfour_tail(struct mdfour *m, unsigned char *in, int n)
 {
   unsigned char buf[128];
   uint32 M[16];
@@ -185,44 +183,38 @@ static void mdfour_tail(unsigned char *in, int n)
   if (n <= 55) {
     copy4(buf + 56, b);
     copy64(M, buf);
-    mdfour64(M);
+    mdfour64(m, M);
   } else {
     copy4(buf + 120, b);
     copy64(M, buf);
-    mdfour64(M);
+    mdfour64(m, M);
     copy64(M, buf + 64);
-    mdfour64(M);
+    mdfour64(m, M);
   }
 }
 
+/* pads and finishes the digest, so call it once per message */
 void mdfour_update(struct mdfour *md, unsigned char *in, int n)
 {
   uint32 M[16];
 
-  if (n == 0)
-    mdfour_tail(in, n);
-
-  m = md;
-
   while (n >= 64) {
     copy64(M, in);
-    mdfour64(M);
+    mdfour64(md, M);
     in += 64;
     n -= 64;
-    m->totalN += 64;
+    md->totalN += 64;
   }
 
-  mdfour_tail(in, n);
+  mdfour_tail(md, in, n);
 }
 
 void mdfour_result(struct mdfour *md, unsigned char *out)
 {
-  m = md;
-
-  copy4(out, m->A);
-  copy4(out + 4, m->B);
-  copy4(out + 8, m->C);
-  copy4(out + 12, m->D);
+  copy4(out, md->A);
+  copy4(out + 4, md->B);
+  copy4(out + 8, md->C);
+  copy4(out + 12, md->D);
 }
 
 void mdfour(unsigned char *out, unsigned char *in, int n)
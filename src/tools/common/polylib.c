@@ -23,15 +23,11 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "cmdlib.h"
 #include "mathlib.h"
 #include "polylib.h"
+#include "poollib.h"
 
 extern int numthreads;
 
-// counters are only bumped when running single threaded,
-// because they are an awefull coherence problem
-int c_active_windings;
-int c_peak_windings;
-int c_winding_allocs;
-int c_winding_points;
+pool_t windingpool = {"windings", POOL_WINDINGS, myoffsetof(winding_t, p), sizeof(vec3_t)};
 
 #define BOGUS_RANGE 8192
 
@@ -49,20 +45,7 @@ AllocWinding
 */
 winding_t *AllocWinding(int points)
 {
-  winding_t *w;
-  int s;
-
-  if (numthreads == 1) {
-    c_winding_allocs++;
-    c_winding_points += points;
-    c_active_windings++;
-    if (c_active_windings > c_peak_windings)
-      c_peak_windings = c_active_windings;
-  }
-  s = sizeof(vec_t) * 3 * points + sizeof(int);
-  w = malloc(s);
-  memset(w, 0, s);
-  return w;
+  return PoolAlloc(&windingpool, points);
 }
 
 void FreeWinding(winding_t *w)
@@ -71,9 +54,7 @@ void FreeWinding(winding_t *w)
     Error("FreeWinding: freed a freed winding");
   *(unsigned *) w = 0xdeaddead;
 
-  if (numthreads == 1)
-    c_active_windings--;
-  free(w);
+  PoolFree(w);
 }
 
 /*
@@ -299,7 +280,7 @@ void ClipWindingEpsilon(winding_t *in, vec3_t normal, vec_t dist, vec_t epsilon,
   vec_t dists[MAX_POINTS_ON_WINDING + 4];
   int sides[MAX_POINTS_ON_WINDING + 4];
   int counts[3];
-  static vec_t dot; // VC 4.2 optimizer bug if not static
+  vec_t dot; // not static, the windings are clipped from several threads
   int i, j;
   vec_t *p1, *p2;
   vec3_t mid;
@@ -401,7 +382,7 @@ void ChopWindingInPlace(winding_t **inout, vec3_t normal, vec_t dist, vec_t epsi
   vec_t dists[MAX_POINTS_ON_WINDING + 4];
   int sides[MAX_POINTS_ON_WINDING + 4];
   int counts[3];
-  static vec_t dot; // VC 4.2 optimizer bug if not static
+  vec_t dot; // not static, the windings are clipped from several threads
   int i, j;
   vec_t *p1, *p2;
   vec3_t mid;
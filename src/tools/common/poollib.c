@@ -0,0 +1,263 @@
+/*
+===========================================================================
+Copyright (C) 1997-2006 Id Software, Inc.
+
+This file is part of Quake 2 Tools source code.
+
+Quake 2 Tools source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake 2 Tools source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake 2 Tools source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#include "cmdlib.h"
+#include "threads.h"
+#include "poollib.h"
+
+// Size class allocator for the variable sized structures the map tools
+// churn through (windings, bsp brushes). Each thread keeps its own free
+// lists, so the common case never takes a lock or goes to malloc. A
+// thread that collects too many blocks of a class, or that finishes its
+// work, moves them to the shared depot where other threads pick them up.
+
+// blocks are carved from malloc and moved to and from the depot this many at a time
+#define POOL_BATCH 16
+
+// the header keeps the payload 16 byte aligned
+#define POOL_HEADER ((int) ((sizeof(poolblock_t) + 15) & ~15))
+
+#define PoolData(b) ((void *) ((byte *) (b) + POOL_HEADER))
+#define PoolBlock(d) ((poolblock_t *) ((byte *) (d) - POOL_HEADER))
+
+typedef struct
+{
+  poolblock_t *free[POOL_CLASSES];
+  int count[POOL_CLASSES];
+  int allocs;
+  int active; // can go negative when blocks are freed by another thread
+} poolcache_t;
+
+pool_t *pools[MAX_POOLS];
+
+THREADLOCAL poolcache_t poolcaches[MAX_POOLS];
+
+/*
+=============
+PoolBlockSize
+=============
+*/
+int PoolBlockSize(pool_t *pool, int elements)
+{
+  return POOL_HEADER + pool->headersize + elements * pool->elementsize;
+}
+
+/*
+=============
+PoolRefill
+
+Fills an empty thread free list from the depot, or from
+a fresh malloc if the depot is empty as well
+=============
+*/
+void PoolRefill(pool_t *pool, poolcache_t *cache, int sizeclass)
+{
+  poolblock_t *b;
+  byte *chunk;
+  int i, size;
+
+  ThreadLock();
+
+  if (pool->depot[sizeclass]) {
+    for (i = 0; i < POOL_BATCH && pool->depot[sizeclass]; i++) {
+      b = pool->depot[sizeclass];
+      pool->depot[sizeclass] = b->next;
+      pool->depotcount[sizeclass]--;
+
+      b->next = cache->free[sizeclass];
+      cache->free[sizeclass] = b;
+      cache->count[sizeclass]++;
+    }
+    ThreadUnlock();
+    return;
+  }
+
+  size = PoolBlockSize(pool, (sizeclass + 1) * POOL_GRANULARITY);
+  pool->peak += POOL_BATCH;
+  pool->bytes += POOL_BATCH * size;
+
+  ThreadUnlock();
+
+  chunk = malloc(POOL_BATCH * size);
+  if (!chunk)
+    Error("PoolRefill: %s out of memory", pool->name);
+
+  for (i = 0; i < POOL_BATCH; i++) {
+    b = (poolblock_t *) (chunk + i * size);
+    b->pool = pool->num;
+    b->sizeclass = sizeclass;
+    b->next = cache->free[sizeclass];
+    cache->free[sizeclass] = b;
+    cache->count[sizeclass]++;
+  }
+}
+
+/*
+=============
+PoolAlloc
+
+Returns cleared memory for the header and elements
+=============
+*/
+void *PoolAlloc(pool_t *pool, int elements)
+{
+  poolcache_t *cache;
+  poolblock_t *b;
+  int sizeclass;
+
+  if (!pools[pool->num]) {
+    ThreadLock();
+    pools[pool->num] = pool;
+    ThreadUnlock();
+  }
+
+  cache = &poolcaches[pool->num];
+  cache->allocs++;
+  cache->active++;
+
+  sizeclass = elements > 0 ? (elements - 1) / POOL_GRANULARITY : 0;
+  if (sizeclass >= POOL_CLASSES) { // rare, don't bother pooling
+    b = malloc(PoolBlockSize(pool, elements));
+    if (!b)
+      Error("PoolAlloc: %s out of memory", pool->name);
+    b->pool = pool->num;
+    b->sizeclass = -1;
+    memset(PoolData(b), 0, pool->headersize + elements * pool->elementsize);
+    return PoolData(b);
+  }
+
+  if (!cache->free[sizeclass])
+    PoolRefill(pool, cache, sizeclass);
+
+  b = cache->free[sizeclass];
+  cache->free[sizeclass] = b->next;
+  cache->count[sizeclass]--;
+
+  memset(PoolData(b), 0, pool->headersize + elements * pool->elementsize);
+  return PoolData(b);
+}
+
+/*
+=============
+PoolFree
+=============
+*/
+void PoolFree(void *data)
+{
+  poolcache_t *cache;
+  poolblock_t *b;
+  pool_t *pool;
+  int i, sizeclass;
+
+  b = PoolBlock(data);
+  cache = &poolcaches[b->pool];
+  cache->active--;
+
+  sizeclass = b->sizeclass;
+  if (sizeclass == -1) {
+    free(b);
+    return;
+  }
+
+  b->next = cache->free[sizeclass];
+  cache->free[sizeclass] = b;
+  cache->count[sizeclass]++;
+
+  if (cache->count[sizeclass] < 2 * POOL_BATCH)
+    return;
+
+  // hand a batch over to the threads that are allocating
+  pool = pools[b->pool];
+  ThreadLock();
+  for (i = 0; i < POOL_BATCH; i++) {
+    b = cache->free[sizeclass];
+    cache->free[sizeclass] = b->next;
+    cache->count[sizeclass]--;
+
+    b->next = pool->depot[sizeclass];
+    pool->depot[sizeclass] = b;
+    pool->depotcount[sizeclass]++;
+  }
+  ThreadUnlock();
+}
+
+/*
+=============
+PoolFlushThread
+
+Moves the calling thread's free blocks and counters to the shared
+pools. Called by every worker before it exits.
+=============
+*/
+void PoolFlushThread(void)
+{
+  poolcache_t *cache;
+  poolblock_t *b;
+  pool_t *pool;
+  int i, j;
+
+  ThreadLock();
+  for (i = 0; i < MAX_POOLS; i++) {
+    pool = pools[i];
+    cache = &poolcaches[i];
+    if (!pool)
+      continue;
+
+    pool->allocs += cache->allocs;
+    pool->active += cache->active;
+    cache->allocs = cache->active = 0;
+
+    for (j = 0; j < POOL_CLASSES; j++) {
+      while (cache->free[j]) {
+        b = cache->free[j];
+        cache->free[j] = b->next;
+
+        b->next = pool->depot[j];
+        pool->depot[j] = b;
+        pool->depotcount[j]++;
+      }
+      cache->count[j] = 0;
+    }
+  }
+  ThreadUnlock();
+}
+
+/*
+=============
+PoolPrintStats
+=============
+*/
+void PoolPrintStats(void)
+{
+  int i;
+  pool_t *pool;
+
+  PoolFlushThread();
+
+  for (i = 0; i < MAX_POOLS; i++) {
+    pool = pools[i];
+    if (!pool)
+      continue;
+    printf("%-12s %9i allocs %7i active %7i peak %6i kb\n", pool->name, pool->allocs, pool->active, pool->peak,
+           pool->bytes / 1024);
+  }
+}
@@ -0,0 +1,62 @@
+/*
+===========================================================================
+Copyright (C) 1997-2006 Id Software, Inc.
+
+This file is part of Quake 2 Tools source code.
+
+Quake 2 Tools source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake 2 Tools source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake 2 Tools source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+// every pool owns a slot in the per-thread caches
+#define MAX_POOLS 4
+#define POOL_WINDINGS 0
+#define POOL_BRUSHES 1
+#define POOL_VISWINDINGS 2
+
+// blocks are grouped in size classes of this many elements
+#define POOL_GRANULARITY 4
+#define POOL_CLASSES 64
+
+typedef struct poolblock_s
+{
+  struct poolblock_s *next; // while on a free list
+  int pool;
+  int sizeclass; // -1 = too big for a class, straight from malloc
+} poolblock_t;
+
+typedef struct
+{
+  char *name;
+  int num;         // POOL_*
+  int headersize;  // bytes before the variable sized part
+  int elementsize; // bytes per point, side, etc
+
+  poolblock_t *depot[POOL_CLASSES]; // handed back by other threads
+  int depotcount[POOL_CLASSES];
+
+  int allocs;
+  int active;
+  int peak; // blocks carved from malloc, they are never given back
+  int bytes;
+} pool_t;
+
+void *PoolAlloc(pool_t *pool, int elements);
+
+void PoolFree(void *data);
+
+void PoolFlushThread(void);
+
+void PoolPrintStats(void);
@@ -0,0 +1,223 @@
+/*
+===========================================================================
+Copyright (C) 1997-2006 Id Software, Inc.
+
+This file is part of Quake 2 Tools source code.
+
+Quake 2 Tools source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake 2 Tools source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake 2 Tools source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#include "cmdlib.h"
+#include "quantlib.h"
+#include <math.h>
+
+// The palette is stored in a k-d tree with one color per node. A search
+// only descends into the far side of a split when the distance along the
+// split axis alone could still tie the best match, so the result is
+// identical to a linear scan: the lowest palette index among the closest
+// colors.
+
+/*
+=============
+ColorDistance
+=============
+*/
+int ColorDistance(quantmetric_t metric, int *rgb, byte *color)
+{
+  int dr, dg, db;
+
+  dr = rgb[0] - color[0];
+  dg = rgb[1] - color[1];
+  db = rgb[2] - color[2];
+
+  switch (metric) {
+  case QUANT_EUCLID_INT:
+    return sqrt(dr * dr + dg * dg + db * db);
+  case QUANT_MANHATTAN:
+    return abs(dr) + abs(dg) + abs(db);
+  default:
+    return dr * dr + dg * dg + db * db;
+  }
+}
+
+/*
+=============
+AxisDistance
+
+The least distance any color on the other side
+of a split delta away could have
+=============
+*/
+int AxisDistance(quantmetric_t metric, int delta)
+{
+  if (metric == QUANT_DIST2)
+    return delta * delta;
+  return abs(delta);
+}
+
+/*
+=============
+BuildQuantTree_r
+
+Splits the indexes at the median of the axis with the largest spread
+=============
+*/
+int BuildQuantTree_r(quantizer_t *q, short *indexes, int count)
+{
+  int i, j, axis, mid, spread, bestspread;
+  int mins[3], maxs[3];
+  short t;
+  byte *a, *b;
+  quantnode_t *node;
+
+  if (!count)
+    return -1;
+
+  for (j = 0; j < 3; j++) {
+    mins[j] = 255;
+    maxs[j] = 0;
+  }
+  for (i = 0; i < count; i++) {
+    a = q->palette + indexes[i] * 3;
+    for (j = 0; j < 3; j++) {
+      if (a[j] < mins[j])
+        mins[j] = a[j];
+      if (a[j] > maxs[j])
+        maxs[j] = a[j];
+    }
+  }
+
+  axis = 0;
+  bestspread = -1;
+  for (j = 0; j < 3; j++) {
+    spread = maxs[j] - mins[j];
+    if (spread > bestspread) {
+      bestspread = spread;
+      axis = j;
+    }
+  }
+
+  // insertion sort, there are never more than 256 colors
+  for (i = 1; i < count; i++) {
+    for (j = i; j > 0; j--) {
+      a = q->palette + indexes[j - 1] * 3;
+      b = q->palette + indexes[j] * 3;
+      if (a[axis] <= b[axis])
+        break;
+      t = indexes[j];
+      indexes[j] = indexes[j - 1];
+      indexes[j - 1] = t;
+    }
+  }
+
+  mid = count / 2;
+  node = &q->nodes[q->numnodes];
+  memcpy(node->color, q->palette + indexes[mid] * 3, 3);
+  node->axis = axis;
+  node->index = indexes[mid];
+  i = q->numnodes++;
+
+  q->nodes[i].children[0] = BuildQuantTree_r(q, indexes, mid);
+  q->nodes[i].children[1] = BuildQuantTree_r(q, indexes + mid + 1, count - mid - 1);
+
+  return i;
+}
+
+/*
+=============
+InitQuantizer
+
+Colors outside start..stop are never returned.
+The cutoff and fallback can be changed afterwards
+to mimic the old tools' starting values.
+=============
+*/
+void InitQuantizer(quantizer_t *q, byte *palette, int start, int stop, quantmetric_t metric)
+{
+  short indexes[256];
+  int i;
+
+  if (start < 0 || stop > 255 || start > stop)
+    Error("InitQuantizer: bad range %i to %i", start, stop);
+
+  memset(q, 0, sizeof(*q));
+  q->metric = metric;
+  q->start = start;
+  q->stop = stop;
+  q->cutoff = 0x7fffffff;
+  q->fallback = start;
+  memcpy(q->palette, palette, 768);
+
+  for (i = start; i <= stop; i++)
+    indexes[i - start] = i;
+  q->root = BuildQuantTree_r(q, indexes, stop - start + 1);
+}
+
+typedef struct
+{
+  int rgb[3];
+  int dist;
+  int index; // -1 until something is under the cutoff
+} quantsearch_t;
+
+/*
+=============
+NearestColor_r
+=============
+*/
+void NearestColor_r(quantizer_t *q, int nodenum, quantsearch_t *s)
+{
+  quantnode_t *node;
+  int d, delta, side;
+
+  node = &q->nodes[nodenum];
+
+  d = ColorDistance(q->metric, s->rgb, node->color);
+  if (d < s->dist || (d == s->dist && s->index != -1 && node->index < s->index)) {
+    s->dist = d;
+    s->index = node->index;
+  }
+
+  delta = s->rgb[node->axis] - node->color[node->axis];
+  side = delta >= 0;
+
+  if (node->children[side] != -1)
+    NearestColor_r(q, node->children[side], s);
+
+  // an equal distance can still win on a lower index
+  if (node->children[!side] != -1 && AxisDistance(q->metric, delta) <= s->dist)
+    NearestColor_r(q, node->children[!side], s);
+}
+
+/*
+=============
+NearestColor
+=============
+*/
+int NearestColor(quantizer_t *q, int r, int g, int b)
+{
+  quantsearch_t s;
+
+  s.rgb[0] = r;
+  s.rgb[1] = g;
+  s.rgb[2] = b;
+  s.dist = q->cutoff;
+  s.index = -1;
+
+  NearestColor_r(q, q->root, &s);
+
+  return s.index == -1 ? q->fallback : s.index;
+}
@@ -0,0 +1,54 @@
+/*
+===========================================================================
+Copyright (C) 1997-2006 Id Software, Inc.
+
+This file is part of Quake 2 Tools source code.
+
+Quake 2 Tools source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake 2 Tools source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake 2 Tools source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+// nearest palette color search, shared by qdata, 16to8 and colormap
+
+typedef enum
+{
+  QUANT_DIST2,      // squared distance (qdata)
+  QUANT_EUCLID_INT, // distance truncated to an int (16to8)
+  QUANT_MANHATTAN   // sum of channel differences (colormap)
+} quantmetric_t;
+
+typedef struct
+{
+  byte color[3];
+  byte axis;
+  short index;       // palette index
+  short children[2]; // -1 = none
+} quantnode_t;
+
+typedef struct
+{
+  quantmetric_t metric;
+  int start, stop; // inclusive palette range
+  int cutoff;      // nothing this far away or further matches
+  int fallback;    // returned when nothing matches
+  byte palette[768];
+  int root;
+  int numnodes;
+  quantnode_t nodes[256];
+} quantizer_t;
+
+void InitQuantizer(quantizer_t *q, byte *palette, int start, int stop, quantmetric_t metric);
+
+int NearestColor(quantizer_t *q, int r, int g, int b);
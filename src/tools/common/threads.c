@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "cmdlib.h"
 #include "threads.h"
+#include "poollib.h"
 
 #define MAX_THREADS 64
 
@@ -77,6 +78,8 @@ void ThreadWorkerFunction(int threadnum)
     // printf ("thread %i, work %i\n", threadnum, work);
     workfunction(work);
   }
+
+  PoolFlushThread();
 }
 
 void RunThreadsOnIndividual(int workcnt, qboolean showpacifier, void (*func)(int))
@@ -368,6 +371,121 @@ void RunThreadsOn(int workcnt, qboolean showpacifier, void (*func)(int))
 
 #endif
 
+/*
+===================================================================
+
+POSIX
+
+===================================================================
+*/
+
+#if !defined(USED) && (defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__))
+#define USED
+
+#include <pthread.h>
+#include <unistd.h>
+
+int numthreads = -1;
+pthread_mutex_t my_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void ThreadSetDefault(void)
+{
+  if (numthreads == -1) // not set manually
+  {
+    numthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (numthreads < 1 || numthreads > MAX_THREADS)
+      numthreads = 1;
+  }
+
+  qprintf("%i threads\n", numthreads);
+}
+
+void ThreadLock(void)
+{
+  if (!threaded)
+    return;
+  pthread_mutex_lock(&my_mutex);
+}
+
+void ThreadUnlock(void)
+{
+  if (!threaded)
+    return;
+  pthread_mutex_unlock(&my_mutex);
+}
+
+typedef struct
+{
+  void (*func)(int);
+  int threadnum;
+} threadstart_t;
+
+void *ThreadStart(void *arg)
+{
+  threadstart_t *start;
+
+  start = arg;
+  start->func(start->threadnum);
+
+  return NULL;
+}
+
+/*
+=============
+RunThreadsOn
+=============
+*/
+void RunThreadsOn(int workcnt, qboolean showpacifier, void (*func)(int))
+{
+  int i;
+  pthread_t work_threads[MAX_THREADS];
+  threadstart_t starts[MAX_THREADS];
+  pthread_attr_t attrib;
+  int start, end;
+
+  start = I_FloatTime();
+  dispatch = 0;
+  workcount = workcnt;
+  oldf = -1;
+  pacifier = showpacifier;
+  threaded = true;
+
+  if (pacifier)
+    setbuf(stdout, NULL);
+
+  if (numthreads == 1) { // use same thread
+    func(0);
+  } else {
+    if (pthread_attr_init(&attrib))
+      Error("pthread_attr_init failed");
+    // the bsp and flow recursions are deep
+    if (pthread_attr_setstacksize(&attrib, 0x800000))
+      Error("pthread_attr_setstacksize failed");
+
+    for (i = 0; i < numthreads; i++) {
+      starts[i].func = func;
+      starts[i].threadnum = i;
+      if (pthread_create(&work_threads[i], &attrib, ThreadStart, &starts[i]))
+        Error("pthread_create failed");
+    }
+
+    for (i = 0; i < numthreads; i++) {
+      if (pthread_join(work_threads[i], NULL))
+        Error("pthread_join failed");
+    }
+
+    pthread_attr_destroy(&attrib);
+  }
+
+  threaded = false;
+
+  end = I_FloatTime();
+  if (pacifier)
+    printf(" (%i)\n", end - start);
+}
+
+#endif
+
 /*
 =======================================================================
 
@@ -420,3 +538,99 @@ void RunThreadsOn(int workcnt, qboolean showpacifier, void (*func)(int))
 }
 
 #endif
+
+/*
+=======================================================================
+
+  TASK QUEUE
+
+Recursive jobs that discover their own work (like splitting a bsp
+subtree) push it here instead of dividing a fixed work count up front.
+=======================================================================
+*/
+
+#ifdef WIN32
+#define ThreadYield() Sleep(0)
+#else
+#include <sched.h>
+#define ThreadYield() sched_yield()
+#endif
+
+typedef struct threadtask_s
+{
+  void (*func)(void *data);
+  void *data;
+  struct threadtask_s *next;
+} threadtask_t;
+
+threadtask_t *taskqueue;
+int activetasks; // queued or still running
+
+/*
+=============
+ThreadQueueTask
+
+Can be called before RunThreadsOnTasks or from inside a running task
+=============
+*/
+void ThreadQueueTask(void (*func)(void *data), void *data)
+{
+  threadtask_t *task;
+
+  task = malloc(sizeof(*task));
+  if (!task)
+    Error("ThreadQueueTask: out of memory");
+  task->func = func;
+  task->data = data;
+
+  ThreadLock();
+  task->next = taskqueue;
+  taskqueue = task;
+  activetasks++;
+  ThreadUnlock();
+}
+
+void ThreadTaskWorker(int threadnum)
+{
+  threadtask_t *task;
+
+  while (1) {
+    ThreadLock();
+    if (!activetasks) {
+      ThreadUnlock();
+      break;
+    }
+    task = taskqueue;
+    if (task)
+      taskqueue = task->next;
+    ThreadUnlock();
+
+    if (!task) { // another thread may still queue more work
+      ThreadYield();
+      continue;
+    }
+
+    task->func(task->data);
+    free(task);
+
+    ThreadLock();
+    activetasks--;
+    ThreadUnlock();
+  }
+
+  PoolFlushThread();
+}
+
+/*
+=============
+RunThreadsOnTasks
+
+Returns when the queue is empty and no task is running
+=============
+*/
+void RunThreadsOnTasks(qboolean showpacifier)
+{
+  if (numthreads == -1)
+    ThreadSetDefault();
+  RunThreadsOn(numthreads, showpacifier, ThreadTaskWorker);
+}
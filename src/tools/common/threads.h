@@ -20,6 +20,12 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 ===========================================================================
 */
 
+#ifdef _MSC_VER
+#define THREADLOCAL __declspec(thread)
+#else
+#define THREADLOCAL __thread
+#endif
+
 extern int numthreads;
 
 void ThreadSetDefault(void);
@@ -33,3 +39,7 @@ void RunThreadsOn(int workcnt, qboolean showpacifier, void (*func)(int));
 void ThreadLock(void);
 
 void ThreadUnlock(void);
+
+void ThreadQueueTask(void (*func)(void *data), void *data);
+
+void RunThreadsOnTasks(qboolean showpacifier);
@@ -1,6 +1,7 @@
 // pak: create and unpack Quake 1 & 2 PAK files
 
 #include <algorithm>
+#include <cctype>
 #include <cstdint>
 #include <cstring>
 #include <filesystem>
@@ -8,6 +9,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace fs = std::filesystem;
@@ -24,14 +26,29 @@ struct PakEntry {
     uint32_t len;
 };
 
+struct PakFile {
+    std::string path;
+    std::string name;
+    uint32_t len;
+    uint32_t offset = 0;
+    bool duplicate = false;
+};
+
+struct PakOptions {
+    std::vector<std::string> traces;
+    uint32_t align = 1;
+};
+
 void usage() {
     std::cout << "pak " << VERSION << " - Quake PAK file utility\n\n";
     std::cout << "USAGE:\n";
-    std::cout << "    pak <output.pak> <file>...    Create PAK from files/directories\n";
-    std::cout << "    pak extract <file.pak>...     Extract files from PAK\n\n";
+    std::cout << "    pak [options] <output.pak> <file>...    Create PAK from files/directories\n";
+    std::cout << "    pak extract <file.pak>...               Extract files from PAK\n\n";
     std::cout << "OPTIONS:\n";
-    std::cout << "    -h, --help       Print help\n";
-    std::cout << "    -V, --version    Print version\n";
+    std::cout << "    -t, --trace <file>    Order files by an engine access trace (fs_trace)\n";
+    std::cout << "    -a, --align <bytes>   Align file data, e.g. 4096 for mmap-friendly reads\n";
+    std::cout << "    -h, --help            Print help\n";
+    std::cout << "    -V, --version         Print version\n";
 }
 
 std::vector<PakEntry> pak_read(std::ifstream& pak) {
@@ -116,78 +133,205 @@ void write_u32_le(std::ostream& out, uint32_t value) {
     out.write(buf, 4);
 }
 
-void pak_write(std::ofstream& pak, const std::vector<std::pair<std::string, uint32_t>>& files) {
-    uint32_t total_size = 0;
-    for (const auto& [path, len] : files) {
-        total_size += len;
+// Name a file is stored under, relative to the pack root
+std::string pak_name(const std::string& path) {
+    std::string name = path;
+
+    // Strip leading '/'
+    while (!name.empty() && name[0] == '/') {
+        name = name.substr(1);
     }
 
-    uint32_t dir_offset = HEADER_SIZE + total_size;
-    uint32_t dir_len = static_cast<uint32_t>(files.size()) * DIR_ENTRY_SIZE;
+    // Strip leading './'
+    while (name.size() >= 2 && name[0] == '.' && name[1] == '/') {
+        name = name.substr(2);
+    }
 
-    pak.write(SIGNATURE, 4);
-    write_u32_le(pak, dir_offset);
-    write_u32_le(pak, dir_len);
+    return name;
+}
 
-    // Write file contents
-    for (const auto& [path, len] : files) {
-        std::ifstream infile(path, std::ios::binary);
-        if (!infile) {
-            throw std::runtime_error("failed to open file: " + path);
+std::string lowercase(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return s;
+}
+
+std::vector<char> read_file(const std::string& path, uint32_t len) {
+    std::ifstream infile(path, std::ios::binary);
+    if (!infile) {
+        throw std::runtime_error("failed to open file: " + path);
+    }
+
+    std::vector<char> data(len);
+    infile.read(data.data(), len);
+    if (static_cast<uint32_t>(infile.gcount()) != len) {
+        throw std::runtime_error("failed to read file: " + path);
+    }
+
+    return data;
+}
+
+uint64_t fnv1a(const std::vector<char>& data) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : data) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Moves files named in the access traces to the front, in the order the
+// engine first opened them. Lines starting with '#' mark the start of a
+// map and are skipped. Returns the number of files that were moved.
+size_t order_by_traces(std::vector<PakFile>& files, const std::vector<std::string>& traces) {
+    std::unordered_map<std::string, size_t> rank;
+
+    for (const auto& trace : traces) {
+        std::ifstream in(trace);
+        if (!in) {
+            throw std::runtime_error("failed to open trace: " + trace);
         }
 
-        constexpr size_t BUFFER_SIZE = 8192;
-        char buffer[BUFFER_SIZE];
-        while (infile) {
-            infile.read(buffer, BUFFER_SIZE);
-            if (infile.gcount() > 0) {
-                pak.write(buffer, infile.gcount());
+        std::string line;
+        while (std::getline(in, line)) {
+            while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
+                line.pop_back();
+            }
+
+            if (line.empty() || line[0] == '#') {
+                continue;
             }
+
+            rank.emplace(lowercase(pak_name(line)), rank.size());
         }
     }
 
-    // Write directory
+    size_t ordered = 0;
+    std::vector<size_t> keys(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        auto it = rank.find(lowercase(files[i].name));
+        if (it != rank.end()) {
+            keys[i] = it->second;
+            ++ordered;
+        } else {
+            keys[i] = rank.size() + i;
+        }
+    }
+
+    std::vector<size_t> order(files.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return keys[a] < keys[b];
+    });
+
+    std::vector<PakFile> sorted;
+    sorted.reserve(files.size());
+    for (size_t i : order) {
+        sorted.push_back(std::move(files[i]));
+    }
+    files = std::move(sorted);
+
+    return ordered;
+}
+
+void write_padding(std::ostream& out, uint32_t& pos, uint32_t align) {
+    static const char zeros[4096] = {0};
+
+    uint32_t pad = (align - pos % align) % align;
+    pos += pad;
+    while (pad > 0) {
+        uint32_t n = std::min(pad, static_cast<uint32_t>(sizeof(zeros)));
+        out.write(zeros, n);
+        pad -= n;
+    }
+}
+
+// Writes file contents in list order. Files with the same contents as
+// an earlier one are stored once, and their directory entries share it.
+// Returns the number of duplicates.
+size_t pak_write(std::ofstream& pak, std::vector<PakFile>& files, uint32_t align) {
+    std::unordered_multimap<uint64_t, size_t> stored;
+    size_t duplicates = 0;
+
+    // Header is rewritten once the directory offset is known
+    pak.write(SIGNATURE, 4);
+    write_u32_le(pak, 0);
+    write_u32_le(pak, 0);
+
+    // Write file contents
     uint32_t pos = HEADER_SIZE;
-    for (const auto& [path, len] : files) {
-        std::string name = path;
+    for (size_t i = 0; i < files.size(); ++i) {
+        auto& file = files[i];
+        std::vector<char> data = read_file(file.path, file.len);
+        uint64_t hash = fnv1a(data);
+
+        auto range = stored.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            const auto& other = files[it->second];
+            if (other.len == file.len && read_file(other.path, other.len) == data) {
+                file.offset = other.offset;
+                file.duplicate = true;
+                break;
+            }
+        }
 
-        // Strip leading '/'
-        while (!name.empty() && name[0] == '/') {
-            name = name.substr(1);
+        if (file.duplicate) {
+            ++duplicates;
+            continue;
         }
 
-        // Strip leading './'
-        while (name.size() >= 2 && name[0] == '.' && name[1] == '/') {
-            name = name.substr(2);
+        write_padding(pak, pos, align);
+
+        if (static_cast<uint64_t>(pos) + file.len > UINT32_MAX) {
+            throw std::runtime_error("PAK file too large");
         }
 
+        file.offset = pos;
+        pak.write(data.data(), file.len);
+        pos += file.len;
+        stored.emplace(hash, i);
+    }
+
+    uint32_t dir_offset = pos;
+    uint32_t dir_len = static_cast<uint32_t>(files.size()) * DIR_ENTRY_SIZE;
+
+    // Write directory
+    for (const auto& file : files) {
         char entry[DIR_ENTRY_SIZE] = {0};
-        size_t write_len = std::min(name.size(), FILENAME_LEN - 1);
-        std::memcpy(entry, name.c_str(), write_len);
+        size_t write_len = std::min(file.name.size(), FILENAME_LEN - 1);
+        std::memcpy(entry, file.name.c_str(), write_len);
 
-        entry[FILENAME_LEN] = static_cast<char>(pos & 0xFF);
-        entry[FILENAME_LEN + 1] = static_cast<char>((pos >> 8) & 0xFF);
-        entry[FILENAME_LEN + 2] = static_cast<char>((pos >> 16) & 0xFF);
-        entry[FILENAME_LEN + 3] = static_cast<char>((pos >> 24) & 0xFF);
+        entry[FILENAME_LEN] = static_cast<char>(file.offset & 0xFF);
+        entry[FILENAME_LEN + 1] = static_cast<char>((file.offset >> 8) & 0xFF);
+        entry[FILENAME_LEN + 2] = static_cast<char>((file.offset >> 16) & 0xFF);
+        entry[FILENAME_LEN + 3] = static_cast<char>((file.offset >> 24) & 0xFF);
 
-        entry[FILENAME_LEN + 4] = static_cast<char>(len & 0xFF);
-        entry[FILENAME_LEN + 5] = static_cast<char>((len >> 8) & 0xFF);
-        entry[FILENAME_LEN + 6] = static_cast<char>((len >> 16) & 0xFF);
-        entry[FILENAME_LEN + 7] = static_cast<char>((len >> 24) & 0xFF);
+        entry[FILENAME_LEN + 4] = static_cast<char>(file.len & 0xFF);
+        entry[FILENAME_LEN + 5] = static_cast<char>((file.len >> 8) & 0xFF);
+        entry[FILENAME_LEN + 6] = static_cast<char>((file.len >> 16) & 0xFF);
+        entry[FILENAME_LEN + 7] = static_cast<char>((file.len >> 24) & 0xFF);
 
         pak.write(entry, DIR_ENTRY_SIZE);
-        pos += len;
     }
 
+    pak.seekp(4);
+    write_u32_le(pak, dir_offset);
+    write_u32_le(pak, dir_len);
+
     if (!pak) {
         throw std::runtime_error("failed to write PAK file");
     }
+
+    return duplicates;
 }
 
-void collect_files(const fs::path& path, std::vector<std::pair<std::string, uint32_t>>& files) {
+void collect_files(const fs::path& path, std::vector<PakFile>& files) {
     if (fs::is_regular_file(path)) {
         auto len = static_cast<uint32_t>(fs::file_size(path));
-        files.emplace_back(path.string(), len);
+        files.push_back({path.string(), pak_name(path.string()), len});
     } else if (fs::is_directory(path)) {
         std::vector<fs::directory_entry> entries;
         for (const auto& entry : fs::directory_iterator(path)) {
@@ -250,13 +394,13 @@ int cmd_extract(int argc, char* argv[]) {
     return 0;
 }
 
-int cmd_create(const char* pak_path, int argc, char* argv[]) {
+int cmd_create(const char* pak_path, int argc, char* argv[], const PakOptions& options) {
     if (argc < 1) {
-        std::cerr << "usage: pak <output.pak> <file>...\n";
+        std::cerr << "usage: pak [options] <output.pak> <file>...\n";
         return 1;
     }
 
-    std::vector<std::pair<std::string, uint32_t>> files;
+    std::vector<PakFile> files;
     for (int i = 0; i < argc; ++i) {
         collect_files(fs::path(argv[i]), files);
     }
@@ -266,14 +410,26 @@ int cmd_create(const char* pak_path, int argc, char* argv[]) {
         return 1;
     }
 
+    size_t ordered = 0;
+    if (!options.traces.empty()) {
+        ordered = order_by_traces(files, options.traces);
+    }
+
     std::ofstream pak(pak_path, std::ios::binary);
     if (!pak) {
         std::cerr << "error: failed to create " << pak_path << "\n";
         return 1;
     }
 
-    pak_write(pak, files);
-    std::cout << "created '" << pak_path << "' (" << files.size() << " files)\n";
+    size_t duplicates = pak_write(pak, files, options.align);
+    std::cout << "created '" << pak_path << "' (" << files.size() << " files";
+    if (duplicates > 0) {
+        std::cout << ", " << duplicates << " duplicates";
+    }
+    if (!options.traces.empty()) {
+        std::cout << ", " << ordered << " in trace order";
+    }
+    std::cout << ")\n";
 
     return 0;
 }
@@ -285,10 +441,28 @@ int main(int argc, char* argv[]) {
             return 1;
         }
 
-        std::string cmd = argv[1];
+        PakOptions options;
+        int first = 1;
+        while (first < argc - 1) {
+            std::string opt = argv[first];
+            if (opt == "-t" || opt == "--trace") {
+                options.traces.push_back(argv[first + 1]);
+            } else if (opt == "-a" || opt == "--align") {
+                long align = std::stol(argv[first + 1]);
+                if (align < 1 || align > 65536) {
+                    throw std::runtime_error("alignment must be between 1 and 65536");
+                }
+                options.align = static_cast<uint32_t>(align);
+            } else {
+                break;
+            }
+            first += 2;
+        }
+
+        std::string cmd = argv[first];
 
         if (cmd == "extract") {
-            return cmd_extract(argc - 2, argv + 2);
+            return cmd_extract(argc - first - 1, argv + first + 1);
         } else if (cmd == "--version" || cmd == "-V") {
             std::cout << "pak " << VERSION << "\n";
             return 0;
@@ -296,7 +470,7 @@ int main(int argc, char* argv[]) {
             usage();
             return 0;
         } else if (cmd[0] != '-') {
-            return cmd_create(argv[1], argc - 2, argv + 2);
+            return cmd_create(argv[first], argc - first - 1, argv + first + 1, options);
         } else {
             usage();
             return 1;
@@ -11,93 +11,145 @@
 
    ==================================
  */
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <stdlib.h>
+#include "cmdlib.h"
+#include "threads.h"
+#include "quantlib.h"
+#include "mdfour.h"
+#include <sys/stat.h>
 #include <math.h>
 
-#define FLIST_LEN 2000 /* max of textures to be converted at once */
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <dirent.h>
+#endif
 
-unsigned char *srcpic, *dstpic, *palette, *srcpal, *hicolor;
-long width, height;
+#define CACHE_FILE "pcx2wal.cache" /* digests of converted textures, for -u */
 
-short pcxload(unsigned char *name, unsigned char *pal)
+typedef struct
 {
-  unsigned long p;
+  unsigned char *srcpic, *dstpic;
+  unsigned char srcpal[768];
+  long width, height;
+} walimage_t;
+
+typedef struct
+{
+  char *dst;
+  unsigned char digest[16];
+  qboolean used;
+} walcache_t;
+
+unsigned char *palette, *hicolor;
+quantizer_t quant;
+
+/* sources, from the command line, directories and manifests */
+unsigned char **fname;
+unsigned char **animnames;
+unsigned char **dstnames;
+int numsrc, maxsrc;
+
+/* options, shared by all the conversions */
+unsigned char ofname[1024];
+unsigned char pathname[256];
+long flags = 0, contents = 0, value = 0;
+unsigned char ignpal = 0;
+short opn = 0, update = 0;
+
+/* digest of everything besides the source that changes the output */
+unsigned char setupdigest[16];
+
+walcache_t *cache;
+int numcache;
+
+unsigned char (*digests)[16];
+short *results; /* 0 = converted, 1 = failed, 2 = unchanged */
+
+/* reads a whole file, or returns NULL */
+unsigned char *pcxread(unsigned char *name, long *len)
+{
+  FILE *pcx;
+  unsigned char *buf;
+
+  pcx = fopen(name, "rb");
+  if (!pcx)
+    return NULL;
+  fseek(pcx, 0, SEEK_END);
+  *len = ftell(pcx);
+  fseek(pcx, 0, SEEK_SET);
+  buf = malloc(*len + 1);
+  *len = fread(buf, 1, *len, pcx);
+  fclose(pcx);
+
+  return buf;
+}
+
+short pcxload(unsigned char *buf, long len, walimage_t *img, unsigned char *pal)
+{
+  unsigned long p, pos;
   short tavu1, tavu2;
   unsigned long w, h;
 
-  FILE *pcx = fopen(name, "rb");
-  if (!pcx) {
-    printf("Can't find file %s\n", name);
+  if (len < 128)
     return (1);
-  }
-  fseek(pcx, 8, SEEK_SET);
-  w = fgetc(pcx);
-  w += (fgetc(pcx) << 8) + 1;
-  h = fgetc(pcx);
-  h += (fgetc(pcx) << 8) + 1;
-  width = w;
-  height = h;
-  /* printf("allocing mem for pictures...\n"); */
 
-  srcpic = (char *) malloc(w * h);
-  dstpic = (char *) malloc(w * h);
+  w = buf[8];
+  w += (buf[9] << 8) + 1;
+  h = buf[10];
+  h += (buf[11] << 8) + 1;
+  img->width = w;
+  img->height = h;
 
-  fseek(pcx, 128, SEEK_SET); /* Load image */
+  img->srcpic = malloc(w * h);
+  img->dstpic = malloc(w * h);
 
+  /* past the end reads as EOF, like fgetc did */
+  pos = 128; /* Load image */
   for (p = 0; p < w * h;) {
-    tavu1 = fgetc(pcx);
+    tavu1 = pos < (unsigned long) len ? buf[pos++] : EOF;
     if (tavu1 > 192) {
-      tavu2 = fgetc(pcx);
-      for (; tavu1 > 192; tavu1--)
-        srcpic[p++] = tavu2;
+      tavu2 = pos < (unsigned long) len ? buf[pos++] : EOF;
+      for (; tavu1 > 192 && p < w * h; tavu1--) /* runs can cross the last row */
+        img->srcpic[p++] = tavu2;
     } else
-      srcpic[p++] = tavu1;
+      img->srcpic[p++] = tavu1;
   }
 
-  if (pal) {
-    fseek(pcx, -768, SEEK_END); /* Load palette */
-
-    fread(pal, 1, 768, pcx);
-  }
-  /* printf("PCX loaded successfully...\n"); */
+  if (pal && len >= 768)
+    memcpy(pal, buf + len - 768, 768); /* Load palette */
 
-  fclose(pcx);
   return 0;
 }
 
 short findcol(int r, int g, int b, int beg, int end)
 { /* FIND RGB COLOR */
-  int c1, c = 0, e, ee = 768;
-
   if (!hicolor)
-    for (c1 = beg; c1 < end; c1++) {
-      e = abs(palette[c1 + c1 + c1] - r) + abs(palette[c1 + c1 + c1 + 1] - g) + abs(palette[c1 + c1 + c1 + 2] - b);
-      if (e < ee) {
-        c = c1;
-        ee = e;
-      }
-    }
-  else
-    c = hicolor[(r >> 3 << 11) + (g >> 2 << 5) + (b >> 3)];
+    return NearestColor(&quant, r, g, b); /* same as a search of [beg, end) */
 
-  return c;
+  return hicolor[(r >> 3 << 11) + (g >> 2 << 5) + (b >> 3)];
 }
 
-short mip(char fac)
+short mip(walimage_t *img, char fac)
 {
   long x, y, x1, y1, xs, ys, c, n;
   long r, g, b, vx, vy;
   unsigned int po, po1;
-  long w = width, h = height;
-
-  /* printf("Mip-mapping... "); */
+  long w = img->width, h = img->height;
+  unsigned char *srcpal = img->srcpal;
+  unsigned char remap[256];
 
   xs = w >> fac;
   ys = h >> fac;
 
+  /* full size only remaps colours, so look each one up once */
+  if (fac == 0) {
+    for (c = 0; c < 256; c++)
+      remap[c] = findcol(srcpal[c * 3], srcpal[c * 3 + 1], srcpal[c * 3 + 2], 0, 255);
+    for (po = 0; po < xs * ys; po++)
+      img->dstpic[po] = remap[img->srcpic[po]];
+    return 0;
+  }
+
   for (y = 0; y < ys; y++)
     for (x = 0; x < xs; x++) {
       x1 = x << fac;
@@ -109,7 +161,7 @@ short mip(char fac)
       for (vy = y1; vy < y1 + (1 << fac); vy++) {
         po1 = vy * w + x1;
         for (vx = x1; vx < x1 + (1 << fac); vx++) {
-          c = srcpic[po1];
+          c = img->srcpic[po1];
           r += srcpal[c * 3];
           g += srcpal[c * 3 + 1];
           b += srcpal[c * 3 + 2];
@@ -122,19 +174,101 @@ short mip(char fac)
       b = b * 1.0 / n + .5;
       c = findcol(r, g, b, 0, 255);
       po = y * xs + x;
-      dstpic[po] = c;
+      img->dstpic[po] = c;
     }
 
-  /* printf("Done.\n"); */
-
   return 0;
 }
 
-short pcx2wal(unsigned char *src, unsigned char *dst, unsigned char *next, unsigned char *path, long flags,
+/*
+   ========
+   CACHE
+   ========
+ */
+
+int cachecmp(const void *a, const void *b)
+{
+  return strcmp(((walcache_t *) a)->dst, ((walcache_t *) b)->dst);
+}
+
+void loadcache(void)
+{
+  FILE *f;
+  char line[1200], hex[40], dst[1024];
+  int i, maxcache = 0;
+  unsigned int v;
+
+  f = fopen(CACHE_FILE, "r");
+  if (!f)
+    return;
+  while (fgets(line, sizeof(line), f)) {
+    if (sscanf(line, "%32s %1023[^\r\n]", hex, dst) != 2 || strlen(hex) != 32)
+      continue;
+    if (numcache == maxcache) {
+      maxcache = maxcache ? maxcache * 2 : 256;
+      cache = realloc(cache, maxcache * sizeof(*cache));
+    }
+    for (i = 0; i < 16; i++) {
+      sscanf(hex + i * 2, "%2x", &v);
+      cache[numcache].digest[i] = v;
+    }
+    cache[numcache].dst = copystring(dst);
+    cache[numcache].used = false;
+    numcache++;
+  }
+  fclose(f);
+
+  qsort(cache, numcache, sizeof(*cache), cachecmp);
+}
+
+/* entries that weren't converted this time are kept */
+void savecache(void)
+{
+  FILE *f;
+  int i, j;
+
+  f = fopen(CACHE_FILE, "w");
+  if (!f) {
+    printf("Error: can't write %s\n", CACHE_FILE);
+    return;
+  }
+  for (i = 0; i < numcache; i++) {
+    if (cache[i].used)
+      continue;
+    for (j = 0; j < 16; j++)
+      fprintf(f, "%02x", cache[i].digest[j]);
+    fprintf(f, " %s\n", cache[i].dst);
+  }
+  for (i = 0; i < numsrc; i++) {
+    if (results[i] == 1)
+      continue;
+    for (j = 0; j < 16; j++)
+      fprintf(f, "%02x", digests[i][j]);
+    fprintf(f, " %s\n", dstnames[i]);
+  }
+  fclose(f);
+}
+
+walcache_t *findcache(char *dst)
+{
+  walcache_t key;
+
+  if (!numcache)
+    return NULL;
+  key.dst = dst;
+  return bsearch(&key, cache, numcache, sizeof(*cache), cachecmp);
+}
+
+short pcx2wal(int num, unsigned char *src, unsigned char *dst, unsigned char *next, unsigned char *path, long flags,
               long contents, long value, char by)
 {
-  unsigned char texname[256];
-  unsigned char texname2[256];
+  unsigned char texname[1024];
+  unsigned char texname2[1024];
+  char key[3 * 1024 + 64];
+  walimage_t img;
+  unsigned char *buf, *msg;
+  long len, keylen;
+  walcache_t *cached;
   FILE *wal;
   long x;
   char suf;
@@ -146,29 +280,68 @@ short pcx2wal(unsigned char *src, unsigned char *dst, unsigned char *next, unsig
     dst[strlen(dst) - 2] = 'a';
     dst[strlen(dst) - 1] = 'l';
   }
-  if (strlen(path))
-    memcpy(texname, path, strlen(path) + 1);
-  else
-    texname[0] = 0;
-  memcpy(texname + strlen(texname), dst, strlen(dst) + 1);
+  if (snprintf((char *) texname, sizeof(texname), "%s%s", path, dst) >= (int) sizeof(texname)) {
+    printf("%s ...Texture name too long\n", src);
+    return (1);
+  }
   texname[strlen(texname) - 4] = 0;
 
   if (next) {
-    memcpy(texname2, path, strlen(path) + 1);
-    memcpy(texname2 + strlen(texname2), next, strlen(next) + 1);
+    if (snprintf((char *) texname2, sizeof(texname2), "%s%s", path, next) >= (int) sizeof(texname2)) {
+      printf("%s ...Texture name too long\n", src);
+      return (1);
+    }
     texname2[strlen(texname2) - 4] = 0;
   } else
     texname2[0] = 0;
 
+  buf = pcxread(src, &len);
+  if (!buf) {
+    printf("%s ...Can't find file %s\n", src, src);
+    return (1);
+  }
+
+  /* the output only depends on the source and the settings,
+     hashed as one message since mdfour_update finishes it */
+  keylen = snprintf(key, sizeof(key), "%s\n%s\n%s\n%ld %ld %ld %d", texname, dst, next ? (char *) next : "", flags,
+                    contents, value, by);
+  if (keylen >= (long) sizeof(key))
+    keylen = sizeof(key) - 1;
+  msg = malloc(len + keylen + 16);
+  memcpy(msg, buf, len);
+  memcpy(msg + len, key, keylen);
+  memcpy(msg + len + keylen, setupdigest, 16);
+  mdfour(digests[num], msg, len + keylen + 16);
+  free(msg);
+
+  if (update) {
+    cached = findcache((char *) dst);
+    if (cached) {
+      cached->used = true;
+      if (!memcmp(cached->digest, digests[num], 16) && FileTime((char *) dst) != -1) {
+        free(buf);
+        return (2);
+      }
+    }
+  }
+
+  img.srcpic = img.dstpic = NULL;
   if (by & 1) {
-    if (pcxload(src, NULL) == 1)
-      return (1);
-    memcpy(srcpal, palette, 768);
-  } else if (pcxload(src, srcpal) == 1)
+    if (pcxload(buf, len, &img, NULL) == 0)
+      memcpy(img.srcpal, palette, 768);
+  } else
+    pcxload(buf, len, &img, img.srcpal);
+  free(buf);
+  if (!img.srcpic) {
+    printf("%s ...Can't read file %s\n", src, src);
     return (1);
+  }
+
   wal = fopen(dst, "wb");
   if (!wal) {
     printf("Error: can't write file! Disk full?\n");
+    free(img.srcpic);
+    free(img.dstpic);
     return (1);
   }
   suf = 0;
@@ -181,15 +354,15 @@ short pcx2wal(unsigned char *src, unsigned char *dst, unsigned char *next, unsig
     else
       fputc(0, wal);
   }
-  fwrite(&width, 1, 4, wal);
-  fwrite(&height, 1, 4, wal);
+  fwrite(&img.width, 1, 4, wal);
+  fwrite(&img.height, 1, 4, wal);
   x = 100;
   fwrite(&x, 1, 4, wal);
-  x += width * height;
+  x += img.width * img.height;
   fwrite(&x, 1, 4, wal);
-  x += (width / 2) * (height / 2);
+  x += (img.width / 2) * (img.height / 2);
   fwrite(&x, 1, 4, wal);
-  x += (width / 4) * (height / 4);
+  x += (img.width / 4) * (img.height / 4);
   fwrite(&x, 1, 4, wal);
   for (x = 0; x < 32; x++) {
     if (next != NULL && x < strlen(next))
@@ -202,23 +375,26 @@ short pcx2wal(unsigned char *src, unsigned char *dst, unsigned char *next, unsig
   fwrite(&value, 1, 4, wal);
 
   if (by & 1)
-    memcpy(dstpic, srcpic, width * height); /* copy as is. */
+    memcpy(img.dstpic, img.srcpic, img.width * img.height); /* copy as is. */
 
   else
-    mip(0);
-  fwrite(dstpic, 1, width * height, wal);
-  mip(1);
-  fwrite(dstpic, 1, width / 2 * height / 2, wal);
-  mip(2);
-  fwrite(dstpic, 1, width / 4 * height / 4, wal);
-  mip(3);
-  fwrite(dstpic, 1, width / 8 * height / 8, wal);
+    mip(&img, 0);
+  fwrite(img.dstpic, 1, img.width * img.height, wal);
+  mip(&img, 1);
+  fwrite(img.dstpic, 1, img.width / 2 * img.height / 2, wal);
+  mip(&img, 2);
+  fwrite(img.dstpic, 1, img.width / 4 * img.height / 4, wal);
+  mip(&img, 3);
+  fwrite(img.dstpic, 1, img.width / 8 * img.height / 8, wal);
 
   fclose(wal);
-  printf(" %s saved as %s", texname, dst);
+  free(img.srcpic);
+  free(img.dstpic);
+
   if (strlen(texname2))
-    printf(" (->%s)", texname2);
-  printf("\n");
+    printf("%s ... %s saved as %s (->%s)\n", src, texname, dst, texname2);
+  else
+    printf("%s ... %s saved as %s\n", src, texname, dst);
 
   return 0;
 }
@@ -241,21 +417,117 @@ long countval(char *str)
   return val;
 }
 
+void addsource(char *name)
+{
+  if (numsrc == maxsrc) {
+    maxsrc = maxsrc ? maxsrc * 2 : 256;
+    fname = realloc(fname, maxsrc * sizeof(*fname));
+  }
+  fname[numsrc++] = copystring(name);
+}
+
+int ispcx(char *name)
+{
+  return strlen(name) > 4 && !Q_strcasecmp(name + strlen(name) - 4, ".pcx");
+}
+
+/* adds every .pcx under a directory */
+void adddirectory(char *dir)
+{
+  char path[1024];
+  struct stat st;
+#ifdef _WIN32
+  struct _finddata_t fileinfo;
+  intptr_t handle;
+
+  sprintf(path, "%s/*", dir);
+  handle = _findfirst(path, &fileinfo);
+  if (handle == -1)
+    return;
+  do {
+    char *name = fileinfo.name;
+#else
+  DIR *d;
+  struct dirent *ent;
+
+  d = opendir(dir);
+  if (!d)
+    return;
+  while ((ent = readdir(d)) != NULL) {
+    char *name = ent->d_name;
+#endif
+    if (name[0] == '.')
+      continue;
+    sprintf(path, "%s/%s", dir, name);
+    if (stat(path, &st) == -1)
+      continue;
+    if (S_ISDIR(st.st_mode))
+      adddirectory(path);
+    else if (ispcx(name))
+      addsource(path);
+#ifdef _WIN32
+  } while (_findnext(handle, &fileinfo) != -1);
+  _findclose(handle);
+#else
+  }
+  closedir(d);
+#endif
+}
+
+/* one source file per line */
+void addmanifest(char *name)
+{
+  FILE *f;
+  char line[1024];
+  int l;
+
+  f = fopen(name, "r");
+  if (!f) {
+    printf("Error: Can't find file %s\n", name);
+    exit(1);
+  }
+  while (fgets(line, sizeof(line), f)) {
+    l = strlen(line);
+    while (l > 0 && (line[l - 1] == '\n' || line[l - 1] == '\r' || line[l - 1] == ' '))
+      line[--l] = 0;
+    if (l > 0)
+      addsource(line);
+  }
+  fclose(f);
+}
+
+/* options followed by a value, which isn't a source */
+int isvalueoption(char *arg)
+{
+  return !strcmp(arg, "-o") || !strcmp(arg, "-t") || !strcmp(arg, "-n") || !strcmp(arg, "-f") || !strcmp(arg, "-c") ||
+         !strcmp(arg, "-v") || !strcmp(arg, "-l") || !strcmp(arg, "-threads");
+}
+
+void converttexture(int x)
+{
+  if (opn)
+    strcpy((char *) dstnames[x], (char *) ofname);
+  else
+    strcpy((char *) dstnames[x], (char *) fname[x]);
+  results[x] = pcx2wal(x, fname[x], dstnames[x], animnames[x], pathname, flags, contents, value, ignpal);
+}
+
 int main(int argc, char *argv[])
 {
   unsigned char *animname = NULL;
-  unsigned char ofname[256];
-  unsigned char *fname[FLIST_LEN];
-  unsigned char pathname[256];
-  long flags = 0, contents = 0, value = 0;
   long x, y, a, nf;
-  unsigned char ignpal = 0, anim = 0;
-  short opn = 0, pth = 0, numsrc = 0;
+  unsigned char anim = 0;
+  short pth = 0;
+  int converted, skipped, failed;
+  double start, elapsed;
+  struct stat st;
+  unsigned char *setup;
   FILE *palfile;
 
   printf("PCX2WAL (c) Iikka Keränen 1997-1998\n\n");
   if (argc < 2) {
     printf("Usage: PCX2WAL <source> [source2] [source3] ... [options]\n");
+    printf("Sources can be .pcx files or directories holding them\n");
     printf("Options:\n");
     printf("-o output   -- output file (by default, foo.pcx -> foo.wal)\n");
     printf("-t texpath  -- texture path (e.g. e1u1/)\n");
@@ -266,10 +538,14 @@ int main(int argc, char *argv[])
     printf("-a          -- automatic animation (wildcard/multiple texs only)\n");
     printf("-p          -- assume source palette == final palette (speedup)\n");
     printf("-d          -- use 16to8.dat to find colours (speedup)\n");
+    printf("-l list     -- convert the files listed in a manifest, one per line\n");
+    printf("-u          -- only convert sources changed since the last run\n");
+    printf("-threads #  -- number of textures converted at once\n");
     printf("\nExamples:\n");
     printf("PCX2WAL coolwall.pcx coolwall.wal coolwall\n");
     printf("PCX2WAL animwal0.pcx animwal0.wal animwal0 -n animwal1 -f 1 -v 400\n");
     printf("PCX2WAL *.pcx -a -p -d\n");
+    printf("PCX2WAL textures -u -threads 8\n");
 
     return 0;
   }
@@ -277,10 +553,10 @@ int main(int argc, char *argv[])
   pathname[0] = 0; /* make a 0-long string */
 
   for (x = 1; x < argc; x++) {
-    if (!strcmp(argv[x] + strlen(argv[x]) - 4, ".pcx")) {
-      fname[numsrc] = argv[x];
-      numsrc++;
-    }
+    if (!strcmp(argv[x] + strlen(argv[x]) - 4, ".pcx"))
+      addsource(argv[x]);
+    else if (argv[x][0] != '-' && !isvalueoption(argv[x - 1]) && stat(argv[x], &st) == 0 && S_ISDIR(st.st_mode))
+      adddirectory(argv[x]);
     if (x < argc - 1) {
       if (!strcmp(argv[x], "-o")) {
         strcpy(ofname, argv[x + 1]);
@@ -298,11 +574,17 @@ int main(int argc, char *argv[])
         contents = countval(argv[x + 1]);
       if (!strcmp(argv[x], "-v"))
         value = countval(argv[x + 1]);
+      if (!strcmp(argv[x], "-l"))
+        addmanifest(argv[x + 1]);
+      if (!strcmp(argv[x], "-threads"))
+        numthreads = atoi(argv[x + 1]);
     }
     if (!strcmp(argv[x], "-a"))
       anim = 1;
     if (!strcmp(argv[x], "-p"))
       ignpal = 1;
+    if (!strcmp(argv[x], "-u"))
+      update = 1;
     if (!strcmp(argv[x], "-d")) {
       hicolor = (char *) malloc(65536);
       palfile = fopen("16to8.dat", "rb");
@@ -315,10 +597,7 @@ int main(int argc, char *argv[])
     }
   }
 
-  /* printf("allocing mem for palette...\n"); */
-
   palette = (char *) malloc(768);
-  srcpal = (char *) malloc(768);
 
   palfile = fopen("palette.pal", "rb");
   if (!palfile) {
@@ -328,16 +607,29 @@ int main(int argc, char *argv[])
   fread(palette, 1, 768, palfile);
   fclose(palfile);
 
+  /* same starting values as the old findcol search */
+  InitQuantizer(&quant, palette, 0, 254, QUANT_MANHATTAN);
+  quant.cutoff = 768;
+  quant.fallback = 0;
+
+  setup = malloc(768 + 65536);
+  memcpy(setup, palette, 768);
+  if (hicolor)
+    memcpy(setup + 768, hicolor, 65536);
+  mdfour(setupdigest, setup, hicolor ? 768 + 65536 : 768);
+  free(setup);
+
   if (numsrc == 1)
     printf("%d texture to be converted...\n", numsrc);
   else
     printf("%d textures to be converted...\n", numsrc);
 
+  animnames = malloc(numsrc * sizeof(*animnames) + 1);
+  dstnames = malloc(numsrc * sizeof(*dstnames) + 1);
   for (x = 0; x < numsrc; x++) {
     if (anim)
       animname = NULL;
 
-    printf("%s ...", fname[x]);
     if (anim == 1 && fname[x][0] == '_') { /* animated texs */
       a = fname[x][1] - '0';
       nf = -1;
@@ -354,13 +646,44 @@ int main(int argc, char *argv[])
         nf = x;
       animname = fname[nf];
     }
-    if (!opn)
-      strcpy(ofname, fname[x]);
-    pcx2wal(fname[x], ofname, animname, pathname, flags, contents, value, ignpal);
+    animnames[x] = animname;
+    dstnames[x] = malloc(1024);
+  }
+
+  digests = malloc(numsrc * sizeof(*digests) + 1);
+  results = malloc(numsrc * sizeof(*results) + 1);
+
+  if (update)
+    loadcache();
+
+  /* every texture would go to the same output */
+  if (opn)
+    numthreads = 1;
+  ThreadSetDefault();
+
+  start = I_FloatTime();
+  RunThreadsOnIndividual(numsrc, false, converttexture);
+  elapsed = I_FloatTime() - start;
+
+  if (update)
+    savecache();
+
+  converted = skipped = failed = 0;
+  for (x = 0; x < numsrc; x++) {
+    if (results[x] == 0)
+      converted++;
+    else if (results[x] == 2)
+      skipped++;
+    else
+      failed++;
+  }
+  if (numsrc > 1) {
+    printf("%d converted, %d unchanged, %d failed in %.2f seconds", converted, skipped, failed, elapsed);
+    if (elapsed > 0)
+      printf(" (%.1f images/sec)", converted / elapsed);
+    printf("\n");
   }
 
-  free(dstpic);
-  free(srcpic);
   free(palette);
 
   return 0;
@@ -24,7 +24,12 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 int c_nodes;
 int c_nonvis;
-int c_active_brushes;
+
+// counted by each thread and added up by AddNodeCounts
+THREADLOCAL int c_threadnodes;
+THREADLOCAL int c_threadnonvis;
+
+pool_t brushpool = {"brushes", POOL_BRUSHES, myoffsetof(bspbrush_t, sides), sizeof(side_t)};
 
 // if a brush just barely pokes onto the other side,
 // let it slide by without chopping
@@ -36,6 +41,18 @@ int c_active_brushes;
 #define PSIDE_BOTH (PSIDE_FRONT | PSIDE_BACK)
 #define PSIDE_FACING 4
 
+// subtrees with at least this many brushes are handed to
+// another thread instead of being built by the current one
+#define TASK_BRUSHES 32
+
+qboolean bsptasks;
+
+typedef struct
+{
+  node_t *node;
+  bspbrush_t *brushes;
+} bsptask_t;
+
 void FindBrushInTree(node_t *node, int brushnum)
 {
   bspbrush_t *b;
@@ -303,15 +320,7 @@ AllocBrush
 */
 bspbrush_t *AllocBrush(int numsides)
 {
-  bspbrush_t *bb;
-  int c;
-
-  c = (int) &(((bspbrush_t *) 0)->sides[numsides]);
-  bb = malloc(c);
-  memset(bb, 0, c);
-  if (numthreads == 1)
-    c_active_brushes++;
-  return bb;
+  return PoolAlloc(&brushpool, numsides);
 }
 
 /*
@@ -326,9 +335,7 @@ void FreeBrush(bspbrush_t *brushes)
   for (i = 0; i < brushes->numsides; i++)
     if (brushes->sides[i].winding)
       FreeWinding(brushes->sides[i].winding);
-  free(brushes);
-  if (numthreads == 1)
-    c_active_brushes--;
+  PoolFree(brushes);
 }
 
 /*
@@ -813,10 +820,8 @@ side_t *SelectSplitSide(bspbrush_t *brushes, node_t *node)
     // if we found a good plane, don't bother trying any
     // other passes
     if (bestside) {
-      if (pass > 1) {
-        if (numthreads == 1)
-          c_nonvis++;
-      }
+      if (pass > 1)
+        c_threadnonvis++;
       if (pass > 0)
         node->detail_seperator = true; // not needed for vis
       break;
@@ -1098,6 +1103,59 @@ void SplitBrushList(bspbrush_t *brushes, node_t *node, bspbrush_t **front, bspbr
   }
 }
 
+node_t *BuildTree_r(node_t *node, bspbrush_t *brushes);
+
+/*
+================
+AddNodeCounts
+
+Adds what the calling thread counted to the totals
+================
+*/
+void AddNodeCounts(void)
+{
+  ThreadLock();
+  c_nodes += c_threadnodes;
+  c_nonvis += c_threadnonvis;
+  ThreadUnlock();
+
+  c_threadnodes = 0;
+  c_threadnonvis = 0;
+}
+
+/*
+================
+BuildTree_Task
+================
+*/
+void BuildTree_Task(void *data)
+{
+  bsptask_t *task;
+
+  task = data;
+  BuildTree_r(task->node, task->brushes);
+  AddNodeCounts();
+  free(task);
+}
+
+/*
+================
+QueueBuildTree
+
+The node is allready linked into the tree, so
+nothing has to be waited on when the task finishes
+================
+*/
+void QueueBuildTree(node_t *node, bspbrush_t *brushes)
+{
+  bsptask_t *task;
+
+  task = malloc(sizeof(*task));
+  task->node = node;
+  task->brushes = brushes;
+  ThreadQueueTask(BuildTree_Task, task);
+}
+
 /*
 ================
 BuildTree_r
@@ -1110,8 +1168,7 @@ node_t *BuildTree_r(node_t *node, bspbrush_t *brushes)
   int i;
   bspbrush_t *children[2];
 
-  if (numthreads == 1)
-    c_nodes++;
+  c_threadnodes++;
 
   if (drawflag)
     DrawBrushList(brushes, node);
@@ -1142,8 +1199,13 @@ node_t *BuildTree_r(node_t *node, bspbrush_t *brushes)
 
   SplitBrush(node->volume, node->planenum, &node->children[0]->volume, &node->children[1]->volume);
 
-  // recursively process children
+  // recursively process children, the front side goes
+  // to another thread if it is worth the handoff
   for (i = 0; i < 2; i++) {
+    if (i == 0 && bsptasks && CountBrushList(children[i]) >= TASK_BRUSHES) {
+      QueueBuildTree(node->children[i], children[i]);
+      continue;
+    }
     node->children[i] = BuildTree_r(node->children[i], children[i]);
   }
 
@@ -1213,7 +1275,16 @@ tree_t *BrushBSP(bspbrush_t *brushlist, vec3_t mins, vec3_t maxs)
 
   tree->headnode = node;
 
-  node = BuildTree_r(node, brushlist);
+  // drawing the brush lists isn't thread safe
+  bsptasks = numthreads > 1 && !drawflag;
+  if (bsptasks) {
+    QueueBuildTree(node, brushlist);
+    RunThreadsOnTasks(false);
+    bsptasks = false;
+  } else {
+    node = BuildTree_r(node, brushlist);
+    AddNodeCounts();
+  }
   qprintf("%5i visible nodes\n", c_nodes / 2 - c_nonvis);
   qprintf("%5i nonvis nodes\n", c_nonvis);
   qprintf("%5i leafs\n", (c_nodes + 1) / 2);
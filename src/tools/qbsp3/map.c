@@ -236,16 +236,25 @@ int FindFloatPlane(vec3_t normal, vec_t dist)
   hash = (int) fabs(dist) / 8;
   hash &= (PLANE_HASHES - 1);
 
+  // the lookup and the insert must be atomic, or two threads
+  // could both create the same plane
+  ThreadLock();
+
   // search the border bins as well
   for (i = -1; i <= 1; i++) {
     h = (hash + i) & (PLANE_HASHES - 1);
     for (p = planehash[h]; p; p = p->hash_chain) {
-      if (PlaneEqual(p, normal, dist))
+      if (PlaneEqual(p, normal, dist)) {
+        ThreadUnlock();
         return p - mapplanes;
+      }
     }
   }
 
-  return CreateNewFloatPlane(normal, dist);
+  i = CreateNewFloatPlane(normal, dist);
+  ThreadUnlock();
+
+  return i;
 }
 
 #endif
@@ -24,6 +24,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "mathlib.h"
 #include "scriplib.h"
 #include "polylib.h"
+#include "poollib.h"
 #include "threads.h"
 #include "bspfile.h"
 
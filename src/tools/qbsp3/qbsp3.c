@@ -53,6 +53,60 @@ int entity_num;
 
 node_t *block_nodes[10][10];
 
+// wall time spent in each stage, summarized when running with -threads
+typedef enum
+{
+  PHASE_LOAD,
+  PHASE_CSG,
+  PHASE_BSP,
+  PHASE_PORTALS,
+  PHASE_FLOOD,
+  PHASE_FACES,
+  PHASE_WRITE,
+  NUM_PHASES
+} phase_t;
+
+char *phase_names[NUM_PHASES] = {"load", "csg", "bsp", "portals", "flood", "faces", "write"};
+double phase_times[NUM_PHASES];
+
+/*
+============
+EndPhase
+
+Charges the time since start to the phase and returns
+the current time, so phases can be chained
+============
+*/
+double EndPhase(phase_t phase, double start)
+{
+  double now;
+
+  now = I_FloatTime();
+  phase_times[phase] += now - start;
+
+  return now;
+}
+
+/*
+============
+PrintPhaseTimes
+============
+*/
+void PrintPhaseTimes(void)
+{
+  int i;
+  double total;
+
+  total = 0;
+  for (i = 0; i < NUM_PHASES; i++)
+    total += phase_times[i];
+
+  printf("---- %i threads ----\n", numthreads);
+  for (i = 0; i < NUM_PHASES; i++)
+    printf("%-8s %8.2f seconds %5.1f%%\n", phase_names[i], phase_times[i],
+           total > 0 ? 100 * phase_times[i] / total : 0);
+}
+
 /*
 ============
 BlockTree
@@ -118,6 +172,7 @@ void ProcessBlock_Thread(int blocknum)
   bspbrush_t *brushes;
   tree_t *tree;
   node_t *node;
+  double t;
 
   yblock = block_yl + blocknum / (block_xh - block_xl + 1);
   xblock = block_xl + blocknum % (block_xh - block_xl + 1);
@@ -132,19 +187,23 @@ void ProcessBlock_Thread(int blocknum)
   maxs[2] = 4096;
 
   // the makelist and chopbrushes could be cached between the passes...
+  t = I_FloatTime();
   brushes = MakeBspBrushList(brush_start, brush_end, mins, maxs);
   if (!brushes) {
     node = AllocNode();
     node->planenum = PLANENUM_LEAF;
     node->contents = CONTENTS_SOLID;
     block_nodes[xblock + 5][yblock + 5] = node;
+    EndPhase(PHASE_CSG, t);
     return;
   }
 
   if (!nocsg)
     brushes = ChopBrushes(brushes);
+  t = EndPhase(PHASE_CSG, t);
 
   tree = BrushBSP(brushes, mins, maxs);
+  EndPhase(PHASE_BSP, t);
 
   block_nodes[xblock + 5][yblock + 5] = tree->headnode;
 }
@@ -161,6 +220,8 @@ void ProcessWorldModel(void)
   tree_t *tree;
   qboolean leaked;
   qboolean optimize;
+  int i, numblocks;
+  double t;
 
   e = &entities[entity_num];
 
@@ -189,10 +250,18 @@ void ProcessWorldModel(void)
   if (block_yh > 3)
     block_yh = 3;
 
+  numblocks = (block_xh - block_xl + 1) * (block_yh - block_yl + 1);
+
   for (optimize = false; optimize <= true; optimize++) {
     qprintf("--------------------------------------------\n");
 
-    RunThreadsOnIndividual((block_xh - block_xl + 1) * (block_yh - block_yl + 1), !verbose, ProcessBlock_Thread);
+    // with several threads the parallelism is inside BrushBSP,
+    // so the blocks themselves are built one after another
+    if (numthreads > 1) {
+      for (i = 0; i < numblocks; i++)
+        ProcessBlock_Thread(i);
+    } else
+      RunThreadsOnIndividual(numblocks, !verbose, ProcessBlock_Thread);
 
     //
     // build the division tree
@@ -216,7 +285,9 @@ void ProcessWorldModel(void)
     //
     // perform the global operations
     //
+    t = I_FloatTime();
     MakeTreePortals(tree);
+    t = EndPhase(PHASE_PORTALS, t);
 
     if (FloodEntities(tree))
       FillOutside(tree->headnode);
@@ -231,6 +302,7 @@ void ProcessWorldModel(void)
     }
 
     MarkVisibleSides(tree, brush_start, brush_end);
+    EndPhase(PHASE_FLOOD, t);
     if (noopt || leaked)
       break;
     if (!optimize) {
@@ -238,7 +310,9 @@ void ProcessWorldModel(void)
     }
   }
 
+  t = I_FloatTime();
   FloodAreas(tree);
+  t = EndPhase(PHASE_FLOOD, t);
   if (glview)
     WriteGLView(tree, source);
   MakeFaces(tree->headnode);
@@ -246,6 +320,7 @@ void ProcessWorldModel(void)
 
   if (!noprune)
     PruneNodes(tree->headnode);
+  t = EndPhase(PHASE_FACES, t);
 
   WriteBSP(tree->headnode);
 
@@ -253,6 +328,7 @@ void ProcessWorldModel(void)
     WritePortalFile(tree);
 
   FreeTree(tree);
+  EndPhase(PHASE_WRITE, t);
 }
 
 /*
@@ -268,6 +344,7 @@ void ProcessSubModel(void)
   tree_t *tree;
   bspbrush_t *list;
   vec3_t mins, maxs;
+  double t;
 
   e = &entities[entity_num];
 
@@ -276,16 +353,23 @@ void ProcessSubModel(void)
 
   mins[0] = mins[1] = mins[2] = -4096;
   maxs[0] = maxs[1] = maxs[2] = 4096;
+  t = I_FloatTime();
   list = MakeBspBrushList(start, end, mins, maxs);
   if (!nocsg)
     list = ChopBrushes(list);
+  t = EndPhase(PHASE_CSG, t);
   tree = BrushBSP(list, mins, maxs);
+  t = EndPhase(PHASE_BSP, t);
   MakeTreePortals(tree);
+  t = EndPhase(PHASE_PORTALS, t);
   MarkVisibleSides(tree, start, end);
+  t = EndPhase(PHASE_FLOOD, t);
   MakeFaces(tree->headnode);
   FixTjuncs(tree->headnode);
+  t = EndPhase(PHASE_FACES, t);
   WriteBSP(tree->headnode);
   FreeTree(tree);
+  EndPhase(PHASE_WRITE, t);
 }
 
 /*
@@ -419,8 +503,11 @@ int main(int argc, char **argv)
 
   start = I_FloatTime();
 
+  // block level threads aren't helping, so only the bsp
+  // recursion is spread out, and only when asked for
+  if (numthreads == -1)
+    numthreads = 1;
   ThreadSetDefault();
-  numthreads = 1; // multiple threads aren't helping...
   SetQdirFromPath(argv[i]);
 
   strcpy(source, ExpandArg(argv[i]));
@@ -459,11 +546,15 @@ int main(int argc, char **argv)
     LoadMapFile(name);
     SetModelNumbers();
     SetLightStyles();
+    EndPhase(PHASE_LOAD, start);
 
     ProcessModels();
   }
 
   end = I_FloatTime();
+  PoolPrintStats();
+  if (numthreads > 1)
+    PrintPhaseTimes();
   printf("%5.0f seconds elapsed\n", end - start);
 
   return 0;
@@ -174,6 +174,25 @@ COLORMAP GRABBING
 =============================================================================
 */
 
+// BestColor is called with a handful of different ranges,
+// each gets a search tree built from colormap_palette
+#define MAX_BESTCOLOR_RANGES 4
+
+quantizer_t bestcolor_quant[MAX_BESTCOLOR_RANGES];
+int num_bestcolor_quant;
+
+/*
+===============
+ResetBestColor
+
+Call after colormap_palette changes
+===============
+*/
+void ResetBestColor(void)
+{
+  num_bestcolor_quant = 0;
+}
+
 /*
 ===============
 BestColor
@@ -182,34 +201,25 @@ BestColor
 byte BestColor(int r, int g, int b, int start, int stop)
 {
   int i;
-  int dr, dg, db;
-  int bestdistortion, distortion;
-  int bestcolor;
-  byte *pal;
+  quantizer_t *q;
+
+  for (i = 0, q = bestcolor_quant; i < num_bestcolor_quant; i++, q++)
+    if (q->start == start && q->stop == stop)
+      return NearestColor(q, r, g, b);
+
+  if (num_bestcolor_quant == MAX_BESTCOLOR_RANGES)
+    num_bestcolor_quant = 0;
+  q = &bestcolor_quant[num_bestcolor_quant++];
+
+  InitQuantizer(q, colormap_palette, start, stop, QUANT_DIST2);
 
   //
   // let any color go to 0 as a last resort
   //
-  bestdistortion = 256 * 256 * 4;
-  bestcolor = 0;
-
-  pal = colormap_palette + start * 3;
-  for (i = start; i <= stop; i++) {
-    dr = r - (int) pal[0];
-    dg = g - (int) pal[1];
-    db = b - (int) pal[2];
-    pal += 3;
-    distortion = dr * dr + dg * dg + db * db;
-    if (distortion < bestdistortion) {
-      if (!distortion)
-        return i; // perfect match
-
-      bestdistortion = distortion;
-      bestcolor = i;
-    }
-  }
+  q->cutoff = 256 * 256 * 4;
+  q->fallback = 0;
 
-  return bestcolor;
+  return NearestColor(q, r, g, b);
 }
 
 /*
@@ -235,8 +245,10 @@ void Cmd_Colormap(void)
   char dest[1024];
 
   colormap_issued = true;
-  if (!g_release)
+  if (!g_release) {
     memcpy(colormap_palette, lbmpalette, 768);
+    ResetBestColor();
+  }
 
   if (!TokenAvailable()) { // just setting colormap_issued
     return;
@@ -634,6 +646,7 @@ void Cmd_Mippal(void)
     return;
 
   memcpy(colormap_palette, lbmpalette, 768);
+  ResetBestColor();
 
   BuildPalmap();
 }
@@ -34,6 +34,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "trilib.h"
 #include "lbmlib.h"
 #include "threads.h"
+#include "quantlib.h"
 #include "l3dslib.h"
 #include "bspfile.h"
 
@@ -71,59 +71,111 @@ static int FindNearestColor( unsigned int color )
 }
 */
 
-extern byte BestColor(int, int, int, int, int);
+extern byte colormap_palette[768];
 
-void Inverse16_BuildTable(void)
+quantizer_t inverse16_quant;
+
+void Inverse16_Thread(int i)
 {
-  int i;
+  int r = i & 31;
+  int g = (i >> 5) & 63;
+  int b = (i >> 11) & 31;
+
+  r <<= 3;
+  g <<= 2;
+  b <<= 3;
+
+  inverse16to8table[i] = NearestColor(&inverse16_quant, r, g, b);
+}
 
+void Inverse16_BuildTable(void)
+{
   /*
-  ** create the 16-to-8 table
+  ** create the 16-to-8 table, with the same search BestColor does
   */
-  for (i = 0; i < 65536; i++) {
-    int r = i & 31;
-    int g = (i >> 5) & 63;
-    int b = (i >> 11) & 31;
+  InitQuantizer(&inverse16_quant, colormap_palette, 0, 255, QUANT_DIST2);
+  inverse16_quant.cutoff = 256 * 256 * 4;
+  inverse16_quant.fallback = 0;
 
-    r <<= 3;
-    g <<= 2;
-    b <<= 3;
+  RunThreadsOnIndividual(65536, false, Inverse16_Thread);
+}
 
-    inverse16to8table[i] = BestColor(r, g, b, 0, 255);
+/*
+alphalight_terms[c][m][a] is the squared error of one channel
+at value c, for modulate value m and alpha a. Calculated exactly
+like the full search used to, so the table comes out the same.
+*/
+float alphalight_terms[32][16][16];
+
+void Alphalight_BuildTerms(void)
+{
+  int c, m, a;
+  float r, mr, ma;
+  float v;
+
+  for (c = 0; c < 32; c++) {
+    r = c * (1.0 / 16);
+    for (m = 0; m < 16; m++) {
+      mr = m * (1.0 / 16);
+      for (a = 0; a < 16; a++) {
+        ma = a * (1.0 / 16);
+        v = r * 0.5 - (mr * ma + 0.5 * (1.0 - ma));
+        alphalight_terms[c][m][a] = v * v;
+      }
+    }
   }
 }
 
 void Alphalight_Thread(int i)
 {
-  int j;
-  float r, g, b;
-  float mr, mg, mb, ma;
+  int j, mr, mg, mb, a;
+  float *tr, *tg, *tb;
   float distortion, bestdistortion;
-  float v;
+  float low, d;
 
-  r = (i >> 10) * (1.0 / 16);
-  g = ((i >> 5) & 31) * (1.0 / 16);
-  b = (i & 31) * (1.0 / 16);
+  tr = alphalight_terms[i >> 10][0];
+  tg = alphalight_terms[(i >> 5) & 31][0];
+  tb = alphalight_terms[i & 31][0];
 
+  // walks j = mr<<12 | mg<<8 | mb<<4 | a in the same increasing order as
+  // the old exhaustive loop. The alpha weight is never below 1 and every
+  // term is positive, so a partial sum that can't beat the best so far
+  // rules out the rest of its subtree.
   bestdistortion = 999999;
-  for (j = 0; j < 16 * 16 * 16 * 16; j++) {
-    mr = (j >> 12) * (1.0 / 16);
-    mg = ((j >> 8) & 15) * (1.0 / 16);
-    mb = ((j >> 4) & 15) * (1.0 / 16);
-    ma = (j & 15) * (1.0 / 16);
-
-    v = r * 0.5 - (mr * ma + 0.5 * (1.0 - ma));
-    distortion = v * v;
-    v = g * 0.5 - (mg * ma + 0.5 * (1.0 - ma));
-    distortion += v * v;
-    v = b * 0.5 - (mb * ma + 0.5 * (1.0 - ma));
-    distortion += v * v;
-
-    distortion *= 1.0 + ma * 4;
-
-    if (distortion < bestdistortion) {
-      bestdistortion = distortion;
-      alphamap[i] = j;
+  for (mr = 0; mr < 16; mr++) {
+    low = bestdistortion;
+    for (a = 0; a < 16; a++)
+      if (tr[mr * 16 + a] < low)
+        low = tr[mr * 16 + a];
+    if (low >= bestdistortion)
+      continue;
+
+    for (mg = 0; mg < 16; mg++) {
+      low = bestdistortion;
+      for (a = 0; a < 16; a++) {
+        d = tr[mr * 16 + a];
+        d += tg[mg * 16 + a];
+        if (d < low)
+          low = d;
+      }
+      if (low >= bestdistortion)
+        continue;
+
+      for (mb = 0; mb < 16; mb++) {
+        for (a = 0; a < 16; a++) {
+          distortion = tr[mr * 16 + a];
+          distortion += tg[mg * 16 + a];
+          distortion += tb[mb * 16 + a];
+
+          distortion *= 1.0 + (a * (1.0 / 16)) * 4;
+
+          if (distortion < bestdistortion) {
+            j = (mr << 12) | (mg << 8) | (mb << 4) | a;
+            bestdistortion = distortion;
+            alphamap[i] = j;
+          }
+        }
+      }
     }
   }
 }
@@ -142,6 +194,7 @@ void Cmd_Alphalight(void)
   sprintf(savename, "%s%s", gamedir, token);
   printf("Building alphalight table...\n");
 
+  Alphalight_BuildTerms();
   RunThreadsOnIndividual(32 * 32 * 32, true, Alphalight_Thread);
 
   SaveFile(savename, (byte *) alphamap, sizeof(alphamap));
@@ -637,6 +637,7 @@ int main(int argc, char **argv)
   WriteBSPFile(name);
 
   end = I_FloatTime();
+  PoolPrintStats();
   printf("%5.0f seconds elapsed\n", end - start);
 
   return 0;
@@ -22,8 +22,11 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "vis.h"
 #include "threads.h"
+#include "poollib.h"
 #include "stdlib.h"
 
+pool_t viswindingpool = {"windings", POOL_VISWINDINGS, myoffsetof(winding_t, points), sizeof(vec3_t)};
+
 int numportals;
 int portalclusters;
 
@@ -75,17 +78,10 @@ NewWinding
 */
 winding_t *NewWinding(int points)
 {
-  winding_t *w;
-  int size;
-
   if (points > MAX_POINTS_ON_WINDING)
     Error("NewWinding: %i points", points);
 
-  size = (int) ((winding_t *) 0)->points[points];
-  w = malloc(size);
-  memset(w, 0, size);
-
-  return w;
+  return PoolAlloc(&viswindingpool, points);
 }
 
 void prl(leaf_t *l)
@@ -560,6 +556,7 @@ int main(int argc, char **argv)
   WriteBSPFile(name);
 
   end = I_FloatTime();
+  PoolPrintStats();
   printf("%5.1f seconds elapsed\n", end - start);
 
   return 0;